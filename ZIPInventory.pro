@@ -8,23 +8,37 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(database.pri)
+
 SOURCES += \
     QrCodeGenerator.cpp \
     main.cpp \
     mainwindow.cpp \
-    database.cpp \
+    inventorytablemodel.cpp \
+    inventorysearch.cpp \
+    materialtreemodel.cpp \
+    statusitemdelegate.cpp \
     dashboardwidget.cpp \
     labelprintdialog.cpp \
     advancedfilterdialog.cpp \
+    masseditdialog.cpp \
+    writeoffhistorydialog.cpp \
+    writeoffhistorymodel.cpp \
     qrcodegen.cpp
 
 HEADERS += \
     QrCodeGenerator.h \
     mainwindow.h \
-    database.h \
+    inventorytablemodel.h \
+    inventorysearch.h \
+    materialtreemodel.h \
+    statusitemdelegate.h \
     dashboardwidget.h \
     labelprintdialog.h \
     advancedfilterdialog.h \
+    masseditdialog.h \
+    writeoffhistorydialog.h \
+    writeoffhistorymodel.h \
     qrcodegen.h
 
 FORMS += \
@@ -29,7 +29,7 @@ AdvancedFilterDialog::AdvancedFilterDialog(QWidget *parent)
 void AdvancedFilterDialog::setupUI()
 {
     setWindowTitle("Расширенный фильтр");
-    setFixedSize(500, 400);
+    setFixedSize(500, 480);
 
     QVBoxLayout *mainLayout = new QVBoxLayout(this);
 
@@ -58,6 +58,24 @@ void AdvancedFilterDialog::setupUI()
     modelCombo->addItem("Все модели", "");
     mainLayout_grid->addWidget(modelCombo, 2, 1);
 
+    // Поиск по фрагменту номера (от 3 символов работает через индекс)
+    mainLayout_grid->addWidget(new QLabel("Part Number:"), 3, 0);
+    partNumberEdit = new QLineEdit(this);
+    partNumberEdit->setPlaceholderText("Часть номера");
+    mainLayout_grid->addWidget(partNumberEdit, 3, 1);
+
+    mainLayout_grid->addWidget(new QLabel("Серийный номер:"), 4, 0);
+    serialNumberEdit = new QLineEdit(this);
+    serialNumberEdit->setPlaceholderText("Часть номера");
+    mainLayout_grid->addWidget(serialNumberEdit, 4, 1);
+
+    mainLayout_grid->addWidget(new QLabel("Статус:"), 5, 0);
+    statusCombo = new QComboBox(this);
+    statusCombo->addItem("Все позиции", "all");
+    statusCombo->addItem("✅ В наличии", "available");
+    statusCombo->addItem("❌ Списано", "written_off");
+    mainLayout_grid->addWidget(statusCombo, 5, 1);
+
     mainLayout->addWidget(mainGroup);
 
     // Диапазон дат
@@ -0,0 +1,324 @@
+#include "asyncdatabase.h"
+#include <QDebug>
+
+AsyncDatabase::AsyncDatabase(QObject *parent)
+    : QObject(parent)
+    , workerThread(new QThread(this))
+    , worker(new Database("zip_worker_connection"))
+    , readerPool(new QThreadPool(this))
+{
+    // Объект базы живет в рабочем потоке и удаляется там же
+    worker->moveToThread(workerThread);
+    connect(workerThread, &QThread::finished, worker, &QObject::deleteLater);
+
+    // Соединения между потоками - через очередь событий
+    connect(worker, &Database::inventoryItemsAdded, this, &AsyncDatabase::inventoryItemsAdded);
+    connect(worker, &Database::inventoryItemsChanged, this, &AsyncDatabase::inventoryItemsChanged);
+    connect(worker, &Database::inventoryItemsRemoved, this, &AsyncDatabase::inventoryItemsRemoved);
+    connect(worker, &Database::modelItemCountsChanged, this, &AsyncDatabase::modelItemCountsChanged);
+
+    workerThread->setObjectName("DatabaseWorker");
+    workerThread->start();
+
+    // Потоки чтения не завершаются по простою, чтобы не переоткрывать соединения
+    readerPool->setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 4));
+    readerPool->setExpiryTimeout(-1);
+}
+
+AsyncDatabase::~AsyncDatabase()
+{
+    for (auto it = pendingRequests.begin(); it != pendingRequests.end(); ++it) {
+        it.value().cancel();
+    }
+    pendingRequests.clear();
+
+    readerPool->clear();
+    readerPool->waitForDone();
+
+    workerThread->quit();
+    workerThread->wait();
+}
+
+QFuture<bool> AsyncDatabase::start()
+{
+    return run<bool>(QString(), [](Database *database) {
+        bool success = database->initDatabase();
+        if (!success) {
+            qDebug() << "Worker database connection failed to initialize";
+        }
+        return success;
+    });
+}
+
+void AsyncDatabase::cancel(const QString &requestKey)
+{
+    auto it = pendingRequests.find(requestKey);
+    if (it != pendingRequests.end()) {
+        it.value().cancel();
+        pendingRequests.erase(it);
+    }
+}
+
+QFuture<QList<QVariantMap>> AsyncDatabase::getInventoryItems(const QString &requestKey)
+{
+    return runRead<QList<QVariantMap>>(requestKey, [](Database *database) {
+        return database->getInventoryItems();
+    });
+}
+
+QFuture<QList<QVariantMap>> AsyncDatabase::searchInventory(const QString &searchText, const QString &requestKey)
+{
+    return runRead<QList<QVariantMap>>(requestKey, [searchText](Database *database) {
+        return database->searchInventory(searchText);
+    });
+}
+
+QFuture<QList<QVariantMap>> AsyncDatabase::getFilteredInventory(const Database::InventoryFilter &filter,
+                                                                const QString &requestKey)
+{
+    return runRead<QList<QVariantMap>>(requestKey, [filter](Database *database) {
+        return database->getFilteredInventory(filter.materialType, filter.manufacturer, filter.model,
+                                              filter.partNumber, filter.serialNumber, filter.status,
+                                              filter.dateFrom, filter.dateTo);
+    });
+}
+
+QFuture<Database::InventoryPage> AsyncDatabase::getInventoryPage(const QString &cursor, int limit,
+                                                                 const Database::InventoryFilter &filter,
+                                                                 const QString &requestKey)
+{
+    return runRead<Database::InventoryPage>(requestKey, [cursor, limit, filter](Database *database) {
+        return database->getInventoryPage(cursor, limit, filter);
+    });
+}
+
+QFuture<QVariantMap> AsyncDatabase::getInventoryItemById(int itemId, const QString &requestKey)
+{
+    return runRead<QVariantMap>(requestKey, [itemId](Database *database) {
+        return database->getInventoryItemById(itemId);
+    });
+}
+
+QFuture<Database::InventoryRefresh> AsyncDatabase::getInventoryItemsByIds(const QList<int> &itemIds,
+                                                                         const Database::InventoryFilter &filter,
+                                                                         const QString &requestKey)
+{
+    return runRead<Database::InventoryRefresh>(requestKey, [itemIds, filter](Database *database) {
+        return database->getInventoryItemsByIds(itemIds, filter);
+    });
+}
+
+QFuture<QList<QVariantMap>> AsyncDatabase::getWriteOffHistory(int itemId, const QString &requestKey)
+{
+    return runRead<QList<QVariantMap>>(requestKey, [itemId](Database *database) {
+        return database->getWriteOffHistory(itemId);
+    });
+}
+
+QFuture<Database::WriteOffPage> AsyncDatabase::getWriteOffHistoryPage(const QString &cursor, int limit,
+                                                                      const Database::WriteOffFilter &filter,
+                                                                      const QString &requestKey)
+{
+    return runRead<Database::WriteOffPage>(requestKey, [cursor, limit, filter](Database *database) {
+        return database->getWriteOffHistoryPage(cursor, limit, filter);
+    });
+}
+
+QFuture<int> AsyncDatabase::getWriteOffHistoryCount(const Database::WriteOffFilter &filter,
+                                                    const QString &requestKey)
+{
+    return runRead<int>(requestKey, [filter](Database *database) {
+        return database->getWriteOffHistoryCount(filter);
+    });
+}
+
+QFuture<Database::DashboardStats> AsyncDatabase::getDashboardStats(const QString &requestKey)
+{
+    return runRead<Database::DashboardStats>(requestKey, [](Database *database) {
+        return database->getDashboardStats();
+    });
+}
+
+QFuture<QList<Database::MonthlyRollup>> AsyncDatabase::getMonthlyRollup(const QDate &from, const QDate &to,
+                                                                        const QString &materialType,
+                                                                        const QString &requestKey)
+{
+    return runRead<QList<Database::MonthlyRollup>>(requestKey, [from, to, materialType](Database *database) {
+        return database->getMonthlyRollup(from, to, materialType);
+    });
+}
+
+QFuture<QList<Database::MaterialTreeRow>> AsyncDatabase::getMaterialTreeRows(const QString &requestKey)
+{
+    return runRead<QList<Database::MaterialTreeRow>>(requestKey, [](Database *database) {
+        return database->getMaterialTreeRows();
+    });
+}
+
+QFuture<QList<Database::MaterialTreeRow>> AsyncDatabase::getModelItemCounts(const QList<int> &modelIds,
+                                                                           const QString &requestKey)
+{
+    return runRead<QList<Database::MaterialTreeRow>>(requestKey, [modelIds](Database *database) {
+        return database->getModelItemCounts(modelIds);
+    });
+}
+
+QFuture<QList<QVariantMap>> AsyncDatabase::getItemsForLabels(const QList<int> &itemIds,
+                                                             const QString &requestKey)
+{
+    return runRead<QList<QVariantMap>>(requestKey, [itemIds](Database *database) {
+        return database->getItemsForLabels(itemIds);
+    });
+}
+
+QFuture<int> AsyncDatabase::getUsageCountForMaterialType(const QString &materialType, const QString &requestKey)
+{
+    return runRead<int>(requestKey, [materialType](Database *database) {
+        return database->getUsageCountForMaterialType(materialType);
+    });
+}
+
+QFuture<int> AsyncDatabase::getUsageCountForManufacturer(const QString &manufacturer, const QString &requestKey)
+{
+    return runRead<int>(requestKey, [manufacturer](Database *database) {
+        return database->getUsageCountForManufacturer(manufacturer);
+    });
+}
+
+QFuture<int> AsyncDatabase::getUsageCountForModel(const QString &materialType, const QString &manufacturer,
+                                                  const QString &modelName, const QString &requestKey)
+{
+    return runRead<int>(requestKey, [=](Database *database) {
+        return database->getUsageCountForModel(materialType, manufacturer, modelName);
+    });
+}
+
+QFuture<bool> AsyncDatabase::runWrite(std::function<bool(Database *)> task)
+{
+    // Записи не отменяются: каждая должна дойти до базы
+    return run<bool>(QString(), [this, task](Database *database) {
+        bool success = task(database);
+        if (success) {
+            notifyDataModified();
+        }
+        return success;
+    });
+}
+
+void AsyncDatabase::notifyDataModified()
+{
+    // Вызывается в рабочем потоке до завершения задачи: чтение, запущенное
+    // после получения результата записи, уже увидит новые справочники
+    Database::invalidateReaderDictionaries();
+    emit dataModified();
+}
+
+QFuture<bool> AsyncDatabase::addInventoryItem(const QString &materialType, const QString &manufacturer,
+                                              const QString &modelName, const QString &partNumber,
+                                              const QString &serialNumber, const QString &capacity,
+                                              const QString &interfaceType, const QString &notes,
+                                              const QDate &arrivalDate, const QString &invoiceNumber)
+{
+    return runWrite([=](Database *database) {
+        database->addMaterialType(materialType);
+        database->addManufacturer(manufacturer);
+        database->addModel(materialType, manufacturer, modelName);
+
+        return database->addInventoryItem(materialType, manufacturer, modelName, partNumber,
+                                          serialNumber, capacity, interfaceType, notes,
+                                          arrivalDate, invoiceNumber);
+    });
+}
+
+QFuture<bool> AsyncDatabase::updateInventoryItem(int itemId, const QString &materialType, const QString &manufacturer,
+                                                 const QString &modelName, const QString &partNumber,
+                                                 const QString &serialNumber, const QString &capacity,
+                                                 const QString &interfaceType, const QString &notes,
+                                                 const QDate &arrivalDate, const QString &invoiceNumber)
+{
+    return runWrite([=](Database *database) {
+        return database->updateInventoryItem(itemId, materialType, manufacturer, modelName, partNumber,
+                                             serialNumber, capacity, interfaceType, notes,
+                                             arrivalDate, invoiceNumber);
+    });
+}
+
+QFuture<bool> AsyncDatabase::deleteInventoryItem(int itemId)
+{
+    return runWrite([itemId](Database *database) {
+        return database->deleteInventoryItem(itemId);
+    });
+}
+
+QFuture<bool> AsyncDatabase::updateInventoryItems(const QList<int> &itemIds, Database::InventoryFields fields,
+                                                  const Database::InventoryRow &values)
+{
+    return runWrite([=](Database *database) {
+        return database->updateInventoryItems(itemIds, fields, values);
+    });
+}
+
+QFuture<bool> AsyncDatabase::markItemsAsWrittenOff(const QList<int> &itemIds, const QString &issuedTo,
+                                                   const QDate &issueDate, const QString &comments)
+{
+    return runWrite([=](Database *database) {
+        return database->markItemsAsWrittenOff(itemIds, issuedTo, issueDate, comments);
+    });
+}
+
+QFuture<bool> AsyncDatabase::markItemsAsAvailable(const QList<int> &itemIds)
+{
+    return runWrite([itemIds](Database *database) {
+        return database->markItemsAsAvailable(itemIds);
+    });
+}
+
+QFuture<bool> AsyncDatabase::deleteMaterialType(const QString &materialType)
+{
+    return runWrite([materialType](Database *database) {
+        return database->deleteMaterialType(materialType);
+    });
+}
+
+QFuture<bool> AsyncDatabase::deleteManufacturer(const QString &manufacturer)
+{
+    return runWrite([manufacturer](Database *database) {
+        return database->deleteManufacturer(manufacturer);
+    });
+}
+
+QFuture<bool> AsyncDatabase::deleteModel(const QString &materialType, const QString &manufacturer,
+                                         const QString &modelName)
+{
+    return runWrite([=](Database *database) {
+        return database->deleteModel(materialType, manufacturer, modelName);
+    });
+}
+
+QFuture<bool> AsyncDatabase::checkInventoryStats()
+{
+    return runWrite([](Database *database) {
+        return database->checkInventoryStats();
+    });
+}
+
+QFuture<bool> AsyncDatabase::applyStorageProfile(Database::StorageProfile profile)
+{
+    // Данные не меняются, поэтому без dataModified
+    Database::setReaderStorageProfile(profile);
+    return run<bool>(QString(), [profile](Database *database) {
+        return database->applyStorageProfile(profile);
+    });
+}
+
+QFuture<InventoryImporter::Report> AsyncDatabase::importCsv(const QString &fileName)
+{
+    return run<InventoryImporter::Report>(QString(), [this, fileName](Database *database) {
+        InventoryImporter importer(database);
+        InventoryImporter::Report report = importer.importCsv(fileName);
+        if (report.imported > 0) {
+            notifyDataModified();
+        }
+        return report;
+    });
+}
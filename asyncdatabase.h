@@ -0,0 +1,213 @@
+#ifndef ASYNCDATABASE_H
+#define ASYNCDATABASE_H
+
+#include <QObject>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QHash>
+#include <functional>
+#include "database.h"
+#include "inventoryimporter.h"
+
+// Задача для пула потоков чтения
+class DatabaseTask : public QRunnable
+{
+public:
+    explicit DatabaseTask(std::function<void()> task) : task(task) {}
+    void run() override { task(); }
+
+private:
+    std::function<void()> task;
+};
+
+// Асинхронный доступ к базе: запись выполняется в отдельном потоке,
+// чтение - в пуле потоков, у каждого потока своё соединение (WAL).
+// Результаты возвращаются через QFuture.
+class AsyncDatabase : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AsyncDatabase(QObject *parent = nullptr);
+    ~AsyncDatabase();
+
+    // Открывает соединение рабочего потока (структура БД уже должна быть создана)
+    QFuture<bool> start();
+
+    // Отменить ожидающий запрос с указанным ключом
+    void cancel(const QString &requestKey);
+
+    // Чтение. Новый запрос с тем же ключом отменяет предыдущий, ещё не выполненный
+    QFuture<QList<QVariantMap>> getInventoryItems(const QString &requestKey = QString());
+    QFuture<QList<QVariantMap>> searchInventory(const QString &searchText,
+                                                const QString &requestKey = QString());
+    QFuture<QList<QVariantMap>> getFilteredInventory(const Database::InventoryFilter &filter,
+                                                     const QString &requestKey = QString());
+    QFuture<Database::InventoryPage> getInventoryPage(const QString &cursor, int limit,
+                                                      const Database::InventoryFilter &filter,
+                                                      const QString &requestKey = QString());
+    QFuture<QVariantMap> getInventoryItemById(int itemId, const QString &requestKey = QString());
+    QFuture<Database::InventoryRefresh> getInventoryItemsByIds(const QList<int> &itemIds,
+                                                               const Database::InventoryFilter &filter,
+                                                               const QString &requestKey = QString());
+    QFuture<QList<QVariantMap>> getWriteOffHistory(int itemId = -1,
+                                                   const QString &requestKey = QString());
+    QFuture<Database::WriteOffPage> getWriteOffHistoryPage(const QString &cursor, int limit,
+                                                           const Database::WriteOffFilter &filter,
+                                                           const QString &requestKey = QString());
+    QFuture<int> getWriteOffHistoryCount(const Database::WriteOffFilter &filter,
+                                         const QString &requestKey = QString());
+    QFuture<Database::DashboardStats> getDashboardStats(const QString &requestKey = QString());
+    QFuture<QList<Database::MonthlyRollup>> getMonthlyRollup(const QDate &from, const QDate &to,
+                                                             const QString &materialType = QString(),
+                                                             const QString &requestKey = QString());
+    QFuture<QList<Database::MaterialTreeRow>> getMaterialTreeRows(const QString &requestKey = QString());
+    QFuture<QList<Database::MaterialTreeRow>> getModelItemCounts(const QList<int> &modelIds,
+                                                                 const QString &requestKey = QString());
+    QFuture<QList<QVariantMap>> getItemsForLabels(const QList<int> &itemIds,
+                                                  const QString &requestKey = QString());
+    QFuture<int> getUsageCountForMaterialType(const QString &materialType,
+                                              const QString &requestKey = QString());
+    QFuture<int> getUsageCountForManufacturer(const QString &manufacturer,
+                                              const QString &requestKey = QString());
+    QFuture<int> getUsageCountForModel(const QString &materialType, const QString &manufacturer,
+                                       const QString &modelName, const QString &requestKey = QString());
+
+    // Запись. Все изменения идут через соединение рабочего потока - единственного
+    // писателя в файл. После успешного изменения испускается dataModified()
+
+    // Тип, производитель и модель добавляются в справочники в той же задаче
+    QFuture<bool> addInventoryItem(const QString &materialType, const QString &manufacturer,
+                                   const QString &modelName, const QString &partNumber,
+                                   const QString &serialNumber, const QString &capacity,
+                                   const QString &interfaceType, const QString &notes,
+                                   const QDate &arrivalDate, const QString &invoiceNumber);
+    QFuture<bool> updateInventoryItem(int itemId, const QString &materialType, const QString &manufacturer,
+                                      const QString &modelName, const QString &partNumber,
+                                      const QString &serialNumber, const QString &capacity,
+                                      const QString &interfaceType, const QString &notes,
+                                      const QDate &arrivalDate, const QString &invoiceNumber);
+    QFuture<bool> deleteInventoryItem(int itemId);
+    QFuture<bool> updateInventoryItems(const QList<int> &itemIds, Database::InventoryFields fields,
+                                       const Database::InventoryRow &values);
+    QFuture<bool> markItemsAsWrittenOff(const QList<int> &itemIds, const QString &issuedTo,
+                                        const QDate &issueDate, const QString &comments);
+    QFuture<bool> markItemsAsAvailable(const QList<int> &itemIds);
+
+    QFuture<bool> deleteMaterialType(const QString &materialType);
+    QFuture<bool> deleteManufacturer(const QString &manufacturer);
+    QFuture<bool> deleteModel(const QString &materialType, const QString &manufacturer,
+                              const QString &modelName);
+
+    // Сверка и при необходимости пересчет счетчиков статистики
+    QFuture<bool> checkInventoryStats();
+
+    // Профиль хранилища: рабочее соединение переключается в своем потоке,
+    // соединения чтения - перед следующим запросом каждого из них
+    QFuture<bool> applyStorageProfile(Database::StorageProfile profile);
+
+    // Импорт CSV в потоке записи
+    QFuture<InventoryImporter::Report> importCsv(const QString &fileName);
+
+    // Вызвать handler в потоке receiver, когда future будет готов и не отменен
+    template <typename T, typename Handler>
+    static void watch(const QFuture<T> &future, QObject *receiver, Handler handler);
+
+signals:
+    // Данные изменены через соединение рабочего потока
+    void dataModified();
+
+    // Уведомления рабочего соединения по записям, приходят в потоке владельца
+    void inventoryItemsAdded(const QList<int> &itemIds);
+    void inventoryItemsChanged(const QList<int> &itemIds);
+    void inventoryItemsRemoved(const QList<int> &itemIds);
+    void modelItemCountsChanged(const QList<int> &modelIds);
+
+private:
+    QThread *workerThread;
+    Database *worker;       // Соединение для записи
+    QThreadPool *readerPool;
+
+    // Ожидающие запросы по ключу (используется только из потока владельца)
+    QHash<QString, QFutureInterfaceBase> pendingRequests;
+
+    template <typename T>
+    QFuture<T> run(const QString &requestKey, std::function<T(Database *)> task);
+
+    template <typename T>
+    QFuture<T> runRead(const QString &requestKey, std::function<T(Database *)> task);
+
+    QFuture<bool> runWrite(std::function<bool(Database *)> task);
+
+    // После изменений в рабочем потоке: сброс справочников соединений чтения и dataModified()
+    void notifyDataModified();
+
+    template <typename T>
+    QFutureInterface<T> registerRequest(const QString &requestKey);
+};
+
+template <typename T>
+QFutureInterface<T> AsyncDatabase::registerRequest(const QString &requestKey)
+{
+    QFutureInterface<T> promise;
+    promise.reportStarted();
+
+    if (!requestKey.isEmpty()) {
+        cancel(requestKey);
+        pendingRequests.insert(requestKey, promise);
+    }
+
+    return promise;
+}
+
+template <typename T>
+QFuture<T> AsyncDatabase::run(const QString &requestKey, std::function<T(Database *)> task)
+{
+    QFutureInterface<T> promise = registerRequest<T>(requestKey);
+
+    Database *database = worker;
+    QMetaObject::invokeMethod(worker, [database, promise, task]() mutable {
+        // Отмененный до начала выполнения запрос в базу не идет
+        if (!promise.isCanceled()) {
+            promise.reportResult(task(database));
+        }
+        promise.reportFinished();
+    }, Qt::QueuedConnection);
+
+    return promise.future();
+}
+
+template <typename T>
+QFuture<T> AsyncDatabase::runRead(const QString &requestKey, std::function<T(Database *)> task)
+{
+    QFutureInterface<T> promise = registerRequest<T>(requestKey);
+
+    readerPool->start(new DatabaseTask([promise, task]() mutable {
+        if (!promise.isCanceled()) {
+            Database *reader = Database::readerForCurrentThread();
+            promise.reportResult(reader ? task(reader) : T());
+        }
+        promise.reportFinished();
+    }));
+
+    return promise.future();
+}
+
+template <typename T, typename Handler>
+void AsyncDatabase::watch(const QFuture<T> &future, QObject *receiver, Handler handler)
+{
+    QFutureWatcher<T> *watcher = new QFutureWatcher<T>(receiver);
+    QObject::connect(watcher, &QFutureWatcherBase::finished, receiver, [watcher, handler]() {
+        if (!watcher->isCanceled() && watcher->future().resultCount() > 0) {
+            handler(watcher->result());
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
+
+#endif // ASYNCDATABASE_H
@@ -0,0 +1,7 @@
+# Замеры слоя данных, запуск: qmake benchmarks/benchmarks.pro && make, затем каждый бинарник отдельно
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    storageprofiles \
+    resultrows \
+    readerpool
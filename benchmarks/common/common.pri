@@ -0,0 +1,10 @@
+# Общее для замеров: слой данных и заполнение временной базы
+include(../../database.pri)
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/sampledata.cpp
+
+HEADERS += \
+    $$PWD/sampledata.h
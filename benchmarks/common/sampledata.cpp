@@ -0,0 +1,49 @@
+#include "sampledata.h"
+#include <QDebug>
+
+namespace {
+const int sampleModelCount = 50;
+}
+
+bool fillSampleInventory(Database &database, int rowCount)
+{
+    const QStringList types = database.getMaterialTypes();
+    const QStringList manufacturers = database.getManufacturers();
+    if (types.isEmpty() || manufacturers.isEmpty()) {
+        qDebug() << "Sample data: reference tables are empty";
+        return false;
+    }
+
+    for (int i = 0; i < sampleModelCount; ++i) {
+        database.addModel(types.at(i % types.size()), manufacturers.at(i % manufacturers.size()),
+                          QString("Model %1").arg(i));
+    }
+
+    if (!database.beginBulkInsert()) {
+        return false;
+    }
+
+    QDate firstDate = QDate::currentDate().addYears(-3);
+    for (int i = 0; i < rowCount; ++i) {
+        int modelIndex = i % sampleModelCount;
+
+        Database::InventoryRow row;
+        row.materialType = types.at(modelIndex % types.size());
+        row.manufacturer = manufacturers.at(modelIndex % manufacturers.size());
+        row.model = QString("Model %1").arg(modelIndex);
+        row.partNumber = QString("PN-%1").arg(i % 1000);
+        row.serialNumber = QString("SN-%1").arg(i, 7, 10, QChar('0'));
+        row.capacity = "1 ТБ";
+        row.interfaceType = "SATA";
+        row.arrivalDate = firstDate.addDays(i % 1000);
+
+        QString error;
+        if (!database.bulkInsertItem(row, error)) {
+            qDebug() << "Sample data: row rejected:" << error;
+            database.rollbackBulkInsert();
+            return false;
+        }
+    }
+
+    return database.commitBulkInsert();
+}
@@ -0,0 +1,10 @@
+#ifndef SAMPLEDATA_H
+#define SAMPLEDATA_H
+
+#include "database.h"
+
+// Заполнение базы для замеров: rowCount записей одной пакетной вставкой,
+// модели и даты поступления чередуются, у каждой записи свой серийный номер
+bool fillSampleInventory(Database &database, int rowCount);
+
+#endif // SAMPLEDATA_H
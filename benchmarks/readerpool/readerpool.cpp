@@ -0,0 +1,164 @@
+// Масштабирование чтения по соединениям потоков (Database::readerForCurrentThread):
+// одинаковый набор отчетных выборок в пулах разного размера. Пул из одного потока
+// соответствует одному рабочему соединению. Второй проход - те же выборки, пока
+// отдельное соединение держит транзакцию пакетной вставки.
+// Аргументы: [число записей] [число выборок]
+#include "database.h"
+#include "asyncdatabase.h"
+#include "sampledata.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <algorithm>
+
+namespace {
+const int defaultRowCount = 50000;
+const int defaultRequestCount = 64;
+const int writerRowCount = 200000;
+
+// Все выборки по очереди фильтруют по типам материала; возвращает число прочитанных строк
+qint64 runReads(int threadCount, int requestCount, const QStringList &types, qint64 &elapsedMs)
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    pool.setExpiryTimeout(-1);
+
+    QAtomicInt rowsRead;
+    auto submit = [&]() {
+        for (int i = 0; i < requestCount; ++i) {
+            Database::InventoryFilter filter;
+            filter.materialType = types.at(i % types.size());
+            pool.start(new DatabaseTask([filter, &rowsRead]() {
+                Database *reader = Database::readerForCurrentThread();
+                QList<Database::InventoryRow> rows;
+                if (reader && reader->getFilteredInventory(filter, rows)) {
+                    rowsRead.fetchAndAddRelaxed(rows.size());
+                }
+            }));
+        }
+        pool.waitForDone();
+    };
+
+    // Первый проход открывает соединения потоков и прогревает кэш страниц
+    submit();
+    rowsRead.storeRelaxed(0);
+
+    QElapsedTimer timer;
+    timer.start();
+    submit();
+    elapsedMs = qMax<qint64>(1, timer.elapsed());
+    return rowsRead.loadRelaxed();
+}
+
+// Одна длинная транзакция пакетной вставки в своем потоке и своем соединении
+class BulkWriter : public QThread
+{
+public:
+    QAtomicInt started;
+    QAtomicInt finished;
+
+protected:
+    void run() override
+    {
+        Database database("zip_reader_pool_writer");
+        if (!database.initDatabase() || !database.beginBulkInsert()) {
+            started.storeRelease(1);
+            finished.storeRelease(1);
+            return;
+        }
+
+        Database::InventoryRow row;
+        row.materialType = database.getMaterialTypes().value(0);
+        row.manufacturer = database.getManufacturers().value(0);
+        row.model = "Model 0";
+        row.arrivalDate = QDate::currentDate();
+
+        for (int i = 0; i < writerRowCount; ++i) {
+            row.serialNumber = QString("W-%1").arg(i);
+            QString error;
+            database.bulkInsertItem(row, error);
+            if (i == 1000) {
+                started.storeRelease(1);
+            }
+        }
+
+        database.commitBulkInsert();
+        finished.storeRelease(1);
+    }
+};
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList args = app.arguments();
+    int rowCount = args.size() > 1 ? args.at(1).toInt() : defaultRowCount;
+    int requestCount = args.size() > 2 ? args.at(2).toInt() : defaultRequestCount;
+    if (rowCount <= 0 || requestCount <= 0) {
+        out << "Usage: readerpool [rows] [requests]\n";
+        return 1;
+    }
+
+    // Соединения чтения открывают файл по умолчанию в текущем каталоге
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid() || !QDir::setCurrent(tempDir.path())) {
+        out << "Cannot create temporary directory\n";
+        return 1;
+    }
+
+    QStringList types;
+    {
+        Database database("zip_reader_pool_setup");
+        if (!database.initDatabase() || !fillSampleInventory(database, rowCount)) {
+            out << "Cannot prepare sample database\n";
+            return 1;
+        }
+        types = database.getMaterialTypes();
+    }
+
+    QList<int> threadCounts = {1, 2, 4, QThread::idealThreadCount()};
+    std::sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+    out << QString("%1 rows, %2 filtered reads per run\n").arg(rowCount).arg(requestCount);
+    qint64 singleThreadMs = 0;
+    for (int threads : threadCounts) {
+        qint64 elapsedMs = 0;
+        qint64 rows = runReads(threads, requestCount, types, elapsedMs);
+        if (threads == 1) {
+            singleThreadMs = elapsedMs;
+        }
+        out << QString("%1 thread(s): %2 ms, %3 rows, x%4\n")
+               .arg(threads, 2)
+               .arg(elapsedMs)
+               .arg(rows)
+               .arg(double(singleThreadMs) / elapsedMs, 0, 'f', 2);
+        out.flush();
+    }
+
+    // Чтение во время записи: WAL не блокирует читателей открытой транзакцией писателя
+    BulkWriter writer;
+    writer.start();
+    while (!writer.started.loadAcquire()) {
+        QThread::msleep(1);
+    }
+
+    qint64 elapsedMs = 0;
+    qint64 rows = runReads(threadCounts.last(), requestCount, types, elapsedMs);
+    bool overlapped = !writer.finished.loadAcquire();
+    writer.wait();
+
+    out << QString("%1 thread(s) during bulk insert: %2 ms, %3 rows%4\n")
+           .arg(threadCounts.last(), 2)
+           .arg(elapsedMs)
+           .arg(rows)
+           .arg(overlapped ? QString() : QString(" (writer finished early, increase rows)"));
+    return 0;
+}
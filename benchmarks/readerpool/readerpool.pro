@@ -0,0 +1,12 @@
+# Параллельное чтение через соединения потоков при разном размере пула и во время пакетной записи
+QT = core sql
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = readerpool
+
+include(../common/common.pri)
+
+SOURCES += \
+    readerpool.cpp
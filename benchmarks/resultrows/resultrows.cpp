@@ -0,0 +1,137 @@
+// Полная выборка инвентаря и истории списаний: QVariantMap на строку против
+// InventoryRow/WriteOffRecord. Время - лучшее из нескольких повторов, выделения
+// памяти считаются перехватом malloc (только glibc). Аргумент: [число записей]
+#include "database.h"
+#include "sampledata.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <atomic>
+#include <functional>
+#include <cstdlib>
+
+#if defined(__GLIBC__)
+// Qt выделяет память под строки и контейнеры через malloc, поэтому считается он,
+// а не operator new. Определение в исполняемом файле перекрывает malloc всего процесса
+extern "C" void *__libc_malloc(size_t size);
+
+namespace {
+std::atomic<long long> mallocCalls(0);
+}
+
+extern "C" void *malloc(size_t size) noexcept
+{
+    mallocCalls.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+#endif
+
+namespace {
+const int defaultRowCount = 100000;
+const int repeatCount = 5;
+
+struct Measurement {
+    qint64 bestMs = -1;
+    long long allocations = -1; // -1 - подсчет недоступен
+    int rows = 0;
+};
+
+// read возвращает число строк; в замер входит и освобождение результата
+Measurement measure(const std::function<int()> &read)
+{
+    Measurement result;
+    for (int i = 0; i < repeatCount; ++i) {
+#if defined(__GLIBC__)
+        long long before = mallocCalls.load(std::memory_order_relaxed);
+#endif
+        QElapsedTimer timer;
+        timer.start();
+        result.rows = read();
+        qint64 elapsed = timer.elapsed();
+#if defined(__GLIBC__)
+        result.allocations = mallocCalls.load(std::memory_order_relaxed) - before;
+#endif
+        if (result.bestMs < 0 || elapsed < result.bestMs) {
+            result.bestMs = elapsed;
+        }
+    }
+    return result;
+}
+
+// Отладочный вывод слоя данных не должен попадать в замер
+void discardMessage(QtMsgType, const QMessageLogContext &, const QString &)
+{
+}
+
+QString format(const QString &name, const Measurement &measurement)
+{
+    QString allocations = measurement.allocations < 0
+                        ? QString("n/a")
+                        : QString::number(measurement.allocations);
+    return QString("%1 %2 rows, %3 ms, %4 allocations\n")
+           .arg(name, -32)
+           .arg(measurement.rows)
+           .arg(measurement.bestMs)
+           .arg(allocations);
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList args = app.arguments();
+    int rowCount = args.size() > 1 ? args.at(1).toInt() : defaultRowCount;
+    if (rowCount <= 0) {
+        out << "Usage: resultrows [rows]\n";
+        return 1;
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        out << "Cannot create temporary directory\n";
+        return 1;
+    }
+
+    Database database("zip_result_rows_benchmark");
+    database.setDatabasePath(tempDir.filePath("zip_inventory.db"));
+    if (!database.initDatabase() || !fillSampleInventory(database, rowCount)) {
+        out << "Cannot prepare sample database\n";
+        return 1;
+    }
+
+    // Каждая десятая запись списана, чтобы история была сопоставимого размера
+    QList<int> writtenOff;
+    for (int id = 10; id <= rowCount; id += 10) {
+        writtenOff << id;
+    }
+    if (!database.markItemsAsWrittenOff(writtenOff, "Замер", QDate::currentDate(), QString())) {
+        out << "Cannot prepare write-off history\n";
+        return 1;
+    }
+
+    qInstallMessageHandler(discardMessage);
+
+    out << format("getInventoryItems QVariantMap", measure([&database]() {
+        QList<QVariantMap> items = database.getInventoryItems();
+        return items.size();
+    }));
+    out << format("getInventoryItems InventoryRow", measure([&database]() {
+        QList<Database::InventoryRow> rows;
+        database.getInventoryItems(rows);
+        return rows.size();
+    }));
+    out << format("getWriteOffHistory QVariantMap", measure([&database]() {
+        QList<QVariantMap> records = database.getWriteOffHistory(-1);
+        return records.size();
+    }));
+    out << format("getWriteOffHistory WriteOffRecord", measure([&database]() {
+        QList<Database::WriteOffRecord> records;
+        database.getWriteOffHistory(-1, records);
+        return records.size();
+    }));
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+# Типизированные выборки (InventoryRow, WriteOffRecord) против QVariantMap
+QT = core sql
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = resultrows
+
+include(../common/common.pri)
+
+SOURCES += \
+    resultrows.cpp
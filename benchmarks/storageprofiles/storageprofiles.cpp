@@ -0,0 +1,104 @@
+// Сравнение профилей хранилища: для каждого - новая база во временном каталоге,
+// вставки по одной записи (каждая в своей транзакции) и чтение первой страницы списка.
+// Аргументы: [число вставок] [число чтений]
+#include "database.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+namespace {
+const int defaultInsertCount = 2000;
+const int defaultPageReadCount = 200;
+const int pageSize = 200;
+
+struct ProfileResult {
+    double insertsPerSecond = 0;
+    double pagesPerSecond = 0;
+};
+
+bool measureProfile(Database::StorageProfile profile, const QString &path,
+                    int insertCount, int pageReadCount, ProfileResult &result)
+{
+    Database database("zip_storage_benchmark_" + Database::storageProfileName(profile));
+    database.setDatabasePath(path);
+
+    if (!database.initDatabase() || !database.applyStorageProfile(profile)) {
+        return false;
+    }
+
+    const QString materialType = database.getMaterialTypes().value(0);
+    const QString manufacturer = database.getManufacturers().value(0);
+    if (materialType.isEmpty() || manufacturer.isEmpty()
+        || !database.addModel(materialType, manufacturer, "Benchmark")) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < insertCount; ++i) {
+        if (!database.addInventoryItem(materialType, manufacturer, "Benchmark",
+                                       QString("PN-%1").arg(i % 100), QString("SN-%1").arg(i),
+                                       "1 ТБ", "SATA", QString(), QDate::currentDate().addDays(-(i % 365)),
+                                       QString())) {
+            return false;
+        }
+    }
+    qint64 insertMs = qMax<qint64>(1, timer.elapsed());
+
+    timer.restart();
+    for (int i = 0; i < pageReadCount; ++i) {
+        if (database.getInventoryPage(QString(), pageSize).items.isEmpty()) {
+            return false;
+        }
+    }
+    qint64 readMs = qMax<qint64>(1, timer.elapsed());
+
+    result.insertsPerSecond = insertCount * 1000.0 / insertMs;
+    result.pagesPerSecond = pageReadCount * 1000.0 / readMs;
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList args = app.arguments();
+    int insertCount = args.size() > 1 ? args.at(1).toInt() : defaultInsertCount;
+    int pageReadCount = args.size() > 2 ? args.at(2).toInt() : defaultPageReadCount;
+    if (insertCount <= 0 || pageReadCount <= 0) {
+        out << "Usage: storageprofiles [inserts] [page reads]\n";
+        return 1;
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        out << "Cannot create temporary directory\n";
+        return 1;
+    }
+
+    const QList<Database::StorageProfile> profiles = {
+        Database::DesktopSafeProfile,
+        Database::BulkLoadProfile,
+        Database::ReadMostlyProfile
+    };
+
+    out << QString("%1 inserts, %2 reads of %3 rows\n").arg(insertCount).arg(pageReadCount).arg(pageSize);
+    for (Database::StorageProfile profile : profiles) {
+        const QString name = Database::storageProfileName(profile);
+        ProfileResult result;
+        if (!measureProfile(profile, tempDir.filePath(name + ".db"), insertCount, pageReadCount, result)) {
+            out << name << ": FAILED\n";
+            return 1;
+        }
+        out << QString("%1: %2 inserts/s, %3 pages/s\n")
+               .arg(name, -14)
+               .arg(result.insertsPerSecond, 0, 'f', 0)
+               .arg(result.pagesPerSecond, 0, 'f', 1);
+        out.flush();
+    }
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+# Вставки без транзакции и чтение страниц под каждым профилем хранилища
+QT = core sql
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = storageprofiles
+
+include(../../database.pri)
+
+SOURCES += \
+    storageprofiles.cpp
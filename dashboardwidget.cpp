@@ -1,11 +1,12 @@
 #include "dashboardwidget.h"
+#include "asyncdatabase.h"
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QFont>
 #include <QFrame>
 
 DashboardWidget::DashboardWidget(QWidget *parent, Database *db)
-    : QWidget(parent), database(db)
+    : QWidget(parent), database(db), asyncDatabase(nullptr)
 {
     setupUI();
     if (database) {
@@ -19,6 +20,11 @@ void DashboardWidget::setDatabase(Database *db)
     refreshStats();
 }
 
+void DashboardWidget::setAsyncDatabase(AsyncDatabase *asyncDb)
+{
+    asyncDatabase = asyncDb;
+}
+
 
 void DashboardWidget::setupUI()
 {
@@ -138,8 +144,20 @@ void DashboardWidget::updateStats()
         return;
     }
 
-    Database::DashboardStats stats = database->getDashboardStats();
+    if (asyncDatabase) {
+        // Повторное обновление отменяет предыдущее, ещё не выполненное
+        AsyncDatabase::watch(asyncDatabase->getDashboardStats("dashboardStats"), this,
+                             [this](const Database::DashboardStats &stats) {
+            applyStats(stats);
+        });
+        return;
+    }
+
+    applyStats(database->getDashboardStats());
+}
 
+void DashboardWidget::applyStats(const Database::DashboardStats &stats)
+{
     // Обновляем карточки
     totalLabel->setText(QString::number(stats.totalItems));
     availableLabel->setText(QString::number(stats.availableItems));
@@ -174,6 +192,18 @@ void DashboardWidget::updateStats()
         details += "\n";
     }
 
+    if (!stats.monthlyActivity.isEmpty()) {
+        details += "📅 По месяцам (приход / списано / возвращено):\n";
+        for (const Database::MonthlyRollup &month : stats.monthlyActivity) {
+            details += QString("  • %1: %2 / %3 / %4\n")
+                       .arg(month.month.toString("MM.yyyy"))
+                       .arg(month.arrivals)
+                       .arg(month.writeOffs)
+                       .arg(month.returns);
+        }
+        details += "\n";
+    }
+
     if (!stats.recentActivity.isEmpty()) {
         details += "🔄 Последние действия:\n";
         for (const auto &activity : stats.recentActivity) {
@@ -182,5 +212,7 @@ void DashboardWidget::updateStats()
     }
 
     statsLabel->setText(details);
+
+    emit statsUpdated();
 }
 
@@ -7,6 +7,8 @@
 #include <QProgressBar>
 #include "database.h"
 
+class AsyncDatabase;
+
 class DashboardWidget : public QWidget
 {
     Q_OBJECT
@@ -18,10 +20,18 @@ public:
     // Добавляем метод для установки database после создания
     void setDatabase(Database *db);
 
+    // Если задано, статистика загружается в рабочем потоке
+    void setAsyncDatabase(AsyncDatabase *asyncDb);
+
     void refreshStats();
 
+signals:
+    // Карточки и детали заполнены новыми данными
+    void statsUpdated();
+
 private:
     Database *database;
+    AsyncDatabase *asyncDatabase;
     QVBoxLayout *mainLayout;
     QLabel *totalLabel;
     QLabel *availableLabel;
@@ -31,6 +41,7 @@ private:
 
     void setupUI();
     void updateStats();
+    void applyStats(const Database::DashboardStats &stats);
 };
 
 #endif // DASHBOARDWIDGET_H
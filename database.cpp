@@ -6,282 +6,1628 @@
 #include <QDir>
 #include <QDate>
 #include <QSqlRecord>
+#include <QRegularExpression>
+#include <QThreadStorage>
+#include <QAtomicInt>
+#include <QSettings>
+#include <QElapsedTimer>
+#include <QSet>
+#include <algorithm>
+
+namespace {
+// Соединения для чтения: по одному на поток, закрываются при завершении потока
+QThreadStorage<Database *> readerConnections;
+QAtomicInt readerConnectionCounter;
+// Профиль, выбранный после открытия соединений чтения; -1 - берется из настроек при открытии
+QAtomicInt readerStorageProfile(-1);
+// Версия справочников: растет после каждого изменения через рабочее соединение
+QAtomicInt readerDictionaryGeneration;
+
+// Порядок колонок общей SELECT-части запросов к inventory (см. refreshSchemaSnapshot)
+enum InventoryColumn {
+    ColId = 0,
+    ColStatus,
+    ColMaterialType,
+    ColManufacturer,
+    ColModel,
+    ColPartNumber,
+    ColSerialNumber,
+    ColCapacity,
+    ColInterfaceType,
+    ColNotes,
+    ColArrivalDate,
+    ColInvoiceNumber,
+    ColCreatedAt,
+    ColUpdatedAt
+};
+
+// Порядок колонок запроса истории списаний (см. writeOffHistorySql)
+enum WriteOffColumn {
+    WoId = 0,
+    WoInventoryId,
+    WoSerialNumber,
+    WoPartNumber,
+    WoMaterialType,
+    WoManufacturer,
+    WoModel,
+    WoIssuedTo,
+    WoIssueDate,
+    WoComments,
+    WoCreatedAt
+};
+
+// Пересборка таблицы копирует строки порциями по возрастанию id
+const int rebuildBatchSize = 10000;
+
+// Текущая структура таблицы inventory: для новой базы и для пересборки старой
+QString inventoryTableSql(const QString &tableName)
+{
+    return QString(
+        "CREATE TABLE IF NOT EXISTS %1 ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "material_type_id INTEGER NOT NULL,"
+        "manufacturer_id INTEGER NOT NULL,"
+        "model_id INTEGER NOT NULL,"
+        "part_number TEXT,"
+        "serial_number TEXT,"  // Без UNIQUE: серийного номера может не быть
+        "capacity TEXT,"
+        "interface_type TEXT,"
+        "notes TEXT,"
+        "arrival_date DATE NOT NULL,"
+        "invoice_number TEXT,"
+        "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+        "updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+        "status TEXT DEFAULT 'available',"
+        "FOREIGN KEY (material_type_id) REFERENCES material_types(id),"
+        "FOREIGN KEY (manufacturer_id) REFERENCES manufacturers(id),"
+        "FOREIGN KEY (model_id) REFERENCES models(id)"
+        ")").arg(tableName);
+}
+
+// История списаний удаляется вместе с записью ЗИП
+QString writeOffHistoryTableSql(const QString &tableName)
+{
+    return QString(
+        "CREATE TABLE IF NOT EXISTS %1 ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "inventory_id INTEGER NOT NULL,"
+        "issued_to TEXT NOT NULL,"
+        "issue_date DATE NOT NULL,"
+        "comments TEXT,"
+        "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+        "FOREIGN KEY (inventory_id) REFERENCES inventory(id) ON DELETE CASCADE"
+        ")").arg(tableName);
+}
+
+// Счетчики для статистики, посчитанные по самим таблицам inventory и write_off_history
+// (заполнение и сверка inventory_stats). Ключ всегда текстовый, как в inventory_stats
+const QString inventoryStatsSourceSql =
+    "SELECT * FROM ("
+    "SELECT 'total', '', COUNT(*) FROM inventory "
+    "UNION ALL SELECT 'status', COALESCE(status, 'available'), COUNT(*) FROM inventory GROUP BY 2 "
+    "UNION ALL SELECT 'material_type', CAST(material_type_id AS TEXT), COUNT(*) FROM inventory GROUP BY 2 "
+    "UNION ALL SELECT 'manufacturer', CAST(manufacturer_id AS TEXT), COUNT(*) FROM inventory GROUP BY 2 "
+    "UNION ALL SELECT 'write_off', '', COUNT(*) FROM write_off_history"
+    ")";
+
+// Колонки истории списаний в порядке WriteOffColumn, без условия WHERE
+const QString writeOffHistorySelectSql =
+    "SELECT "
+    "w.id, "
+    "w.inventory_id, "
+    "i.serial_number, "
+    "i.part_number, "
+    "mt.name as material_type, "
+    "man.name as manufacturer, "
+    "m.name as model, "
+    "w.issued_to, "
+    "w.issue_date, "
+    "w.comments, "
+    "w.created_at "
+    "FROM write_off_history w "
+    "JOIN inventory i ON w.inventory_id = i.id "
+    "JOIN material_types mt ON i.material_type_id = mt.id "
+    "JOIN manufacturers man ON i.manufacturer_id = man.id "
+    "JOIN models m ON i.model_id = m.id ";
+
+// Дерево материалов: модели с числом записей. Записи считаются по индексу (model_id, ...)
+const QString materialTreeSql =
+    "SELECT mt.name, man.name, m.name, COUNT(i.id) "
+    "FROM material_types mt "
+    "LEFT JOIN models m ON m.material_type_id = mt.id "
+    "LEFT JOIN manufacturers man ON man.id = m.manufacturer_id "
+    "LEFT JOIN inventory i ON i.model_id = m.id "
+    "GROUP BY mt.id, m.id "
+    "ORDER BY mt.name, man.name, m.name";
+
+// Счетчики отдельных моделей для дерева; inList - список параметров id моделей.
+// Каждая модель считается по тому же индексу, без группировки всего инвентаря
+QString modelItemCountsSql(const QString &inList)
+{
+    return "SELECT mt.name, man.name, m.name, "
+           "(SELECT COUNT(*) FROM inventory i WHERE i.model_id = m.id) "
+           "FROM models m "
+           "JOIN material_types mt ON mt.id = m.material_type_id "
+           "JOIN manufacturers man ON man.id = m.manufacturer_id "
+           "WHERE m.id IN (" + inList + ")";
+}
+
+// Счетчики для панели статистики: по строке на категорию, по убыванию количества.
+// Ключ inventory_stats текстовый, для справочников он приводится к id явно
+const QString dashboardStatsSql =
+    "SELECT s.scope, s.key, s.item_count, COALESCE(mt.name, man.name) "
+    "FROM inventory_stats s "
+    "LEFT JOIN material_types mt ON s.scope = 'material_type' AND mt.id = CAST(s.key AS INTEGER) "
+    "LEFT JOIN manufacturers man ON s.scope = 'manufacturer' AND man.id = CAST(s.key AS INTEGER) "
+    "WHERE s.item_count > 0 "
+    "ORDER BY s.item_count DESC";
+
+// Последние добавленные записи: по времени создания, при равном времени - по id.
+// Читается с конца индекса idx_inventory_created
+const QString recentActivitySql =
+    "SELECT 'Добавлено: ' || mt.name || ' ' || m.name || ' (' || i.serial_number || ')' as text, "
+    "i.created_at as date FROM inventory i "
+    "JOIN material_types mt ON i.material_type_id = mt.id "
+    "JOIN models m ON i.model_id = m.id "
+    "WHERE i.created_at IS NOT NULL "
+    "ORDER BY i.created_at DESC, i.id DESC LIMIT 5";
+
+// Пакетное списание; inList - список параметров id. Уже списанные позиции
+// пропускаются всеми тремя запросами, поэтому выборка дает ровно измененные записи
+QString writeOffCandidatesSql(const QString &inList)
+{
+    return "SELECT id FROM inventory "
+           "WHERE COALESCE(status, 'available') != 'written_off' AND id IN (" + inList + ")";
+}
+
+QString writeOffHistoryInsertSql(const QString &inList)
+{
+    return "INSERT INTO write_off_history (inventory_id, issued_to, issue_date, comments) "
+           "SELECT id, ?, ?, ? FROM inventory "
+           "WHERE COALESCE(status, 'available') != 'written_off' AND id IN (" + inList + ")";
+}
+
+QString writeOffStatusSql(const QString &inList)
+{
+    return "UPDATE inventory SET status = 'written_off', written_off_to = ?, written_off_date = ?, "
+           "write_off_id = (SELECT MAX(w.id) FROM write_off_history w WHERE w.inventory_id = inventory.id) "
+           "WHERE COALESCE(status, 'available') != 'written_off' AND id IN (" + inList + ")";
+}
+
+// Вставка при импорте. Правило дубликатов - в самом запросе: строка с занятым
+// серийным номером не вставляется (0 измененных строк), пустой номер не проверяется
+const QString bulkInsertItemSql =
+    "INSERT INTO inventory (material_type_id, manufacturer_id, model_id, "
+    "part_number, serial_number, capacity, interface_type, notes, arrival_date, invoice_number) "
+    "SELECT ?, ?, ?, ?, ?, ?, ?, ?, ?, ? "
+    "WHERE ? IS NULL OR NOT EXISTS (SELECT 1 FROM inventory WHERE serial_number = ?)";
+
+const QStringList inventoryTableColumns = {
+    "id", "material_type_id", "manufacturer_id", "model_id", "part_number",
+    "serial_number", "capacity", "interface_type", "notes", "arrival_date",
+    "invoice_number", "created_at", "updated_at", "status"
+};
+
+// Отдельные запросы к inventory. Текст общий для методов и каталога проверки планов
+const QString deleteInventoryItemSql = "DELETE FROM inventory WHERE id = ?";
+const QString inventoryItemExistsSql = "SELECT COUNT(*) FROM inventory WHERE id = ?";
+const QString serialNumberCountSql = "SELECT COUNT(*) FROM inventory WHERE serial_number = ?";
+const QString serialNumberOtherCountSql = "SELECT COUNT(*) FROM inventory WHERE serial_number = ? AND id != ?";
+const QString itemStatusValueSql = "SELECT status FROM inventory WHERE id = ?";
+const QString itemModelIdSql = "SELECT model_id FROM inventory WHERE id = ?";
+
+// Текущее списание записи: данные из самой записи, комментарий - из истории
+const QString itemStatusSql =
+    "SELECT "
+    "i.status, "
+    "COALESCE(i.written_off_to, '') as issued_to, "
+    "COALESCE(i.written_off_date, '') as issue_date, "
+    "COALESCE(w.comments, '') as comments, "
+    "COALESCE(w.created_at, '') as write_off_date "
+    "FROM inventory i "
+    "LEFT JOIN write_off_history w ON w.id = i.write_off_id "
+    "WHERE i.id = ?";
+
+// Списание одной записи: строка истории и ссылка на нее в записи
+const QString writeOffHistoryItemInsertSql =
+    "INSERT INTO write_off_history (inventory_id, issued_to, issue_date, comments) "
+    "VALUES (?, ?, ?, ?)";
+const QString writeOffItemStatusSql =
+    "UPDATE inventory SET status = 'written_off', write_off_id = ?, "
+    "written_off_to = ?, written_off_date = ? WHERE id = ?";
+
+// Общее число записей истории поддерживают триггеры; с фильтром - подсчет по условиям
+const QString writeOffTotalSql =
+    "SELECT COALESCE(SUM(item_count), 0) FROM inventory_stats WHERE scope = 'write_off' AND key = ''";
+const QString writeOffCountSql = "SELECT COUNT(*) FROM write_off_history w WHERE 1=1";
+
+// Возврат на склад; inList - список параметров id. История остается архивом.
+// Не списанные позиции пропускаются обоими запросами: выборка дает ровно измененные записи
+QString returnCandidatesSql(const QString &inList)
+{
+    return "SELECT id FROM inventory "
+           "WHERE COALESCE(status, 'available') = 'written_off' AND id IN (" + inList + ")";
+}
+
+QString returnItemsSql(const QString &inList)
+{
+    return "UPDATE inventory SET status = 'available', write_off_id = NULL, "
+           "written_off_to = NULL, written_off_date = NULL "
+           "WHERE COALESCE(status, 'available') = 'written_off' AND id IN (" + inList + ")";
+}
+
+// Массовое изменение: assignments - "колонка = ?", затем список параметров id
+QString updateInventoryItemsSql(const QStringList &assignments, const QString &inList)
+{
+    return "UPDATE inventory SET " + assignments.join(", ") + " WHERE id IN (" + inList + ")";
+}
+
+// Данные для этикеток; inList - список параметров id
+QString itemsForLabelsSql(const QString &inList)
+{
+    return "SELECT i.id, mt.name as material_type, man.name as manufacturer, "
+           "m.name as model, i.part_number, i.serial_number, i.capacity, "
+           "i.arrival_date "
+           "FROM inventory i "
+           "JOIN material_types mt ON i.material_type_id = mt.id "
+           "JOIN manufacturers man ON i.manufacturer_id = man.id "
+           "JOIN models m ON i.model_id = m.id "
+           "WHERE i.id IN (" + inList + ")";
+}
+
+// Число записей со ссылкой на строку справочника; column - material_type_id, manufacturer_id или model_id
+QString usageCountSql(const QString &column)
+{
+    return QString("SELECT COUNT(*) FROM inventory WHERE %1 = ?").arg(column);
+}
+
+// Ссылки на тип или производителя есть и в записях, и в моделях
+QString dictionaryUsedSql(const QString &column)
+{
+    return usageCountSql(column) +
+           QString(" UNION ALL SELECT COUNT(*) FROM models WHERE %1 = ?").arg(column);
+}
+
+// Подзапросы тел триггеров; value - NEW.id или NEW.inventory_id в триггере, "?" в каталоге
+QString itemsByReferenceSql(const QString &column, const QString &value)
+{
+    return QString("SELECT id FROM inventory WHERE %1 = %2").arg(column, value);
+}
+
+QString itemMaterialTypeSql(const QString &itemId)
+{
+    return QString("SELECT material_type_id FROM inventory WHERE id = %1").arg(itemId);
+}
+}
 
-Database::Database(QObject *parent) : QObject(parent)
+Database::Database(QObject *parent)
+    : QObject(parent)
+    , cacheHits(0)
+    , cacheMisses(0)
+{
+    databasePath = QDir::currentPath() + "/zip_inventory.db";
+}
+
+Database::Database(const QString &connectionName, QObject *parent)
+    : QObject(parent)
+    , connectionName(connectionName)
+    , cacheHits(0)
+    , cacheMisses(0)
 {
     databasePath = QDir::currentPath() + "/zip_inventory.db";
 }
 
 Database::~Database()
 {
+    qDebug() << "Statement cache: hits =" << cacheHits << "misses =" << cacheMisses;
+
+    // Подготовленные запросы должны быть освобождены до закрытия соединения
+    clearStatementCache();
+
     if (db.isOpen()) {
         db.close();
     }
+
+    // Именованное соединение удаляем из реестра, когда на него не осталось ссылок
+    if (!connectionName.isEmpty()) {
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connectionName);
+    }
+}
+
+QSqlQuery *Database::cachedQuery(const QString &sql)
+{
+    auto it = statementCache.constFind(sql);
+    if (it != statementCache.constEnd()) {
+        ++cacheHits;
+        QSqlQuery *query = it.value();
+        query->finish(); // Сбрасываем результат предыдущего выполнения
+        return query;
+    }
+
+    ++cacheMisses;
+
+    QSqlQuery *query = new QSqlQuery(db);
+    query->setForwardOnly(true);
+    if (!query->prepare(sql)) {
+        qDebug() << "Failed to prepare query:" << query->lastError().text();
+        qDebug() << "SQL:" << sql;
+        delete query;
+        return nullptr;
+    }
+
+    statementCache.insert(sql, query);
+    return query;
+}
+
+void Database::clearStatementCache()
+{
+    qDeleteAll(statementCache);
+    statementCache.clear();
+}
+
+Database *Database::readerForCurrentThread()
+{
+    if (!readerConnections.hasLocalData()) {
+        QString name = QString("zip_reader_%1").arg(readerConnectionCounter.fetchAndAddRelaxed(1) + 1);
+
+        Database *reader = new Database(name);
+        // Версия запоминается до загрузки: изменение во время открытия приведет к перечитыванию
+        reader->dictionaryGeneration = readerDictionaryGeneration.loadAcquire();
+        if (!reader->openReadConnection()) {
+            delete reader;
+            return nullptr;
+        }
+
+        // QThreadStorage удалит объект (и закроет соединение) при завершении потока
+        readerConnections.setLocalData(reader);
+    }
+
+    // Соединения потоков живут до их завершения, поэтому переключенный профиль
+    // применяется здесь, перед очередным чтением
+    Database *reader = readerConnections.localData();
+    int profile = readerStorageProfile.loadAcquire();
+    if (profile >= 0 && reader->currentStorageProfile != profile) {
+        reader->applyStorageProfile(static_cast<StorageProfile>(profile));
+    }
+
+    // Кэш справочников соединения чтения сам не обновляется: удаленная и созданная
+    // заново запись получила бы старый id
+    int generation = readerDictionaryGeneration.loadAcquire();
+    if (reader->dictionaryGeneration != generation) {
+        reader->dictionaryGeneration = generation;
+        reader->loadDictionaryCache();
+    }
+
+    return reader;
+}
+
+void Database::invalidateReaderDictionaries()
+{
+    readerDictionaryGeneration.fetchAndAddRelease(1);
+}
+
+void Database::setReaderStorageProfile(StorageProfile profile)
+{
+    readerStorageProfile.storeRelease(profile);
+}
+
+bool Database::openReadConnection()
+{
+    db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(databasePath);
+    db.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(busyTimeoutMs));
+
+    if (!db.open()) {
+        qDebug() << "Error opening reader connection:" << db.lastError().text();
+        return false;
+    }
+
+    configureConnection();
+
+    // Структуру создает основное соединение, здесь она только читается
+    QSqlQuery query(db);
+    query.exec("PRAGMA query_only = ON");
+
+    detectSearchIndexes();
+    refreshSchemaSnapshot();
+    loadDictionaryCache();
+
+    qDebug() << "Reader connection" << connectionName << "opened";
+    return true;
+}
+
+void Database::configureConnection()
+{
+    applyStorageProfile(configuredStorageProfile());
+}
+
+QString Database::storageProfileName(StorageProfile profile)
+{
+    switch (profile) {
+    case BulkLoadProfile:
+        return "bulk-load";
+    case ReadMostlyProfile:
+        return "read-mostly";
+    case DesktopSafeProfile:
+    default:
+        return "desktop-safe";
+    }
+}
+
+Database::StorageProfile Database::storageProfileFromName(const QString &name)
+{
+    if (name == "bulk-load") {
+        return BulkLoadProfile;
+    }
+    if (name == "read-mostly") {
+        return ReadMostlyProfile;
+    }
+    return DesktopSafeProfile;
+}
+
+Database::StorageProfile Database::configuredStorageProfile()
+{
+    QSettings settings;
+    StorageProfile profile = storageProfileFromName(settings.value("storage/profile", "desktop-safe").toString());
+
+    // bulk-load мог остаться в настройках прежних версий - постоянно он не применяется
+    if (profile == BulkLoadProfile) {
+        return DesktopSafeProfile;
+    }
+    return profile;
+}
+
+bool Database::setConfiguredStorageProfile(StorageProfile profile)
+{
+    if (profile == BulkLoadProfile) {
+        qDebug() << "Storage profile bulk-load is only used during import";
+        return false;
+    }
+
+    QSettings settings;
+    settings.setValue("storage/profile", storageProfileName(profile));
+    return true;
+}
+
+bool Database::applyStorageProfile(StorageProfile profile)
+{
+    // Сравнение профилей на одной базе: benchmarks/storageprofiles.
+    // Журнал везде WAL: выйти из него при открытых соединениях чтения нельзя,
+    // а долговечность определяет synchronous.
+    QString synchronous;
+    int cacheSizeKb;
+    qint64 mmapSize;
+
+    switch (profile) {
+    case BulkLoadProfile:
+        // Без fsync: при сбое ОС или потере питания файл базы может быть поврежден.
+        // Только на время импорта (ScopedStorageProfile), в настройках не сохраняется
+        synchronous = "OFF";
+        cacheSizeKb = 65536;
+        mmapSize = 256LL * 1024 * 1024;
+        break;
+    case ReadMostlyProfile:
+        synchronous = "NORMAL";
+        cacheSizeKb = 32768;
+        mmapSize = 256LL * 1024 * 1024;
+        break;
+    case DesktopSafeProfile:
+    default:
+        // В WAL режим NORMAL не теряет целостность, fsync только при checkpoint
+        synchronous = "NORMAL";
+        cacheSizeKb = 8192;
+        mmapSize = 64LL * 1024 * 1024;
+        break;
+    }
+
+    QSqlQuery query(db);
+    if (query.exec("PRAGMA journal_mode = WAL") && query.next()) {
+        QString mode = query.value(0).toString();
+        if (mode.compare("wal", Qt::CaseInsensitive) != 0) {
+            qDebug() << "WAL mode is not available, journal mode:" << mode;
+        }
+    }
+    query.finish();
+
+    bool success = query.exec("PRAGMA synchronous = " + synchronous)
+                && query.exec(QString("PRAGMA cache_size = -%1").arg(cacheSizeKb))
+                && query.exec(QString("PRAGMA mmap_size = %1").arg(mmapSize))
+                && query.exec("PRAGMA temp_store = MEMORY");
+    query.finish();
+
+    if (!success) {
+        qDebug() << "Failed to apply storage profile" << storageProfileName(profile)
+                 << ":" << query.lastError().text();
+        return false;
+    }
+
+    currentStorageProfile = profile;
+    qDebug() << "Storage profile" << storageProfileName(profile) << "applied to" << db.connectionName();
+    return true;
+}
+
+Database::StorageProfile Database::storageProfile() const
+{
+    return currentStorageProfile;
+}
+
+Database::ScopedStorageProfile::ScopedStorageProfile(Database *database, StorageProfile profile)
+    : database(database)
+    , previousProfile(database->storageProfile())
+{
+    database->applyStorageProfile(profile);
+}
+
+Database::ScopedStorageProfile::~ScopedStorageProfile()
+{
+    database->applyStorageProfile(previousProfile);
+}
+
+void Database::reloadDictionaryCache()
+{
+    loadDictionaryCache();
+}
+
+int Database::statementCacheHits() const
+{
+    return cacheHits;
+}
+
+int Database::statementCacheMisses() const
+{
+    return cacheMisses;
+}
+
+void Database::setDatabasePath(const QString &path)
+{
+    databasePath = path;
 }
 
 bool Database::initDatabase()
 {
+    if (!connectionName.isEmpty()) {
+        // Отдельное соединение для работы из другого потока
+        db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    } else {
     #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
         db = QSqlDatabase::addDatabase("QSQLITE");
     #else
         db = QSqlDatabase::addDatabase("QSQLITE", "zip_connection");
     #endif
+    }
 
     db.setDatabaseName(databasePath);
 
+    // Соединений к файлу может быть несколько - ждем блокировку вместо SQLITE_BUSY
+    db.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(busyTimeoutMs));
+
     if (!db.open()) {
         qDebug() << "Error opening database:" << db.lastError().text();
         return false;
     }
 
-    // Проверяем существование таблиц
-    QStringList tables = db.tables();
-    qDebug() << "Database tables:" << tables;
+    configureConnection();
 
-    // Проверяем версию базы данных или создаем таблицы
-    if (!tables.contains("inventory")) {
-        // Новая база данных
-        return createTables();
-    } else {
-        // Существующая база данных
-        qDebug() << "Using existing database, checking structure...";
+    // Структура приводится к текущей версии; для актуальной базы это одно чтение user_version.
+    // Внешние ключи включаются после миграций: при перестройке таблиц DROP
+    // не должен запускать каскадное удаление
+    bool success = runMigrations();
 
-        // Проверяем и обновляем структуру таблиц
-        return updateDatabaseStructure();
+    if (success) {
+        QSqlQuery query(db);
+        if (!query.exec("PRAGMA foreign_keys = ON")) {
+            qDebug() << "Failed to enable foreign keys:" << query.lastError().text();
+        }
     }
+
+    // Структура больше не меняется до следующего запуска - фиксируем её снимок
+    if (success) {
+        detectSearchIndexes();
+        refreshSchemaSnapshot();
+        loadDictionaryCache();
+    }
+
+    return success;
+}
+
+const QList<Database::Migration> &Database::migrations()
+{
+    // Новые шаги добавляются только в конец, номера не меняются
+    static const QList<Migration> steps = {
+        {1, "initial schema", &Database::migrateInitialSchema},
+        {2, "composite arrival_date/id index", &Database::migrateArrivalIdIndex},
+        {3, "full-text search indexes", &Database::migrateSearchIndexes},
+        {4, "dashboard counters", &Database::migrateInventoryStats},
+        {5, "monthly rollup", &Database::migrateMonthlyRollup},
+        {6, "foreign key and filter indexes", &Database::migrateLookupIndexes},
+        {7, "current write-off on inventory", &Database::migrateCurrentWriteOff},
+        {8, "write-off history paging", &Database::migrateWriteOffPaging},
+        {9, "recent activity index", &Database::migrateRecentActivityIndex}
+    };
+    return steps;
 }
 
-bool Database::updateDatabaseStructure()
+bool Database::runMigrations()
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
+    if (!query.exec("PRAGMA user_version") || !query.next()) {
+        qDebug() << "Failed to read schema version:" << query.lastError().text();
+        return false;
+    }
+    int currentVersion = query.value(0).toInt();
+    query.finish();
 
-    qDebug() << "=== Updating database structure ===";
+    const QList<Migration> &steps = migrations();
+    int latestVersion = steps.last().version;
 
-    // Проверяем наличие таблицы write_off_history
-    query.exec("SELECT name FROM sqlite_master WHERE type='table' AND name='write_off_history'");
-    if (!query.next()) {
-        qDebug() << "Creating write_off_history table...";
-        QString createWriteOffHistoryTable =
-            "CREATE TABLE IF NOT EXISTS write_off_history ("
-            "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-            "inventory_id INTEGER NOT NULL,"
-            "issued_to TEXT NOT NULL,"
-            "issue_date DATE NOT NULL,"
-            "comments TEXT,"
-            "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
-            "FOREIGN KEY (inventory_id) REFERENCES inventory(id)"
-            ")";
+    if (currentVersion == latestVersion) {
+        return true;
+    }
 
-        if (!query.exec(createWriteOffHistoryTable)) {
-            qDebug() << "Failed to create write_off_history table:" << query.lastError().text();
-        } else {
-            qDebug() << "write_off_history table created successfully";
+    if (currentVersion > latestVersion) {
+        qDebug() << "Database schema version" << currentVersion
+                 << "is newer than supported version" << latestVersion;
+        return true;
+    }
+
+    qDebug() << "Migrating database from version" << currentVersion << "to" << latestVersion;
+
+    for (const Migration &step : steps) {
+        if (step.version <= currentVersion) {
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        if (!db.transaction()) {
+            qDebug() << "Failed to start migration" << step.version << ":" << db.lastError().text();
+            return false;
         }
+
+        // Номер версии записывается в заголовок файла в той же транзакции,
+        // поэтому прерванный шаг при следующем запуске выполняется заново
+        bool success = (this->*step.apply)() &&
+                       query.exec(QString("PRAGMA user_version = %1").arg(step.version));
+
+        if (!success || !db.commit()) {
+            qDebug() << "Migration" << step.version << "(" << step.description << ") failed:"
+                     << query.lastError().text() << db.lastError().text();
+            db.rollback();
+            return false;
+        }
+
+        qDebug() << "Migration" << step.version << "(" << step.description << ") applied in"
+                 << timer.elapsed() << "ms";
+    }
+
+    return true;
+}
+
+bool Database::migrateInitialSchema()
+{
+    // Недостающие таблицы: вся структура для новой базы, история списаний для старой
+    if (!createTables()) {
+        return false;
     }
 
-    // Проверяем наличие колонки status
+    // Старые базы создавались без части колонок и с UNIQUE на серийном номере.
+    // ALTER TABLE не добавит колонку со значением CURRENT_TIMESTAMP и не снимет
+    // ограничение, поэтому такая таблица пересобирается целиком
     QStringList columns = getTableColumns("inventory");
-    if (!columns.contains("status")) {
-        qDebug() << "Adding status column to inventory...";
-        if (!query.exec("ALTER TABLE inventory ADD COLUMN status TEXT DEFAULT 'available'")) {
-            qDebug() << "Failed to add status column:" << query.lastError().text();
-
-            // Пытаемся пересоздать таблицу
-            qDebug() << "Attempting to recreate table...";
-            if (recreateTableWithStatus()) {
-                qDebug() << "Table recreated successfully with status column";
-            }
-        } else {
-            qDebug() << "Status column added successfully";
+    bool missingColumns = false;
+    for (const QString &column : inventoryTableColumns) {
+        if (!columns.contains(column)) {
+            missingColumns = true;
+            break;
         }
-    } else {
-        qDebug() << "Status column already exists";
     }
 
-    // Создаем индекс для статуса
-    query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_status ON inventory(status)");
+    if (missingColumns || hasUniqueSerialConstraint()) {
+        qDebug() << "Legacy inventory table layout:" << columns;
+        if (!rebuildInventoryTable(columns)) {
+            return false;
+        }
+    }
 
-    qDebug() << "=== Updating database structure ===";
+    // Индексы и триггер создаются после пересборки: вместе со старой таблицей удаляются и они
+    const QStringList statements = {
+        "CREATE TRIGGER IF NOT EXISTS update_inventory_timestamp "
+        "AFTER UPDATE ON inventory "
+        "BEGIN "
+        "UPDATE inventory SET updated_at = CURRENT_TIMESTAMP WHERE id = NEW.id; "
+        "END;",
+        "CREATE INDEX IF NOT EXISTS idx_inventory_serial ON inventory(serial_number)", // Обычный индекс, не UNIQUE
+        "CREATE INDEX IF NOT EXISTS idx_inventory_part_number ON inventory(part_number)",
+        "CREATE INDEX IF NOT EXISTS idx_inventory_capacity ON inventory(capacity)",
+        "CREATE INDEX IF NOT EXISTS idx_inventory_status ON inventory(status)",
+        "CREATE INDEX IF NOT EXISTS idx_models_composite ON models(material_type_id, manufacturer_id)"
+    };
+
+    QSqlQuery query(db);
+    for (const QString &sql : statements) {
+        if (!query.exec(sql)) {
+            qDebug() << "Failed to create index or trigger:" << query.lastError().text();
+            return false;
+        }
+    }
 
-    // Сначала проверим структуру таблицы inventory
-   // QStringList columns = getTableColumns("inventory");
-   // qDebug() << "Current inventory columns:" << columns;
+    return true;
+}
 
-    // Проверяем существование ограничения UNIQUE на serial_number
-    // Для этого нужно пересоздать таблицу без ограничения UNIQUE
-    query.exec("SELECT name FROM sqlite_master WHERE type='table' AND name='inventory'");
-    if (query.next()) {
-        // Получаем полный SQL создания таблицы
-        query.exec("SELECT sql FROM sqlite_master WHERE type='table' AND name='inventory'");
-        if (query.next()) {
-            QString createSql = query.value(0).toString();
-            qDebug() << "Original CREATE TABLE SQL:" << createSql;
+bool Database::migrateArrivalIdIndex()
+{
+    // Составной индекс для порядка списка и постраничной выборки заменяет
+    // одиночный индекс по дате прихода
+    QSqlQuery query(db);
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_arrival_id ON inventory(arrival_date, id)")) {
+        qDebug() << "Failed to create arrival_date/id index:" << query.lastError().text();
+        return false;
+    }
 
-            // Проверяем наличие UNIQUE в определении
-            if (createSql.contains("serial_number TEXT UNIQUE") ||
-                createSql.contains("serial_number TEXT UNIQUE NOT NULL") ||
-                createSql.contains("serial_number TEXT NOT NULL UNIQUE")) {
+    return query.exec("DROP INDEX IF EXISTS idx_inventory_arrival_date");
+}
 
-                qDebug() << "Found UNIQUE constraint on serial_number, need to recreate table...";
+bool Database::hasUniqueSerialConstraint()
+{
+    // Ограничение UNIQUE в определении колонки SQLite хранит как автоиндекс с origin = 'u'
+    QSqlQuery query(db);
+    query.exec("SELECT ii.name FROM pragma_index_list('inventory') il "
+               "JOIN pragma_index_info(il.name) ii "
+               "WHERE il.origin = 'u'");
 
-                // 1. Создаем временную таблицу с данными
-                query.exec("CREATE TABLE IF NOT EXISTS inventory_backup AS SELECT * FROM inventory");
+    while (query.next()) {
+        if (query.value(0).toString() == "serial_number") {
+            return true;
+        }
+    }
+    return false;
+}
 
-                // 2. Удаляем старую таблицу
-                query.exec("DROP TABLE inventory");
+bool Database::rebuildInventoryTable(const QStringList &oldColumns)
+{
+    // Вызывается внутри транзакции миграции: при любой ошибке откатывается
+    // вся пересборка и старая таблица остается нетронутой
+    QSqlQuery query(db);
 
-                // 3. Создаем новую таблицу без ограничения UNIQUE
-                QString newCreateSql = createSql;
-                newCreateSql.replace("serial_number TEXT UNIQUE", "serial_number TEXT");
-                newCreateSql.replace("serial_number TEXT UNIQUE NOT NULL", "serial_number TEXT");
-                newCreateSql.replace("serial_number TEXT NOT NULL UNIQUE", "serial_number TEXT");
+    if (!query.exec(inventoryTableSql("inventory_rebuild"))) {
+        qDebug() << "Failed to create inventory_rebuild:" << query.lastError().text();
+        return false;
+    }
 
-                qDebug() << "New CREATE TABLE SQL:" << newCreateSql;
+    // Переносятся колонки, которые есть в обеих таблицах; недостающие получат значения по умолчанию
+    QStringList copyColumns;
+    for (const QString &column : inventoryTableColumns) {
+        if (oldColumns.contains(column)) {
+            copyColumns.append(column);
+        }
+    }
+    QString columnList = copyColumns.join(", ");
+
+    // Порции по id: каждая вставка читает только свой диапазон по первичному ключу
+    QSqlQuery copyQuery(db);
+    copyQuery.prepare(QString("INSERT INTO inventory_rebuild (%1) "
+                              "SELECT %1 FROM inventory WHERE id > ? ORDER BY id LIMIT ?")
+                      .arg(columnList));
+
+    qint64 lastId = 0;
+    int copiedRows = 0;
+    while (true) {
+        copyQuery.bindValue(0, lastId);
+        copyQuery.bindValue(1, rebuildBatchSize);
+        if (!copyQuery.exec()) {
+            qDebug() << "Failed to copy inventory rows:" << copyQuery.lastError().text();
+            return false;
+        }
 
-                if (!query.exec(newCreateSql)) {
-                    qDebug() << "Failed to recreate table:" << query.lastError().text();
+        int batchRows = copyQuery.numRowsAffected();
+        if (batchRows <= 0) {
+            break;
+        }
+        copiedRows += batchRows;
 
-                    // Пытаемся восстановить из backup
-                    query.exec("CREATE TABLE inventory AS SELECT * FROM inventory_backup");
-                    query.exec("DROP TABLE inventory_backup");
-                    return false;
-                }
+        if (!query.exec("SELECT MAX(id) FROM inventory_rebuild") || !query.next()) {
+            qDebug() << "Failed to read rebuild progress:" << query.lastError().text();
+            return false;
+        }
+        lastId = query.value(0).toLongLong();
+        query.finish();
 
-                // 4. Восстанавливаем данные
-                query.exec("INSERT INTO inventory SELECT * FROM inventory_backup");
+        qDebug() << "Inventory rebuild: copied" << copiedRows << "rows";
+    }
 
-                // 5. Удаляем временную таблицу
-                query.exec("DROP TABLE inventory_backup");
+    query.exec("SELECT COUNT(*) FROM inventory");
+    int sourceRows = query.next() ? query.value(0).toInt() : -1;
+    query.finish();
+    if (sourceRows != copiedRows) {
+        qDebug() << "Inventory rebuild copied" << copiedRows << "of" << sourceRows << "rows";
+        return false;
+    }
 
-                qDebug() << "Table recreated successfully without UNIQUE constraint";
+    if (!query.exec("DROP TABLE inventory")) {
+        qDebug() << "Failed to drop old inventory table:" << query.lastError().text();
+        return false;
+    }
 
-                // 6. Пересоздаем индексы
-                query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_serial ON inventory(serial_number)");
-                query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_part_number ON inventory(part_number)");
-                query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_capacity ON inventory(capacity)");
-                query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_arrival_date ON inventory(arrival_date)");
+    // Триггеры справочников ссылаются на inventory, которой в этот момент нет;
+    // в режиме legacy_alter_table переименование их не проверяет
+    query.exec("PRAGMA legacy_alter_table = ON");
+    bool renamed = query.exec("ALTER TABLE inventory_rebuild RENAME TO inventory");
+    if (!renamed) {
+        qDebug() << "Failed to rename inventory_rebuild:" << query.lastError().text();
+    }
+    query.exec("PRAGMA legacy_alter_table = OFF");
 
-                // 7. Пересоздаем триггер
-                query.exec("DROP TRIGGER IF EXISTS update_inventory_timestamp");
-                query.exec("CREATE TRIGGER update_inventory_timestamp "
-                           "AFTER UPDATE ON inventory "
-                           "BEGIN "
-                           "UPDATE inventory SET updated_at = CURRENT_TIMESTAMP WHERE id = NEW.id; "
-                           "END;");
+    if (renamed) {
+        qDebug() << "Inventory table rebuilt," << copiedRows << "rows";
+    }
+    return renamed;
+}
 
-                qDebug() << "All indexes and triggers recreated";
-            } else {
-                qDebug() << "No UNIQUE constraint found on serial_number";
-            }
+bool Database::migrateSearchIndexes()
+{
+    QSqlQuery query(db);
+
+    query.exec("SELECT name FROM sqlite_master WHERE type='table' AND name='inventory_fts'");
+    bool exists = query.next();
+    query.finish();
+
+    if (!exists) {
+        qDebug() << "Creating full-text search index...";
+
+        // rowid записи индекса совпадает с inventory.id
+        if (!query.exec("CREATE VIRTUAL TABLE inventory_fts USING fts5("
+                        "serial_number, part_number, capacity, "
+                        "material_type, manufacturer, model, "
+                        "notes, invoice_number, "
+                        "tokenize = 'unicode61 remove_diacritics 2')")) {
+            // SQLite собран без FTS5 - поиск останется на LIKE
+            qDebug() << "FTS5 is not available:" << query.lastError().text();
+            return true;
+        }
+
+        if (!query.exec("INSERT INTO inventory_fts (rowid, serial_number, part_number, capacity, "
+                        "material_type, manufacturer, model, notes, invoice_number) "
+                        "SELECT i.id, i.serial_number, i.part_number, i.capacity, "
+                        "mt.name, man.name, m.name, i.notes, i.invoice_number "
+                        "FROM inventory i "
+                        "LEFT JOIN material_types mt ON i.material_type_id = mt.id "
+                        "LEFT JOIN manufacturers man ON i.manufacturer_id = man.id "
+                        "LEFT JOIN models m ON i.model_id = m.id")) {
+            qDebug() << "Failed to fill search index:" << query.lastError().text();
         }
     }
 
-    // Проверяем и добавляем отсутствующие колонки
-    columns = getTableColumns("inventory");
-    qDebug() << "Updated inventory columns:" << columns;
+    // Триггеры поддерживают индекс в актуальном состоянии
+    QString insertFtsRow =
+        "INSERT INTO inventory_fts (rowid, serial_number, part_number, capacity, "
+        "material_type, manufacturer, model, notes, invoice_number) "
+        "VALUES (NEW.id, NEW.serial_number, NEW.part_number, NEW.capacity, "
+        "(SELECT name FROM material_types WHERE id = NEW.material_type_id), "
+        "(SELECT name FROM manufacturers WHERE id = NEW.manufacturer_id), "
+        "(SELECT name FROM models WHERE id = NEW.model_id), "
+        "NEW.notes, NEW.invoice_number); ";
+
+    query.exec("CREATE TRIGGER IF NOT EXISTS inventory_fts_insert "
+               "AFTER INSERT ON inventory "
+               "BEGIN " + insertFtsRow + "END;");
+
+    // Обновление updated_at и статуса не затрагивает индекс
+    query.exec("CREATE TRIGGER IF NOT EXISTS inventory_fts_update "
+               "AFTER UPDATE OF serial_number, part_number, capacity, notes, invoice_number, "
+               "material_type_id, manufacturer_id, model_id ON inventory "
+               "BEGIN "
+               "DELETE FROM inventory_fts WHERE rowid = OLD.id; " + insertFtsRow +
+               "END;");
+
+    query.exec("CREATE TRIGGER IF NOT EXISTS inventory_fts_delete "
+               "AFTER DELETE ON inventory "
+               "BEGIN "
+               "DELETE FROM inventory_fts WHERE rowid = OLD.id; "
+               "END;");
+
+    // Переименование в справочниках переносится в индекс
+    query.exec("CREATE TRIGGER IF NOT EXISTS material_types_fts_update "
+               "AFTER UPDATE OF name ON material_types "
+               "BEGIN "
+               "UPDATE inventory_fts SET material_type = NEW.name "
+               "WHERE rowid IN (" + itemsByReferenceSql("material_type_id", "NEW.id") + "); "
+               "END;");
+
+    query.exec("CREATE TRIGGER IF NOT EXISTS manufacturers_fts_update "
+               "AFTER UPDATE OF name ON manufacturers "
+               "BEGIN "
+               "UPDATE inventory_fts SET manufacturer = NEW.name "
+               "WHERE rowid IN (" + itemsByReferenceSql("manufacturer_id", "NEW.id") + "); "
+               "END;");
+
+    query.exec("CREATE TRIGGER IF NOT EXISTS models_fts_update "
+               "AFTER UPDATE OF name ON models "
+               "BEGIN "
+               "UPDATE inventory_fts SET model = NEW.name "
+               "WHERE rowid IN (" + itemsByReferenceSql("model_id", "NEW.id") + "); "
+               "END;");
+
+    // Отдельный триграммный индекс для поиска по фрагменту серийного номера
+    // и Part Number (токенизатор trigram появился в SQLite 3.34)
+    query.exec("SELECT name FROM sqlite_master WHERE type='table' AND name='inventory_codes_fts'");
+    exists = query.next();
+    query.finish();
+
+    if (!exists) {
+        qDebug() << "Creating trigram index for serial and part numbers...";
 
-    // Добавляем created_at если отсутствует
-    if (!columns.contains("created_at")) {
-        qDebug() << "Adding created_at column to inventory...";
-        if (!query.exec("ALTER TABLE inventory ADD COLUMN created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP")) {
-            qDebug() << "Failed to add created_at:" << query.lastError().text();
+        if (!query.exec("CREATE VIRTUAL TABLE inventory_codes_fts USING fts5("
+                        "serial_number, part_number, "
+                        "tokenize = 'trigram')")) {
+            qDebug() << "Trigram tokenizer is not available:" << query.lastError().text();
+            return true;
+        }
+
+        if (!query.exec("INSERT INTO inventory_codes_fts (rowid, serial_number, part_number) "
+                        "SELECT id, serial_number, part_number FROM inventory")) {
+            qDebug() << "Failed to fill trigram index:" << query.lastError().text();
         }
     }
 
-    // Добавляем updated_at если отсутствует
-    if (!columns.contains("updated_at")) {
-        qDebug() << "Adding updated_at column to inventory...";
-        if (!query.exec("ALTER TABLE inventory ADD COLUMN updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP")) {
-            qDebug() << "Failed to add updated_at:" << query.lastError().text();
+    query.exec("CREATE TRIGGER IF NOT EXISTS inventory_codes_fts_insert "
+               "AFTER INSERT ON inventory "
+               "BEGIN "
+               "INSERT INTO inventory_codes_fts (rowid, serial_number, part_number) "
+               "VALUES (NEW.id, NEW.serial_number, NEW.part_number); "
+               "END;");
+
+    query.exec("CREATE TRIGGER IF NOT EXISTS inventory_codes_fts_update "
+               "AFTER UPDATE OF serial_number, part_number ON inventory "
+               "BEGIN "
+               "DELETE FROM inventory_codes_fts WHERE rowid = OLD.id; "
+               "INSERT INTO inventory_codes_fts (rowid, serial_number, part_number) "
+               "VALUES (NEW.id, NEW.serial_number, NEW.part_number); "
+               "END;");
+
+    query.exec("CREATE TRIGGER IF NOT EXISTS inventory_codes_fts_delete "
+               "AFTER DELETE ON inventory "
+               "BEGIN "
+               "DELETE FROM inventory_codes_fts WHERE rowid = OLD.id; "
+               "END;");
+
+    return true;
+}
+
+bool Database::migrateInventoryStats()
+{
+    QSqlQuery query(db);
+
+    // scope: total, status, material_type, manufacturer, write_off (история списаний);
+    // key - статус или id справочника
+    if (!query.exec("CREATE TABLE IF NOT EXISTS inventory_stats ("
+                    "scope TEXT NOT NULL,"
+                    "key TEXT NOT NULL,"
+                    "item_count INTEGER NOT NULL DEFAULT 0,"
+                    "PRIMARY KEY (scope, key)"
+                    ") WITHOUT ROWID")) {
+        qDebug() << "Failed to create inventory_stats:" << query.lastError().text();
+        return false;
+    }
+
+    auto increment = [](const QString &scope, const QString &key) {
+        return QString("INSERT INTO inventory_stats (scope, key, item_count) VALUES ('%1', %2, 1) "
+                       "ON CONFLICT(scope, key) DO UPDATE SET item_count = item_count + 1; ")
+               .arg(scope, key);
+    };
+    auto decrement = [](const QString &scope, const QString &key) {
+        return QString("UPDATE inventory_stats SET item_count = item_count - 1 "
+                       "WHERE scope = '%1' AND key = %2; ")
+               .arg(scope, key);
+    };
+
+    const QStringList statements = {
+        "CREATE TRIGGER IF NOT EXISTS inventory_stats_insert "
+        "AFTER INSERT ON inventory "
+        "BEGIN " +
+        increment("total", "''") +
+        increment("status", "COALESCE(NEW.status, 'available')") +
+        increment("material_type", "NEW.material_type_id") +
+        increment("manufacturer", "NEW.manufacturer_id") +
+        "END;",
+
+        // Срабатывает только при смене одного из учитываемых полей; неизменные поля
+        // получают -1 и +1, что в сумме ничего не меняет
+        "CREATE TRIGGER IF NOT EXISTS inventory_stats_update "
+        "AFTER UPDATE OF status, material_type_id, manufacturer_id ON inventory "
+        "WHEN COALESCE(OLD.status, 'available') IS NOT COALESCE(NEW.status, 'available') "
+        "OR OLD.material_type_id IS NOT NEW.material_type_id "
+        "OR OLD.manufacturer_id IS NOT NEW.manufacturer_id "
+        "BEGIN " +
+        decrement("status", "COALESCE(OLD.status, 'available')") +
+        decrement("material_type", "OLD.material_type_id") +
+        decrement("manufacturer", "OLD.manufacturer_id") +
+        increment("status", "COALESCE(NEW.status, 'available')") +
+        increment("material_type", "NEW.material_type_id") +
+        increment("manufacturer", "NEW.manufacturer_id") +
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS inventory_stats_delete "
+        "AFTER DELETE ON inventory "
+        "BEGIN " +
+        decrement("total", "''") +
+        decrement("status", "COALESCE(OLD.status, 'available')") +
+        decrement("material_type", "OLD.material_type_id") +
+        decrement("manufacturer", "OLD.manufacturer_id") +
+        "END;"
+    };
+
+    for (const QString &sql : statements) {
+        if (!query.exec(sql)) {
+            qDebug() << "Failed to create inventory_stats trigger:" << query.lastError().text();
+            return false;
         }
     }
 
-    // Проверяем наличие колонки capacity (добавлена ранее)
-    if (!columns.contains("capacity")) {
-        qDebug() << "Adding capacity column to inventory...";
-        query.exec("ALTER TABLE inventory ADD COLUMN capacity TEXT");
+    return rebuildInventoryStats();
+}
+
+bool Database::migrateMonthlyRollup()
+{
+    QSqlQuery query(db);
+
+    if (!query.exec("CREATE TABLE IF NOT EXISTS monthly_rollup ("
+                    "month TEXT NOT NULL,"               // 'yyyy-MM'
+                    "material_type_id INTEGER NOT NULL,"
+                    "arrivals INTEGER NOT NULL DEFAULT 0,"
+                    "write_offs INTEGER NOT NULL DEFAULT 0,"
+                    "returns INTEGER NOT NULL DEFAULT 0,"
+                    "PRIMARY KEY (month, material_type_id)"
+                    ") WITHOUT ROWID")) {
+        qDebug() << "Failed to create monthly_rollup:" << query.lastError().text();
+        return false;
     }
 
-    // Проверяем триггер для updated_at
-    query.exec("SELECT name FROM sqlite_master WHERE type='trigger' AND name='update_inventory_timestamp'");
-    if (!query.next()) {
-        qDebug() << "Creating update trigger...";
-        query.exec("CREATE TRIGGER update_inventory_timestamp "
-                   "AFTER UPDATE ON inventory "
-                   "BEGIN "
-                   "UPDATE inventory SET updated_at = CURRENT_TIMESTAMP WHERE id = NEW.id; "
-                   "END;");
+    // Месяц без даты (пустая строка) попадает в отдельную строку '' и не мешает вставке
+    auto month = [](const QString &date) {
+        return QString("COALESCE(strftime('%Y-%m', %1), '')").arg(date);
+    };
+    auto add = [](const QString &column, const QString &monthExpr, const QString &typeExpr, int delta) {
+        return QString("INSERT INTO monthly_rollup (month, material_type_id, %1) VALUES (%2, %3, %4) "
+                       "ON CONFLICT(month, material_type_id) DO UPDATE SET %1 = %1 + %4; ")
+               .arg(column, monthExpr, typeExpr).arg(delta);
+    };
+
+    // Приход считается по текущим записям: удаленная запись и перенесенная дата
+    // убираются из прежнего месяца. Списания и возвраты - события и не откатываются
+    const QStringList statements = {
+        "CREATE INDEX IF NOT EXISTS idx_monthly_rollup_type ON monthly_rollup(material_type_id, month)",
+
+        "CREATE TRIGGER IF NOT EXISTS monthly_rollup_arrival_insert "
+        "AFTER INSERT ON inventory "
+        "BEGIN " +
+        add("arrivals", month("NEW.arrival_date"), "NEW.material_type_id", 1) +
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS monthly_rollup_arrival_update "
+        "AFTER UPDATE OF arrival_date, material_type_id ON inventory "
+        "WHEN OLD.arrival_date IS NOT NEW.arrival_date "
+        "OR OLD.material_type_id IS NOT NEW.material_type_id "
+        "BEGIN " +
+        add("arrivals", month("OLD.arrival_date"), "OLD.material_type_id", -1) +
+        add("arrivals", month("NEW.arrival_date"), "NEW.material_type_id", 1) +
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS monthly_rollup_arrival_delete "
+        "AFTER DELETE ON inventory "
+        "BEGIN " +
+        add("arrivals", month("OLD.arrival_date"), "OLD.material_type_id", -1) +
+        "END;",
+
+        // Возврат на склад - месяц, в котором он отмечен
+        "CREATE TRIGGER IF NOT EXISTS monthly_rollup_return "
+        "AFTER UPDATE OF status ON inventory "
+        "WHEN OLD.status = 'written_off' AND NEW.status = 'available' "
+        "BEGIN " +
+        add("returns", "strftime('%Y-%m', 'now', 'localtime')", "NEW.material_type_id", 1) +
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS monthly_rollup_write_off "
+        "AFTER INSERT ON write_off_history "
+        "BEGIN " +
+        add("write_offs", month("NEW.issue_date"),
+            "COALESCE((" + itemMaterialTypeSql("NEW.inventory_id") + "), 0)", 1) +
+        "END;",
+
+        // Заполнение по уже накопленным данным; возвраты в прошлом нигде не записаны
+        "DELETE FROM monthly_rollup",
+
+        "INSERT INTO monthly_rollup (month, material_type_id, arrivals) "
+        "SELECT " + month("arrival_date") + ", material_type_id, COUNT(*) "
+        "FROM inventory GROUP BY 1, 2",
+
+        "INSERT INTO monthly_rollup (month, material_type_id, write_offs) "
+        "SELECT " + month("w.issue_date") + ", COALESCE(i.material_type_id, 0), COUNT(*) "
+        "FROM write_off_history w LEFT JOIN inventory i ON i.id = w.inventory_id "
+        "WHERE true GROUP BY 1, 2 "
+        "ON CONFLICT(month, material_type_id) DO UPDATE SET write_offs = excluded.write_offs"
+    };
+
+    for (const QString &sql : statements) {
+        if (!query.exec(sql)) {
+            qDebug() << "Failed to set up monthly_rollup:" << query.lastError().text();
+            return false;
+        }
     }
 
     return true;
 }
 
-bool Database::recreateTableWithStatus()
+bool Database::migrateLookupIndexes()
 {
-    QSqlQuery query;
+    // Индексы по ссылкам на справочники и статусу продолжаются (arrival_date, id):
+    // подсчет использования - поиск по индексу, отфильтрованный список идет уже в нужном порядке.
+    // История списаний по записи выбирается и сортируется по (inventory_id, created_at)
+    const QStringList statements = {
+        "CREATE INDEX IF NOT EXISTS idx_inventory_type_arrival ON inventory(material_type_id, arrival_date, id)",
+        "CREATE INDEX IF NOT EXISTS idx_inventory_manufacturer_arrival ON inventory(manufacturer_id, arrival_date, id)",
+        "CREATE INDEX IF NOT EXISTS idx_inventory_model_arrival ON inventory(model_id, arrival_date, id)",
+        "CREATE INDEX IF NOT EXISTS idx_inventory_status_arrival ON inventory(status, arrival_date, id)",
+        "DROP INDEX IF EXISTS idx_inventory_status",
+        "CREATE INDEX IF NOT EXISTS idx_write_off_history_item ON write_off_history(inventory_id, created_at)",
+        "CREATE INDEX IF NOT EXISTS idx_write_off_history_created ON write_off_history(created_at)"
+    };
+
+    QSqlQuery query(db);
+    for (const QString &sql : statements) {
+        if (!query.exec(sql)) {
+            qDebug() << "Failed to create index:" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
 
-    // Создаем временную таблицу
-    if (!query.exec("CREATE TABLE IF NOT EXISTS inventory_backup AS SELECT * FROM inventory")) {
-        qDebug() << "Failed to create backup table:" << query.lastError().text();
+bool Database::migrateCurrentWriteOff()
+{
+    QSqlQuery query(db);
+
+    // Индексы и триггеры истории удаляются вместе с таблицей - сохраняем их определения
+    QStringList historyObjects;
+    if (!query.exec("SELECT sql FROM sqlite_master "
+                    "WHERE tbl_name = 'write_off_history' AND type IN ('index', 'trigger') "
+                    "AND sql IS NOT NULL")) {
+        qDebug() << "Failed to read write_off_history schema:" << query.lastError().text();
         return false;
     }
+    while (query.next()) {
+        historyObjects << query.value(0).toString();
+    }
 
-    // Получаем структуру таблицы
-    query.exec("SELECT sql FROM sqlite_master WHERE type='table' AND name='inventory'");
-    if (!query.next()) {
-        qDebug() << "Failed to get table structure";
-        return false;
+    qint64 historySequence = 0;
+    if (query.exec("SELECT seq FROM sqlite_sequence WHERE name = 'write_off_history'") && query.next()) {
+        historySequence = query.value(0).toLongLong();
     }
+    query.finish();
 
-    QString createSql = query.value(0).toString();
+    // 1. История с каскадным удалением; записи удаленных позиций не переносятся
+    const QStringList rebuild = {
+        writeOffHistoryTableSql("write_off_history_rebuild"),
+        "INSERT INTO write_off_history_rebuild (id, inventory_id, issued_to, issue_date, comments, created_at) "
+        "SELECT w.id, w.inventory_id, w.issued_to, w.issue_date, w.comments, w.created_at "
+        "FROM write_off_history w WHERE EXISTS (SELECT 1 FROM inventory i WHERE i.id = w.inventory_id)",
+        "DROP TABLE write_off_history",
+        "ALTER TABLE write_off_history_rebuild RENAME TO write_off_history"
+    };
 
-    // Добавляем колонку status
-    if (!createSql.contains("status TEXT")) {
-        // Находим позицию для вставки (перед FOREIGN KEY)
-        int lastParen = createSql.lastIndexOf(")");
-        if (lastParen == -1) {
-            qDebug() << "Invalid CREATE TABLE statement";
+    for (const QString &sql : rebuild + historyObjects) {
+        if (!query.exec(sql)) {
+            qDebug() << "Failed to rebuild write_off_history:" << query.lastError().text();
             return false;
         }
+    }
 
-        QString newCreateSql = createSql.left(lastParen) +
-                              ", status TEXT DEFAULT 'available'" +
-                              createSql.mid(lastParen);
+    // Номера удаленных записей истории не выдаются повторно
+    query.prepare("UPDATE sqlite_sequence SET seq = MAX(seq, ?) WHERE name = 'write_off_history'");
+    query.addBindValue(historySequence);
+    if (!query.exec()) {
+        qDebug() << "Failed to restore write_off_history sequence:" << query.lastError().text();
+        return false;
+    }
+
+    // 2. Текущее списание хранится в самой записи: статус читается по первичному ключу
+    QString timestampTrigger;
+    if (query.exec("SELECT sql FROM sqlite_master WHERE type = 'trigger' AND name = 'update_inventory_timestamp'") &&
+        query.next()) {
+        timestampTrigger = query.value(0).toString();
+    }
+    query.finish();
+
+    QStringList statements = {
+        "ALTER TABLE inventory ADD COLUMN write_off_id INTEGER "
+        "REFERENCES write_off_history(id) ON DELETE SET NULL",
+        "ALTER TABLE inventory ADD COLUMN written_off_to TEXT",
+        "ALTER TABLE inventory ADD COLUMN written_off_date DATE",
+        // Для ON DELETE SET NULL при удалении записи истории
+        "CREATE INDEX IF NOT EXISTS idx_inventory_write_off ON inventory(write_off_id)",
 
-        // Удаляем старую таблицу
-        query.exec("DROP TABLE inventory");
+        // Заполнение не должно менять updated_at - триггер отключается на время переноса
+        "DROP TRIGGER IF EXISTS update_inventory_timestamp",
 
-        // Создаем новую таблицу
-        if (!query.exec(newCreateSql)) {
-            qDebug() << "Failed to recreate table:" << query.lastError().text();
+        "UPDATE inventory SET write_off_id = ("
+        "SELECT w.id FROM write_off_history w WHERE w.inventory_id = inventory.id "
+        "ORDER BY w.created_at DESC, w.id DESC LIMIT 1) "
+        "WHERE status = 'written_off'",
+
+        "UPDATE inventory SET "
+        "written_off_to = (SELECT issued_to FROM write_off_history WHERE id = inventory.write_off_id), "
+        "written_off_date = (SELECT issue_date FROM write_off_history WHERE id = inventory.write_off_id) "
+        "WHERE write_off_id IS NOT NULL"
+    };
+
+    if (!timestampTrigger.isEmpty()) {
+        statements << timestampTrigger;
+    }
+
+    for (const QString &sql : statements) {
+        if (!query.exec(sql)) {
+            qDebug() << "Failed to add current write-off columns:" << query.lastError().text();
             return false;
         }
+    }
 
-        // Восстанавливаем данные
-        QStringList columns = getTableColumns("inventory_backup");
-        QString insertColumns = columns.join(", ");
-        QString selectColumns = columns.join(", ");
-
-        QString insertSql = QString("INSERT INTO inventory (%1) SELECT %2 FROM inventory_backup")
-                           .arg(insertColumns)
-                           .arg(selectColumns);
+    return true;
+}
 
-        if (!query.exec(insertSql)) {
-            qDebug() << "Failed to restore data:" << query.lastError().text();
+bool Database::migrateWriteOffPaging()
+{
+    // Страницы истории идут по (issue_date, id), фильтр по получателю - по (issued_to, issue_date).
+    // Общее число записей хранится в inventory_stats (scope 'write_off')
+    const QStringList statements = {
+        "CREATE INDEX IF NOT EXISTS idx_write_off_history_issue ON write_off_history(issue_date)",
+        "CREATE INDEX IF NOT EXISTS idx_write_off_history_recipient ON write_off_history(issued_to, issue_date)",
+
+        "CREATE TRIGGER IF NOT EXISTS write_off_stats_insert "
+        "AFTER INSERT ON write_off_history "
+        "BEGIN "
+        "INSERT INTO inventory_stats (scope, key, item_count) VALUES ('write_off', '', 1) "
+        "ON CONFLICT(scope, key) DO UPDATE SET item_count = item_count + 1; "
+        "END;",
+
+        "CREATE TRIGGER IF NOT EXISTS write_off_stats_delete "
+        "AFTER DELETE ON write_off_history "
+        "BEGIN "
+        "UPDATE inventory_stats SET item_count = item_count - 1 WHERE scope = 'write_off' AND key = ''; "
+        "END;",
+
+        "INSERT INTO inventory_stats (scope, key, item_count) "
+        "SELECT 'write_off', '', COUNT(*) FROM write_off_history WHERE true "
+        "ON CONFLICT(scope, key) DO UPDATE SET item_count = excluded.item_count"
+    };
+
+    QSqlQuery query(db);
+    for (const QString &sql : statements) {
+        if (!query.exec(sql)) {
+            qDebug() << "Failed to set up write-off history paging:" << query.lastError().text();
             return false;
         }
     }
+    return true;
+}
+
+bool Database::migrateRecentActivityIndex()
+{
+    // Недавняя активность выбирается по (created_at, id) с конца индекса, без сортировки
+    QSqlQuery query(db);
+    if (!query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_created ON inventory(created_at)")) {
+        qDebug() << "Failed to create index:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool Database::rebuildInventoryStats()
+{
+    // Выполняется внутри транзакции вызывающего
+    QSqlQuery query(db);
+    if (!query.exec("DELETE FROM inventory_stats") ||
+        !query.exec("INSERT INTO inventory_stats (scope, key, item_count) " + inventoryStatsSourceSql)) {
+        qDebug() << "Failed to rebuild inventory_stats:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
 
-    // Удаляем временную таблицу
-    query.exec("DROP TABLE inventory_backup");
+bool Database::checkInventoryStats()
+{
+    // Строки с нулевым счетчиком остаются после удаления последней записи категории
+    const QString storedSql = "SELECT scope, key, item_count FROM inventory_stats WHERE item_count <> 0";
+
+    QSqlQuery query(db);
+    if (!query.exec(QString("SELECT (SELECT COUNT(*) FROM (%1 EXCEPT %2)) + "
+                            "(SELECT COUNT(*) FROM (%2 EXCEPT %1))")
+                    .arg(inventoryStatsSourceSql, storedSql)) || !query.next()) {
+        qDebug() << "Failed to check inventory_stats:" << query.lastError().text();
+        return false;
+    }
+
+    int mismatches = query.value(0).toInt();
+    query.finish();
+
+    if (mismatches == 0) {
+        qDebug() << "inventory_stats is consistent";
+        return true;
+    }
 
+    qDebug() << "inventory_stats has" << mismatches << "mismatched counters, rebuilding...";
+
+    db.transaction();
+    if (!rebuildInventoryStats() || !db.commit()) {
+        db.rollback();
+        return false;
+    }
     return true;
 }
 
+void Database::detectSearchIndexes()
+{
+    // Индексы создает миграция, если SQLite их поддерживает
+    QSqlQuery query(db);
+    query.exec("SELECT name FROM sqlite_master WHERE type='table' "
+               "AND name IN ('inventory_fts', 'inventory_codes_fts')");
+    while (query.next()) {
+        QString table = query.value(0).toString();
+        if (table == "inventory_fts") {
+            ftsAvailable = true;
+        } else {
+            trigramAvailable = true;
+        }
+    }
+}
+
+QString Database::buildFtsMatchQuery(const QString &searchText)
+{
+    // Каждое слово - префиксный поиск, слова объединяются через AND
+    QStringList terms;
+    const QStringList words = searchText.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    for (QString word : words) {
+        word.replace("\"", "\"\"");
+        terms.append("\"" + word + "\"*");
+    }
+    return terms.join(" ");
+}
+
+QString Database::buildTrigramMatchQuery(const QString &column, const QString &fragment)
+{
+    // Фрагмент ищется как подстрока целиком, при необходимости только в одной колонке
+    QString phrase = fragment;
+    phrase.replace("\"", "\"\"");
+    phrase = "\"" + phrase + "\"";
+    return column.isEmpty() ? phrase : column + " : " + phrase;
+}
+
+void Database::refreshSchemaSnapshot()
+{
+    QStringList columns = getTableColumns("inventory");
+
+    inventorySchema.hasStatus = columns.contains("status");
+    inventorySchema.hasCapacity = columns.contains("capacity");
+    inventorySchema.hasCreatedAt = columns.contains("created_at");
+    inventorySchema.hasUpdatedAt = columns.contains("updated_at");
+
+    qDebug() << "Inventory schema snapshot:"
+             << "status" << inventorySchema.hasStatus
+             << "capacity" << inventorySchema.hasCapacity
+             << "created_at" << inventorySchema.hasCreatedAt
+             << "updated_at" << inventorySchema.hasUpdatedAt;
+
+    // Запросы под старую структуру больше не годятся
+    clearStatementCache();
+
+    // Набор колонок одинаков для всех вариантов: отсутствующие в БД колонки
+    // заменяются константами, поэтому разбор результата не зависит от структуры
+    QString selectColumns = QString(
+        "SELECT "
+        "i.id, "
+        "%1 as status, "
+        "COALESCE(mt.name, 'Неизвестно') as material_type, "
+        "COALESCE(man.name, 'Неизвестно') as manufacturer, "
+        "COALESCE(m.name, 'Неизвестно') as model, "
+        "i.part_number, "
+        "i.serial_number, "
+        "%2 as capacity, "
+        "i.interface_type, "
+        "i.notes, "
+        "i.arrival_date, "
+        "i.invoice_number, "
+        "%3 as created_at, "
+        "%4 as updated_at ")
+        .arg(inventorySchema.hasStatus ? "COALESCE(i.status, 'available')" : "'available'")
+        .arg(inventorySchema.hasCapacity ? "i.capacity" : "''")
+        .arg(inventorySchema.hasCreatedAt ? "i.created_at" : "''")
+        .arg(inventorySchema.hasUpdatedAt ? "i.updated_at" : "''");
+
+    QString leftJoins =
+        "FROM inventory i "
+        "LEFT JOIN material_types mt ON i.material_type_id = mt.id "
+        "LEFT JOIN manufacturers man ON i.manufacturer_id = man.id "
+        "LEFT JOIN models m ON i.model_id = m.id ";
+
+    selectInventorySql = selectColumns + leftJoins +
+        "ORDER BY i.arrival_date DESC, i.id DESC";
+
+    inventoryColumnsSql = selectColumns;
+    inventoryJoinsSql = leftJoins;
+
+    selectInventoryByIdSql = selectColumns +
+        "FROM inventory i "
+        "JOIN models m ON i.model_id = m.id "
+        "JOIN material_types mt ON i.material_type_id = mt.id "
+        "JOIN manufacturers man ON i.manufacturer_id = man.id "
+        "WHERE i.id = ?";
+
+    if (ftsAvailable && trigramAvailable) {
+        // Совпадения по словам и по фрагменту серийного/Part Number объединяются,
+        // сначала наиболее релевантные
+        searchInventorySql = selectColumns +
+            "FROM ("
+            "SELECT id, MIN(score) AS score FROM ("
+            "SELECT rowid AS id, bm25(inventory_fts) AS score "
+            "FROM inventory_fts WHERE inventory_fts MATCH ? "
+            "UNION ALL "
+            "SELECT rowid AS id, bm25(inventory_codes_fts) AS score "
+            "FROM inventory_codes_fts WHERE inventory_codes_fts MATCH ?"
+            ") GROUP BY id"
+            ") hits "
+            "JOIN inventory i ON i.id = hits.id "
+            "LEFT JOIN material_types mt ON i.material_type_id = mt.id "
+            "LEFT JOIN manufacturers man ON i.manufacturer_id = man.id "
+            "LEFT JOIN models m ON i.model_id = m.id "
+            "ORDER BY hits.score, i.arrival_date DESC, i.id DESC";
+        searchParamCount = 2;
+    } else if (ftsAvailable) {
+        // Поиск через полнотекстовый индекс, сначала наиболее релевантные
+        searchInventorySql = selectColumns +
+            "FROM inventory_fts "
+            "JOIN inventory i ON i.id = inventory_fts.rowid "
+            "LEFT JOIN material_types mt ON i.material_type_id = mt.id "
+            "LEFT JOIN manufacturers man ON i.manufacturer_id = man.id "
+            "LEFT JOIN models m ON i.model_id = m.id "
+            "WHERE inventory_fts MATCH ? "
+            "ORDER BY bm25(inventory_fts), i.arrival_date DESC, i.id DESC";
+        searchParamCount = 1;
+    } else {
+        searchInventorySql = selectColumns + leftJoins +
+            "WHERE i.serial_number LIKE ? OR "
+            "i.part_number LIKE ? OR ";
+        searchParamCount = 7; // serial, part, mt, man, m, notes, invoice
+        if (inventorySchema.hasCapacity) {
+            searchInventorySql += "i.capacity LIKE ? OR ";
+            searchParamCount = 8;
+        }
+        searchInventorySql +=
+            "mt.name LIKE ? OR "
+            "man.name LIKE ? OR "
+            "m.name LIKE ? OR "
+            "i.notes LIKE ? OR "
+            "i.invoice_number LIKE ? "
+            "ORDER BY i.arrival_date DESC, i.id DESC";
+    }
+
+    // Серийный номер всегда передается параметром (пустой QVariant даёт NULL)
+    updateInventorySql =
+        "UPDATE inventory SET "
+        "material_type_id = ?, "
+        "manufacturer_id = ?, "
+        "model_id = ?, "
+        "part_number = ?, "
+        "serial_number = ?, ";
+    if (inventorySchema.hasCapacity) {
+        updateInventorySql += "capacity = ?, ";
+    }
+    updateInventorySql +=
+        "interface_type = ?, "
+        "notes = ?, "
+        "arrival_date = ?, "
+        "invoice_number = ? "
+        "WHERE id = ?";
+}
+
+QVariantMap Database::inventoryItemFromQuery(const QSqlQuery &query) const
+{
+    QVariantMap item;
+    item["id"] = query.value(ColId);
+    item["status"] = query.value(ColStatus).toString();
+    item["material_type"] = query.value(ColMaterialType);
+    item["manufacturer"] = query.value(ColManufacturer);
+    item["model"] = query.value(ColModel);
+    item["part_number"] = query.value(ColPartNumber);
+    item["serial_number"] = query.value(ColSerialNumber);
+    item["capacity"] = query.value(ColCapacity);
+    item["interface_type"] = query.value(ColInterfaceType);
+    item["notes"] = query.value(ColNotes);
+    item["arrival_date"] = query.value(ColArrivalDate);
+    item["invoice_number"] = query.value(ColInvoiceNumber);
+    item["created_at"] = query.value(ColCreatedAt);
+    item["updated_at"] = query.value(ColUpdatedAt);
+    return item;
+}
+
+void Database::inventoryRowFromQuery(const QSqlQuery &query, InventoryRow &row)
+{
+    row.id = query.value(ColId).toInt();
+    row.status = query.value(ColStatus).toString();
+    row.materialType = query.value(ColMaterialType).toString();
+    row.manufacturer = query.value(ColManufacturer).toString();
+    row.model = query.value(ColModel).toString();
+    row.partNumber = query.value(ColPartNumber).toString();
+    row.serialNumber = query.value(ColSerialNumber).toString(); // NULL -> пустая строка
+    row.capacity = query.value(ColCapacity).toString();
+    row.interfaceType = query.value(ColInterfaceType).toString();
+    row.notes = query.value(ColNotes).toString();
+    row.arrivalDate = QDate::fromString(query.value(ColArrivalDate).toString(), "yyyy-MM-dd");
+    row.invoiceNumber = query.value(ColInvoiceNumber).toString();
+    row.createdAt = query.value(ColCreatedAt).toString();
+    row.updatedAt = query.value(ColUpdatedAt).toString();
+}
+
+void Database::writeOffRecordFromQuery(const QSqlQuery &query, WriteOffRecord &record)
+{
+    record.id = query.value(WoId).toInt();
+    record.inventoryId = query.value(WoInventoryId).toInt();
+    record.serialNumber = query.value(WoSerialNumber).toString();
+    record.partNumber = query.value(WoPartNumber).toString();
+    record.materialType = query.value(WoMaterialType).toString();
+    record.manufacturer = query.value(WoManufacturer).toString();
+    record.model = query.value(WoModel).toString();
+    record.issuedTo = query.value(WoIssuedTo).toString();
+    record.issueDate = QDate::fromString(query.value(WoIssueDate).toString(), "yyyy-MM-dd");
+    record.comments = query.value(WoComments).toString();
+    record.createdAt = query.value(WoCreatedAt).toString();
+}
+
+void Database::loadDictionaryCache()
+{
+    materialTypeIds.clear();
+    materialTypeNames.clear();
+    manufacturerIds.clear();
+    manufacturerNames.clear();
+    modelIndex.clear();
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+
+    if (query.exec("SELECT id, name FROM material_types")) {
+        while (query.next()) {
+            int id = query.value(0).toInt();
+            QString name = query.value(1).toString();
+            materialTypeIds.insert(name, id);
+            materialTypeNames.insert(id, name);
+        }
+    }
+
+    if (query.exec("SELECT id, name FROM manufacturers")) {
+        while (query.next()) {
+            int id = query.value(0).toInt();
+            QString name = query.value(1).toString();
+            manufacturerIds.insert(name, id);
+            manufacturerNames.insert(id, name);
+        }
+    }
+
+    if (query.exec("SELECT id, material_type_id, manufacturer_id, name FROM models")) {
+        while (query.next()) {
+            QPair<int, int> key(query.value(1).toInt(), query.value(2).toInt());
+            modelIndex[key].insert(query.value(3).toString(), query.value(0).toInt());
+        }
+    }
+
+    qDebug() << "Dictionary cache loaded:"
+             << materialTypeIds.size() << "material types,"
+             << manufacturerIds.size() << "manufacturers,"
+             << modelIndex.size() << "type/manufacturer pairs with models";
+}
+
 QStringList Database::getTableColumns(const QString &tableName)
 {
     QStringList columns;
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("PRAGMA table_info(" + tableName + ")");
 
     if (query.exec()) {
@@ -341,12 +1687,13 @@ bool Database::updateInventoryItem(int itemId, const QString &materialType, cons
 
     // Если есть серийный номер, проверяем, не используется ли он другим элементом
     if (hasSerialNumber) {
-        QSqlQuery checkQuery;
-        checkQuery.prepare("SELECT COUNT(*) FROM inventory WHERE serial_number = ? AND id != ?");
-        checkQuery.addBindValue(finalSerialNumber);
-        checkQuery.addBindValue(itemId);
-        if (checkQuery.exec() && checkQuery.next()) {
-            int count = checkQuery.value(0).toInt();
+        QSqlQuery *checkQuery = cachedQuery(serialNumberOtherCountSql);
+        if (!checkQuery) return false;
+        checkQuery->bindValue(0, finalSerialNumber);
+        checkQuery->bindValue(1, itemId);
+        if (checkQuery->exec() && checkQuery->next()) {
+            int count = checkQuery->value(0).toInt();
+            checkQuery->finish();
             if (count > 0) {
                 qDebug() << "Serial number" << finalSerialNumber << "already used by another item";
                 return false;
@@ -354,81 +1701,52 @@ bool Database::updateInventoryItem(int itemId, const QString &materialType, cons
         }
     }
 
-    QStringList columns = getTableColumns("inventory");
-    bool hasCapacity = columns.contains("capacity");
-
-    qDebug() << "Has capacity column:" << hasCapacity;
-
-    // Строим SQL запрос
-    QString sql = "UPDATE inventory SET ";
     QVariantList bindValues;
-
-    // Добавляем поля в SQL и значения в список
-    sql += "material_type_id = ?, ";
-    bindValues << materialId;
-
-    sql += "manufacturer_id = ?, ";
-    bindValues << manufacturerId;
-
-    sql += "model_id = ?, ";
-    bindValues << modelId;
-
-    sql += "part_number = ?, ";
-    bindValues << partNumber.trimmed();
-
-    if (hasSerialNumber) {
-        sql += "serial_number = ?, ";
-        bindValues << finalSerialNumber;
-    } else {
-        sql += "serial_number = NULL, ";
-    }
-
-    if (hasCapacity) {
-        sql += "capacity = ?, ";
+    bindValues << materialId
+               << manufacturerId
+               << modelId
+               << partNumber.trimmed()
+               << (hasSerialNumber ? QVariant(finalSerialNumber) : QVariant());
+    if (inventorySchema.hasCapacity) {
         bindValues << capacity.trimmed();
     }
+    bindValues << interfaceType.trimmed()
+               << notes.trimmed()
+               << arrivalDate.toString("yyyy-MM-dd")
+               << invoiceNumber.trimmed()
+               << itemId;
 
-    sql += "interface_type = ?, ";
-    bindValues << interfaceType.trimmed();
-
-    sql += "notes = ?, ";
-    bindValues << notes.trimmed();
-
-    sql += "arrival_date = ?, ";
-    bindValues << arrivalDate.toString("yyyy-MM-dd");
-
-    sql += "invoice_number = ? ";
-    bindValues << invoiceNumber.trimmed();
-
-    sql += "WHERE id = ?";
-    bindValues << itemId;
-
-    qDebug() << "SQL:" << sql;
     qDebug() << "Bind values count:" << bindValues.count();
 
-    QSqlQuery query;
-    if (!query.prepare(sql)) {
-        qDebug() << "Failed to prepare query:" << query.lastError().text();
+    // Смена модели меняет счетчики двух узлов дерева материалов
+    int previousModelId = itemModelId(itemId);
+
+    QSqlQuery *query = cachedQuery(updateInventorySql);
+    if (!query) {
         return false;
     }
 
     // Привязываем значения
     for (int i = 0; i < bindValues.count(); ++i) {
-        query.bindValue(i, bindValues[i]);
+        query->bindValue(i, bindValues[i]);
     }
 
-    bool success = query.exec();
+    bool success = query->exec();
 
     if (!success) {
-        qDebug() << "Query execution failed:" << query.lastError().text();
-        qDebug() << "Last query:" << query.lastQuery();
+        qDebug() << "Query execution failed:" << query->lastError().text();
+        qDebug() << "Last query:" << query->lastQuery();
 
         // Выводим детали привязки значений
         for (int i = 0; i < bindValues.count(); ++i) {
             qDebug() << "  Value" << i << ":" << bindValues[i].toString();
         }
     } else {
-        qDebug() << "Update successful, affected rows:" << query.numRowsAffected();
+        qDebug() << "Update successful, affected rows:" << query->numRowsAffected();
+        emit inventoryItemsChanged({itemId});
+        if (previousModelId > 0 && previousModelId != modelId) {
+            emit modelItemCountsChanged({previousModelId, modelId});
+        }
     }
 
     return success;
@@ -437,7 +1755,7 @@ bool Database::updateInventoryItem(int itemId, const QString &materialType, cons
 
 bool Database::createTables()
 {
-    QSqlQuery query;
+    QSqlQuery query(db);
 
     // Таблица типов материалов
     QString createMaterialTypesTable =
@@ -480,76 +1798,17 @@ bool Database::createTables()
         return false;
     }
 
-    // Таблица записей ЗИП - ИЗМЕНЕНО: убрали UNIQUE с serial_number
-    QString createInventoryTable =
-        "CREATE TABLE IF NOT EXISTS inventory ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "material_type_id INTEGER NOT NULL,"
-        "manufacturer_id INTEGER NOT NULL,"
-        "model_id INTEGER NOT NULL,"
-        "part_number TEXT,"
-        "serial_number TEXT,"  // Убрали UNIQUE отсюда
-        "capacity TEXT,"
-        "interface_type TEXT,"
-        "notes TEXT,"
-        "arrival_date DATE NOT NULL,"
-        "invoice_number TEXT,"
-        "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
-        "updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
-        "FOREIGN KEY (material_type_id) REFERENCES material_types(id),"
-        "FOREIGN KEY (manufacturer_id) REFERENCES manufacturers(id),"
-        "FOREIGN KEY (model_id) REFERENCES models(id)"
-        ")";
-
-    if (!query.exec(createInventoryTable)) {
+    // Таблица записей ЗИП
+    if (!query.exec(inventoryTableSql("inventory"))) {
         qDebug() << "Error creating inventory table:" << query.lastError().text();
-        return false;
-    }
-
-    // Триггер для обновления updated_at
-    query.exec("CREATE TRIGGER IF NOT EXISTS update_inventory_timestamp "
-               "AFTER UPDATE ON inventory "
-               "BEGIN "
-               "UPDATE inventory SET updated_at = CURRENT_TIMESTAMP WHERE id = NEW.id; "
-               "END;");
-
-    // Индексы
-    query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_serial ON inventory(serial_number)"); // Это обычный индекс, не UNIQUE
-    query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_part_number ON inventory(part_number)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_capacity ON inventory(capacity)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_inventory_arrival_date ON inventory(arrival_date)");
-    query.exec("CREATE INDEX IF NOT EXISTS idx_models_composite ON models(material_type_id, manufacturer_id)");
-
-
-    // Таблица истории списаний
-        QString createWriteOffHistoryTable =
-            "CREATE TABLE IF NOT EXISTS write_off_history ("
-            "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-            "inventory_id INTEGER NOT NULL,"
-            "issued_to TEXT NOT NULL,"
-            "issue_date DATE NOT NULL,"
-            "comments TEXT,"
-            "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
-            "FOREIGN KEY (inventory_id) REFERENCES inventory(id)"
-            ")";
-
-        if (!query.exec(createWriteOffHistoryTable)) {
-            qDebug() << "Error creating write_off_history table:" << query.lastError().text();
-            return false;
-        }
-
-        // Добавляем колонку для статуса в таблицу inventory
-        QStringList columns = getTableColumns("inventory");
-
-        if (!columns.contains("status")) {
-            qDebug() << "Adding status column to inventory...";
-            if (!query.exec("ALTER TABLE inventory ADD COLUMN status TEXT DEFAULT 'available'")) {
-                qDebug() << "Failed to add status column:" << query.lastError().text();
-            }
-        }
-
-
+        return false;
+    }
 
+    // Таблица истории списаний
+    if (!query.exec(writeOffHistoryTableSql("write_off_history"))) {
+        qDebug() << "Error creating write_off_history table:" << query.lastError().text();
+        return false;
+    }
 
     // Проверяем, нужно ли добавлять стандартные данные
     query.exec("SELECT COUNT(*) FROM material_types");
@@ -582,17 +1841,25 @@ bool Database::createTables()
 // Вспомогательные методы
 int Database::getMaterialTypeId(const QString &materialType)
 {
-    QSqlQuery query;
-    query.prepare("SELECT id FROM material_types WHERE name = ?");
-    query.addBindValue(materialType);
+    auto it = materialTypeIds.constFind(materialType);
+    if (it != materialTypeIds.constEnd()) {
+        return it.value();
+    }
 
-    if (query.exec() && query.next()) {
-        int id = query.value(0).toInt();
+    // Промах кэша: запись могла появиться через другое соединение
+    QSqlQuery *query = cachedQuery("SELECT id FROM material_types WHERE name = ?");
+    if (!query) return -1;
+    query->bindValue(0, materialType);
+
+    if (query->exec() && query->next()) {
+        int id = query->value(0).toInt();
+        query->finish();
+        materialTypeIds.insert(materialType, id);
+        materialTypeNames.insert(id, materialType);
         qDebug() << "Found material type ID:" << id << "for" << materialType;
         return id;
     } else {
         qDebug() << "Material type not found:" << materialType;
-        qDebug() << "Error:" << query.lastError().text();
         return -1;
     }
 }
@@ -600,17 +1867,25 @@ int Database::getMaterialTypeId(const QString &materialType)
 
 int Database::getManufacturerId(const QString &manufacturer)
 {
-    QSqlQuery query;
-    query.prepare("SELECT id FROM manufacturers WHERE name = ?");
-    query.addBindValue(manufacturer);
+    auto it = manufacturerIds.constFind(manufacturer);
+    if (it != manufacturerIds.constEnd()) {
+        return it.value();
+    }
 
-    if (query.exec() && query.next()) {
-        int id = query.value(0).toInt();
+    // Промах кэша: запись могла появиться через другое соединение
+    QSqlQuery *query = cachedQuery("SELECT id FROM manufacturers WHERE name = ?");
+    if (!query) return -1;
+    query->bindValue(0, manufacturer);
+
+    if (query->exec() && query->next()) {
+        int id = query->value(0).toInt();
+        query->finish();
+        manufacturerIds.insert(manufacturer, id);
+        manufacturerNames.insert(id, manufacturer);
         qDebug() << "Found manufacturer ID:" << id << "for" << manufacturer;
         return id;
     } else {
         qDebug() << "Manufacturer not found:" << manufacturer;
-        qDebug() << "Error:" << query.lastError().text();
         return -1;
     }
 }
@@ -625,58 +1900,80 @@ int Database::getModelId(const QString &materialType, const QString &manufacture
         return -1;
     }
 
-    QSqlQuery query;
-    query.prepare("SELECT id FROM models WHERE material_type_id = ? AND manufacturer_id = ? AND name = ?");
-    query.addBindValue(materialId);
-    query.addBindValue(manufacturerId);
-    query.addBindValue(modelName);
+    QPair<int, int> key(materialId, manufacturerId);
+    auto pairIt = modelIndex.constFind(key);
+    if (pairIt != modelIndex.constEnd()) {
+        auto modelIt = pairIt.value().constFind(modelName);
+        if (modelIt != pairIt.value().constEnd()) {
+            return modelIt.value();
+        }
+    }
 
-    if (query.exec() && query.next()) {
-        int id = query.value(0).toInt();
+    // Промах кэша: модель могла появиться через другое соединение
+    QSqlQuery *query = cachedQuery("SELECT id FROM models WHERE material_type_id = ? AND manufacturer_id = ? AND name = ?");
+    if (!query) return -1;
+    query->bindValue(0, materialId);
+    query->bindValue(1, manufacturerId);
+    query->bindValue(2, modelName);
+
+    if (query->exec() && query->next()) {
+        int id = query->value(0).toInt();
+        query->finish();
+        modelIndex[key].insert(modelName, id);
         qDebug() << "Found model ID:" << id << "for" << modelName;
         return id;
-    } else {
-        qDebug() << "Model not found:" << modelName
-                 << "for material:" << materialType
-                 << "manufacturer:" << manufacturer;
-        qDebug() << "Error:" << query.lastError().text();
-
-        // Попробуем добавить модель, если её нет
-        qDebug() << "Attempting to add model...";
-        if (addModel(materialType, manufacturer, modelName)) {
-            // Попробуем получить ID снова
-            query.exec();
-            if (query.next()) {
-                int id = query.value(0).toInt();
-                qDebug() << "Model added successfully, ID:" << id;
-                return id;
-            }
-        }
+    }
 
-        return -1;
+    qDebug() << "Model not found:" << modelName
+             << "for material:" << materialType
+             << "manufacturer:" << manufacturer;
+
+    // Попробуем добавить модель, если её нет
+    qDebug() << "Attempting to add model...";
+    if (addModel(materialType, manufacturer, modelName)) {
+        int id = modelIndex.value(key).value(modelName.trimmed(), -1);
+        if (id != -1) {
+            qDebug() << "Model added successfully, ID:" << id;
+            return id;
+        }
     }
+
+    return -1;
 }
 
 bool Database::addMaterialType(const QString &type)
 {
     if (type.isEmpty()) return false;
 
-    QSqlQuery query;
-    query.prepare("INSERT OR IGNORE INTO material_types (name) VALUES (?)");
-    query.addBindValue(type.trimmed());
+    QString name = type.trimmed();
+    if (materialTypeIds.contains(name)) {
+        return true; // Уже есть в справочнике
+    }
 
-    return query.exec();
-}
+    QSqlQuery *query = cachedQuery("INSERT OR IGNORE INTO material_types (name) VALUES (?)");
+    if (!query) return false;
+    query->bindValue(0, name);
 
-QStringList Database::getMaterialTypes()
-{
-    QStringList types;
-    QSqlQuery query("SELECT name FROM material_types ORDER BY name");
+    if (!query->exec()) {
+        qDebug() << "Failed to add material type:" << query->lastError().text();
+        return false;
+    }
 
-    while (query.next()) {
-        types.append(query.value(0).toString());
+    if (query->numRowsAffected() > 0) {
+        int id = query->lastInsertId().toInt();
+        materialTypeIds.insert(name, id);
+        materialTypeNames.insert(id, name);
+    } else {
+        getMaterialTypeId(name); // Добавлен другим соединением - подтягиваем в кэш
     }
 
+    return true;
+}
+
+QStringList Database::getMaterialTypes()
+{
+    QStringList types = materialTypeIds.keys();
+    std::sort(types.begin(), types.end());
     return types;
 }
 
@@ -684,22 +1981,35 @@ bool Database::addManufacturer(const QString &manufacturer)
 {
     if (manufacturer.isEmpty()) return false;
 
-    QSqlQuery query;
-    query.prepare("INSERT OR IGNORE INTO manufacturers (name) VALUES (?)");
-    query.addBindValue(manufacturer.trimmed());
+    QString name = manufacturer.trimmed();
+    if (manufacturerIds.contains(name)) {
+        return true; // Уже есть в справочнике
+    }
 
-    return query.exec();
-}
+    QSqlQuery *query = cachedQuery("INSERT OR IGNORE INTO manufacturers (name) VALUES (?)");
+    if (!query) return false;
+    query->bindValue(0, name);
 
-QStringList Database::getManufacturers()
-{
-    QStringList manufacturers;
-    QSqlQuery query("SELECT name FROM manufacturers ORDER BY name");
+    if (!query->exec()) {
+        qDebug() << "Failed to add manufacturer:" << query->lastError().text();
+        return false;
+    }
 
-    while (query.next()) {
-        manufacturers.append(query.value(0).toString());
+    if (query->numRowsAffected() > 0) {
+        int id = query->lastInsertId().toInt();
+        manufacturerIds.insert(name, id);
+        manufacturerNames.insert(id, name);
+    } else {
+        getManufacturerId(name); // Добавлен другим соединением - подтягиваем в кэш
     }
 
+    return true;
+}
+
+QStringList Database::getManufacturers()
+{
+    QStringList manufacturers = manufacturerIds.keys();
+    std::sort(manufacturers.begin(), manufacturers.end());
     return manufacturers;
 }
 
@@ -720,22 +2030,31 @@ bool Database::addModel(const QString &materialType, const QString &manufacturer
         return false;
     }
 
-    QSqlQuery query;
-    query.prepare("INSERT OR IGNORE INTO models (material_type_id, manufacturer_id, name) VALUES (?, ?, ?)");
-    query.addBindValue(materialId);
-    query.addBindValue(manufacturerId);
-    query.addBindValue(modelName.trimmed());
+    QString name = modelName.trimmed();
+    QPair<int, int> key(materialId, manufacturerId);
+    if (modelIndex.value(key).contains(name)) {
+        qDebug() << "Model already exists (cache)";
+        return true;
+    }
 
-    bool success = query.exec();
+    QSqlQuery *query = cachedQuery("INSERT OR IGNORE INTO models (material_type_id, manufacturer_id, name) VALUES (?, ?, ?)");
+    if (!query) return false;
+    query->bindValue(0, materialId);
+    query->bindValue(1, manufacturerId);
+    query->bindValue(2, name);
+
+    bool success = query->exec();
 
     if (!success) {
-        qDebug() << "Failed to add model:" << query.lastError().text();
+        qDebug() << "Failed to add model:" << query->lastError().text();
     } else {
         qDebug() << "Model added successfully";
-        if (query.numRowsAffected() > 0) {
+        if (query->numRowsAffected() > 0) {
             qDebug() << "New row inserted";
+            modelIndex[key].insert(name, query->lastInsertId().toInt());
         } else {
             qDebug() << "Model already exists (IGNORE)";
+            getModelId(materialType, manufacturer, name); // Подтягиваем в кэш
         }
     }
 
@@ -746,12 +2065,13 @@ bool Database::checkInventoryItemExists(int itemId)
 {
     if (itemId <= 0) return false;
 
-    QSqlQuery query;
-    query.prepare("SELECT COUNT(*) FROM inventory WHERE id = ?");
-    query.addBindValue(itemId);
+    QSqlQuery *query = cachedQuery(inventoryItemExistsSql);
+    if (!query) return false;
+    query->bindValue(0, itemId);
 
-    if (query.exec() && query.next()) {
-        bool exists = query.value(0).toInt() > 0;
+    if (query->exec() && query->next()) {
+        bool exists = query->value(0).toInt() > 0;
+        query->finish();
         qDebug() << "Item" << itemId << "exists:" << exists;
         return exists;
     }
@@ -762,28 +2082,15 @@ bool Database::checkInventoryItemExists(int itemId)
 
 QStringList Database::getModelsByMaterialAndManufacturer(const QString &materialType, const QString &manufacturer)
 {
-    QStringList models;
-
     int materialId = getMaterialTypeId(materialType);
     int manufacturerId = getManufacturerId(manufacturer);
 
     if (materialId == -1 || manufacturerId == -1) {
-        return models;
-    }
-
-    QSqlQuery query;
-    query.prepare(
-        "SELECT name FROM models WHERE material_type_id = ? AND manufacturer_id = ? ORDER BY name"
-    );
-    query.addBindValue(materialId);
-    query.addBindValue(manufacturerId);
-
-    if (query.exec()) {
-        while (query.next()) {
-            models.append(query.value(0).toString());
-        }
+        return QStringList();
     }
 
+    QStringList models = modelIndex.value(qMakePair(materialId, manufacturerId)).keys();
+    std::sort(models.begin(), models.end());
     return models;
 }
 
@@ -794,21 +2101,84 @@ QStringList Database::getModelsByMaterial(const QString &materialType)
     int materialId = getMaterialTypeId(materialType);
     if (materialId == -1) return models;
 
-    QSqlQuery query;
-    query.prepare(
-        "SELECT DISTINCT name FROM models WHERE material_type_id = ? ORDER BY name"
-    );
-    query.addBindValue(materialId);
-
-    if (query.exec()) {
-        while (query.next()) {
-            models.append(query.value(0).toString());
+    for (auto it = modelIndex.constBegin(); it != modelIndex.constEnd(); ++it) {
+        if (it.key().first == materialId) {
+            models.append(it.value().keys());
         }
     }
 
+    std::sort(models.begin(), models.end());
+    models.removeDuplicates();
     return models;
 }
 
+QList<Database::MaterialTreeRow> Database::getMaterialTreeRows()
+{
+    QList<MaterialTreeRow> rows;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (!query.exec(materialTreeSql)) {
+        qDebug() << "Error loading materials tree:" << query.lastError().text();
+        return rows;
+    }
+
+    while (query.next()) {
+        MaterialTreeRow row;
+        row.materialType = query.value(0).toString();
+        row.manufacturer = query.value(1).toString();
+        row.model = query.value(2).toString();
+        row.itemCount = query.value(3).toInt();
+        rows.append(row);
+    }
+
+    return rows;
+}
+
+QList<Database::MaterialTreeRow> Database::getModelItemCounts(const QList<int> &modelIds)
+{
+    QList<MaterialTreeRow> rows;
+    if (modelIds.isEmpty()) {
+        return rows;
+    }
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(modelItemCountsSql(placeholderList(modelIds.size())));
+    for (int id : modelIds) {
+        query.addBindValue(id);
+    }
+
+    if (!query.exec()) {
+        qDebug() << "Error loading model item counts:" << query.lastError().text();
+        return rows;
+    }
+
+    while (query.next()) {
+        MaterialTreeRow row;
+        row.materialType = query.value(0).toString();
+        row.manufacturer = query.value(1).toString();
+        row.model = query.value(2).toString();
+        row.itemCount = query.value(3).toInt();
+        rows.append(row);
+    }
+
+    return rows;
+}
+
+int Database::itemModelId(int itemId)
+{
+    QSqlQuery *query = cachedQuery(itemModelIdSql);
+    if (!query) {
+        return -1;
+    }
+
+    query->bindValue(0, itemId);
+    int modelId = query->exec() && query->next() ? query->value(0).toInt() : -1;
+    query->finish();
+    return modelId;
+}
+
 bool Database::addInventoryItem(const QString &materialType, const QString &manufacturer, const QString &modelName,
                                const QString &partNumber, const QString &serialNumber, const QString &capacity,
                                const QString &interfaceType, const QString &notes, const QDate &arrivalDate,
@@ -832,14 +2202,16 @@ bool Database::addInventoryItem(const QString &materialType, const QString &manu
     QString finalSerialNumber = serialNumber.trimmed();
     bool hasSerialNumber = !finalSerialNumber.isEmpty();
 
-    QSqlQuery query;
+    QSqlQuery *query = nullptr;
 
     if (hasSerialNumber) {
         // Проверяем, нет ли уже такого серийного номера
-        query.prepare("SELECT COUNT(*) FROM inventory WHERE serial_number = ?");
-        query.addBindValue(finalSerialNumber);
-        if (query.exec() && query.next()) {
-            int count = query.value(0).toInt();
+        QSqlQuery *checkQuery = cachedQuery(serialNumberCountSql);
+        if (!checkQuery) return false;
+        checkQuery->bindValue(0, finalSerialNumber);
+        if (checkQuery->exec() && checkQuery->next()) {
+            int count = checkQuery->value(0).toInt();
+            checkQuery->finish();
             if (count > 0) {
                 qDebug() << "Serial number" << finalSerialNumber << "already exists in database";
                 // Можно либо вернуть false, либо добавить с другим номером
@@ -848,253 +2220,235 @@ bool Database::addInventoryItem(const QString &materialType, const QString &manu
             }
         }
 
-        query.prepare(
+        query = cachedQuery(
             "INSERT INTO inventory (material_type_id, manufacturer_id, model_id, "
             "part_number, serial_number, capacity, interface_type, notes, arrival_date, invoice_number) "
             "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
         );
-        query.addBindValue(materialId);
-        query.addBindValue(manufacturerId);
-        query.addBindValue(modelId);
-        query.addBindValue(partNumber.trimmed());
-        query.addBindValue(finalSerialNumber); // Используем серийный номер
-        query.addBindValue(capacity.trimmed());
-        query.addBindValue(interfaceType.trimmed());
-        query.addBindValue(notes.trimmed());
-        query.addBindValue(arrivalDate.toString("yyyy-MM-dd"));
-        query.addBindValue(invoiceNumber.trimmed());
+        if (!query) return false;
+        query->bindValue(0, materialId);
+        query->bindValue(1, manufacturerId);
+        query->bindValue(2, modelId);
+        query->bindValue(3, partNumber.trimmed());
+        query->bindValue(4, finalSerialNumber); // Используем серийный номер
+        query->bindValue(5, capacity.trimmed());
+        query->bindValue(6, interfaceType.trimmed());
+        query->bindValue(7, notes.trimmed());
+        query->bindValue(8, arrivalDate.toString("yyyy-MM-dd"));
+        query->bindValue(9, invoiceNumber.trimmed());
     } else {
         // Без серийного номера
-        query.prepare(
+        query = cachedQuery(
             "INSERT INTO inventory (material_type_id, manufacturer_id, model_id, "
             "part_number, serial_number, capacity, interface_type, notes, arrival_date, invoice_number) "
             "VALUES (?, ?, ?, ?, NULL, ?, ?, ?, ?, ?)"
         );
-        query.addBindValue(materialId);
-        query.addBindValue(manufacturerId);
-        query.addBindValue(modelId);
-        query.addBindValue(partNumber.trimmed());
+        if (!query) return false;
+        query->bindValue(0, materialId);
+        query->bindValue(1, manufacturerId);
+        query->bindValue(2, modelId);
+        query->bindValue(3, partNumber.trimmed());
         // serial_number = NULL
-        query.addBindValue(capacity.trimmed());
-        query.addBindValue(interfaceType.trimmed());
-        query.addBindValue(notes.trimmed());
-        query.addBindValue(arrivalDate.toString("yyyy-MM-dd"));
-        query.addBindValue(invoiceNumber.trimmed());
+        query->bindValue(4, capacity.trimmed());
+        query->bindValue(5, interfaceType.trimmed());
+        query->bindValue(6, notes.trimmed());
+        query->bindValue(7, arrivalDate.toString("yyyy-MM-dd"));
+        query->bindValue(8, invoiceNumber.trimmed());
     }
 
-    bool success = query.exec();
+    bool success = query->exec();
 
     if (!success) {
-        qDebug() << "Failed to add inventory item:" << query.lastError().text();
+        qDebug() << "Failed to add inventory item:" << query->lastError().text();
     } else {
-        qDebug() << "Inventory item added successfully, ID:" << query.lastInsertId().toInt();
+        int itemId = query->lastInsertId().toInt();
+        qDebug() << "Inventory item added successfully, ID:" << itemId;
+        emit inventoryItemsAdded({itemId});
+        emit modelItemCountsChanged({modelId});
     }
 
     return success;
 }
 
-bool Database::deleteInventoryItem(int itemId)
+bool Database::beginBulkInsert()
 {
-    if (itemId <= 0) return false;
+    if (bulkInsertActive) {
+        qDebug() << "Bulk insert already started";
+        return false;
+    }
 
-    QSqlQuery query;
-    query.prepare("DELETE FROM inventory WHERE id = ?");
-    query.addBindValue(itemId);
+    if (!db.transaction()) {
+        qDebug() << "Failed to start bulk insert transaction:" << db.lastError().text();
+        return false;
+    }
 
-    return query.exec();
+    bulkInsertActive = true;
+    qDebug() << "Bulk insert started";
+    return true;
 }
 
-QVariantMap Database::getInventoryItemById(int itemId)
+bool Database::bulkInsertItem(const InventoryRow &row, QString &error)
 {
-    QVariantMap item;
+    if (!bulkInsertActive) {
+        error = "Пакетная вставка не начата";
+        return false;
+    }
 
-    if (itemId <= 0) return item;
+    QString materialType = row.materialType.trimmed();
+    QString manufacturer = row.manufacturer.trimmed();
+    QString modelName = row.model.trimmed();
 
-    QStringList columns = getTableColumns("inventory");
+    if (materialType.isEmpty() || manufacturer.isEmpty() || modelName.isEmpty()) {
+        error = "Не указан тип материала, производитель или модель";
+        return false;
+    }
 
-    QString sql =
-        "SELECT i.id, mt.name as material_type, man.name as manufacturer, "
-        "m.name as model, i.part_number, i.serial_number, ";
+    QString serialNumber = row.serialNumber.trimmed();
 
-    if (columns.contains("capacity")) {
-        sql += "i.capacity, ";
-    } else {
-        sql += "'' as capacity, ";
+    // Справочники разрешаются через кэш, недостающие записи создаются один раз
+    if (!addMaterialType(materialType) || !addManufacturer(manufacturer)) {
+        error = "Не удалось добавить тип материала или производителя";
+        return false;
     }
 
-    sql +=
-        "i.interface_type, i.notes, i.arrival_date, i.invoice_number ";
-
-    if (columns.contains("created_at")) {
-        sql += ", i.created_at ";
+    int materialId = getMaterialTypeId(materialType);
+    int manufacturerId = getManufacturerId(manufacturer);
+    int modelId = getModelId(materialType, manufacturer, modelName);
+    if (materialId == -1 || manufacturerId == -1 || modelId == -1) {
+        error = "Не удалось определить модель";
+        return false;
     }
 
-    if (columns.contains("updated_at")) {
-        sql += ", i.updated_at ";
+    QSqlQuery *query = cachedQuery(bulkInsertItemSql);
+    if (!query) {
+        error = "Не удалось подготовить запрос";
+        return false;
     }
 
-    sql +=
-        "FROM inventory i "
-        "JOIN models m ON i.model_id = m.id "
-        "JOIN material_types mt ON i.material_type_id = mt.id "
-        "JOIN manufacturers man ON i.manufacturer_id = man.id "
-        "WHERE i.id = ?";
+    QDate arrivalDate = row.arrivalDate.isValid() ? row.arrivalDate : QDate::currentDate();
+
+    query->bindValue(0, materialId);
+    query->bindValue(1, manufacturerId);
+    query->bindValue(2, modelId);
+    query->bindValue(3, row.partNumber.trimmed());
+    QVariant serialValue = serialNumber.isEmpty() ? QVariant() : QVariant(serialNumber);
+    query->bindValue(4, serialValue);
+    query->bindValue(5, row.capacity.trimmed());
+    query->bindValue(6, row.interfaceType.trimmed());
+    query->bindValue(7, row.notes.trimmed());
+    query->bindValue(8, arrivalDate.toString("yyyy-MM-dd"));
+    query->bindValue(9, row.invoiceNumber.trimmed());
+    query->bindValue(10, serialValue);
+    query->bindValue(11, serialValue);
+
+    // Ошибка отдельного INSERT в SQLite не откатывает транзакцию
+    if (!query->exec()) {
+        error = query->lastError().text();
+        return false;
+    }
 
-    QSqlQuery query;
-    query.prepare(sql);
-    query.addBindValue(itemId);
+    if (query->numRowsAffected() == 0) {
+        error = QString("Серийный номер %1 уже есть в базе").arg(serialNumber);
+        return false;
+    }
+    return true;
+}
 
-    if (query.exec() && query.next()) {
-        item["id"] = query.value("id");
-        item["material_type"] = query.value("material_type");
-        item["manufacturer"] = query.value("manufacturer");
-        item["model"] = query.value("model");
-        item["part_number"] = query.value("part_number");
+bool Database::commitBulkInsert()
+{
+    if (!bulkInsertActive) {
+        return false;
+    }
 
-        // Обрабатываем NULL для серийного номера
-        QVariant serialValue = query.value("serial_number");
-        if (serialValue.isNull() || serialValue.toString().isEmpty()) {
-            item["serial_number"] = "";
-        } else {
-            item["serial_number"] = serialValue.toString();
-        }
+    bulkInsertActive = false;
 
-        item["capacity"] = query.value("capacity");
-        item["interface_type"] = query.value("interface_type");
-        item["notes"] = query.value("notes");
-        item["arrival_date"] = query.value("arrival_date");
-        item["invoice_number"] = query.value("invoice_number");
+    if (!db.commit()) {
+        qDebug() << "Failed to commit bulk insert:" << db.lastError().text();
+        db.rollback();
+        loadDictionaryCache();
+        return false;
+    }
 
-        if (columns.contains("created_at")) {
-            item["created_at"] = query.value("created_at");
-        }
+    return true;
+}
 
-        if (columns.contains("updated_at")) {
-            item["updated_at"] = query.value("updated_at");
-        }
+void Database::rollbackBulkInsert()
+{
+    if (!bulkInsertActive) {
+        return;
     }
 
-    return item;
+    bulkInsertActive = false;
+    db.rollback();
+
+    // Записи справочников, созданные в транзакции, больше не существуют
+    loadDictionaryCache();
 }
 
-QList<QVariantMap> Database::getInventoryItems()
+bool Database::deleteInventoryItem(int itemId)
 {
-    QList<QVariantMap> items;
-
-    qDebug() << "=== Getting inventory items ===";
+    if (itemId <= 0) return false;
 
-    QStringList columns = getTableColumns("inventory");
-    qDebug() << "Available columns in inventory:" << columns;
+    // Модель нужна дереву материалов, после удаления ее уже не узнать
+    int modelId = itemModelId(itemId);
 
-    // Проверяем наличие колонки status
-    bool hasStatusColumn = columns.contains("status");
+    // История списаний удаляется каскадно (внешний ключ write_off_history.inventory_id)
+    QSqlQuery query(db);
+    query.prepare(deleteInventoryItemSql);
+    query.addBindValue(itemId);
 
-    // Строим запрос динамически
-    QString sql =
-        "SELECT "
-        "i.id, ";
+    if (!query.exec()) {
+        return false;
+    }
 
-    // Добавляем статус, если есть колонка
-    if (hasStatusColumn) {
-        sql += "COALESCE(i.status, 'available') as status, ";
-    } else {
-        sql += "'available' as status, ";
+    emit inventoryItemsRemoved({itemId});
+    if (modelId > 0 && query.numRowsAffected() > 0) {
+        emit modelItemCountsChanged({modelId});
     }
+    return true;
+}
 
-    sql +=
-        "COALESCE(mt.name, 'Неизвестно') as material_type, "
-        "COALESCE(man.name, 'Неизвестно') as manufacturer, "
-        "COALESCE(m.name, 'Неизвестно') as model, "
-        "i.part_number, "
-        "i.serial_number, ";
+QVariantMap Database::getInventoryItemById(int itemId)
+{
+    QVariantMap item;
 
-    // Добавляем capacity
-    if (columns.contains("capacity")) {
-        sql += "i.capacity, ";
-    } else {
-        sql += "'' as capacity, ";
-    }
+    if (itemId <= 0) return item;
 
-    sql +=
-        "i.interface_type, "
-        "i.notes, "
-        "i.arrival_date, "
-        "i.invoice_number ";
+    QSqlQuery *query = cachedQuery(selectInventoryByIdSql);
+    if (!query) return item;
+    query->bindValue(0, itemId);
 
-    // Добавляем created_at и updated_at если существуют
-    if (columns.contains("created_at")) {
-        sql += ", i.created_at ";
-    }
+    if (query->exec() && query->next()) {
+        item = inventoryItemFromQuery(*query);
+        query->finish();
 
-    if (columns.contains("updated_at")) {
-        sql += ", i.updated_at ";
+        // Обрабатываем NULL для серийного номера
+        if (item["serial_number"].isNull()) {
+            item["serial_number"] = "";
+        }
     }
 
-    sql +=
-        "FROM inventory i "
-        "LEFT JOIN material_types mt ON i.material_type_id = mt.id "
-        "LEFT JOIN manufacturers man ON i.manufacturer_id = man.id "
-        "LEFT JOIN models m ON i.model_id = m.id "
-        "ORDER BY i.arrival_date DESC, i.id DESC";
+    return item;
+}
 
-    QSqlQuery query;
-    bool success = query.exec(sql);
+QList<QVariantMap> Database::getInventoryItems()
+{
+    QList<QVariantMap> items;
 
-    if (!success) {
-        qDebug() << "Query error:" << query.lastError().text();
-        qDebug() << "SQL:" << sql;
+    QSqlQuery *query = cachedQuery(selectInventorySql);
+    if (!query) {
         return items;
     }
 
-    qDebug() << "Query successful, processing rows...";
-
-    int count = 0;
-    while (query.next()) {
-        QVariantMap item;
-        item["id"] = query.value("id");
-
-        // Получаем статус
-        if (hasStatusColumn) {
-            item["status"] = query.value("status").toString();
-        } else {
-            item["status"] = "available"; // По умолчанию
-        }
-
-        item["material_type"] = query.value("material_type");
-        item["manufacturer"] = query.value("manufacturer");
-        item["model"] = query.value("model");
-        item["part_number"] = query.value("part_number");
-        item["serial_number"] = query.value("serial_number");
-        item["capacity"] = query.value("capacity");
-        item["interface_type"] = query.value("interface_type");
-        item["notes"] = query.value("notes");
-        item["arrival_date"] = query.value("arrival_date");
-        item["invoice_number"] = query.value("invoice_number");
-
-        // Опциональные поля
-        if (columns.contains("created_at")) {
-            item["created_at"] = query.value("created_at");
-        } else {
-            item["created_at"] = "";
-        }
-
-        if (columns.contains("updated_at")) {
-            item["updated_at"] = query.value("updated_at");
-        } else {
-            item["updated_at"] = "";
-        }
-
-        // Отладочный вывод
-        qDebug() << "Item" << ++count << ":"
-                 << "ID:" << item["id"].toInt()
-                 << "Status:" << item["status"].toString()
-                 << "SN:" << item["serial_number"].toString()
-                 << "Type:" << item["material_type"].toString();
-
-        items.append(item);
+    if (!query->exec()) {
+        qDebug() << "Query error:" << query->lastError().text();
+        qDebug() << "SQL:" << selectInventorySql;
+        return items;
     }
 
-    qDebug() << "=== Total items loaded:" << items.size() << "===";
+    while (query->next()) {
+        items.append(inventoryItemFromQuery(*query));
+    }
 
     return items;
 }
@@ -1107,102 +2461,94 @@ QList<QVariantMap> Database::searchInventory(const QString &searchText)
         return getInventoryItems();
     }
 
-    QStringList columns = getTableColumns("inventory");
-
-    QString sql =
-        "SELECT "
-        "i.id, "
-        "COALESCE(mt.name, 'Неизвестно') as material_type, "
-        "COALESCE(man.name, 'Неизвестно') as manufacturer, "
-        "COALESCE(m.name, 'Неизвестно') as model, "
-        "i.part_number, "
-        "i.serial_number, ";
-
-    if (columns.contains("capacity")) {
-        sql += "i.capacity, ";
-    } else {
-        sql += "'' as capacity, ";
+    QString searchPattern = ftsAvailable ? buildFtsMatchQuery(searchText)
+                                         : "%" + searchText + "%";
+    if (searchPattern.isEmpty()) {
+        return getInventoryItems(); // Строка состояла только из пробелов
     }
 
-    sql +=
-        "i.interface_type, "
-        "i.notes, "
-        "i.arrival_date, "
-        "i.invoice_number ";
+    QSqlQuery *query = cachedQuery(searchInventorySql);
+    if (!query) {
+        return items;
+    }
 
-    if (columns.contains("created_at")) {
-        sql += ", i.created_at ";
+    for (int i = 0; i < searchParamCount; i++) {
+        query->bindValue(i, searchPattern);
+    }
+    if (ftsAvailable && trigramAvailable) {
+        query->bindValue(1, buildTrigramMatchQuery(QString(), searchText.trimmed()));
     }
 
-    if (columns.contains("updated_at")) {
-        sql += ", i.updated_at ";
+    if (query->exec()) {
+        while (query->next()) {
+            items.append(inventoryItemFromQuery(*query));
+        }
+    } else {
+        qDebug() << "Search query error:" << query->lastError().text();
     }
 
-    sql +=
-        "FROM inventory i "
-        "LEFT JOIN material_types mt ON i.material_type_id = mt.id "
-        "LEFT JOIN manufacturers man ON i.manufacturer_id = man.id "
-        "LEFT JOIN models m ON i.model_id = m.id "
-        "WHERE i.serial_number LIKE ? OR "
-        "i.part_number LIKE ? OR ";
+    return items;
+}
 
-    if (columns.contains("capacity")) {
-        sql += "i.capacity LIKE ? OR ";
+bool Database::getInventoryItems(QList<InventoryRow> &rows)
+{
+    rows.clear();
+
+    QSqlQuery *query = cachedQuery(selectInventorySql);
+    if (!query) {
+        return false;
     }
 
-    sql +=
-        "mt.name LIKE ? OR "
-        "man.name LIKE ? OR "
-        "m.name LIKE ? OR "
-        "i.notes LIKE ? OR "
-        "i.invoice_number LIKE ? "
-        "ORDER BY i.arrival_date DESC, i.id DESC";
+    if (!query->exec()) {
+        qDebug() << "Query error:" << query->lastError().text();
+        return false;
+    }
 
-    QSqlQuery query;
-    query.prepare(sql);
+    while (query->next()) {
+        rows.append(InventoryRow());
+        inventoryRowFromQuery(*query, rows.last());
+    }
 
-    QString searchPattern = "%" + searchText + "%";
+    return true;
+}
 
-    // Добавляем параметры в зависимости от наличия колонки capacity
-    int paramCount = 7; // serial, part, mt, man, m, notes, invoice
-    if (columns.contains("capacity")) {
-        paramCount = 8;
+bool Database::searchInventory(const QString &searchText, QList<InventoryRow> &rows)
+{
+    if (searchText.isEmpty()) {
+        return getInventoryItems(rows);
     }
 
-    for (int i = 0; i < paramCount; i++) {
-        query.addBindValue(searchPattern);
+    QString searchPattern = ftsAvailable ? buildFtsMatchQuery(searchText)
+                                         : "%" + searchText + "%";
+    if (searchPattern.isEmpty()) {
+        return getInventoryItems(rows);
     }
 
-    if (query.exec()) {
-        while (query.next()) {
-            QVariantMap item;
-            item["id"] = query.value("id");
-            item["material_type"] = query.value("material_type");
-            item["manufacturer"] = query.value("manufacturer");
-            item["model"] = query.value("model");
-            item["part_number"] = query.value("part_number");
-            item["serial_number"] = query.value("serial_number");
-            item["capacity"] = query.value("capacity");
-            item["interface_type"] = query.value("interface_type");
-            item["notes"] = query.value("notes");
-            item["arrival_date"] = query.value("arrival_date");
-            item["invoice_number"] = query.value("invoice_number");
+    rows.clear();
 
-            if (columns.contains("created_at")) {
-                item["created_at"] = query.value("created_at");
-            }
+    QSqlQuery *query = cachedQuery(searchInventorySql);
+    if (!query) {
+        return false;
+    }
 
-            if (columns.contains("updated_at")) {
-                item["updated_at"] = query.value("updated_at");
-            }
+    for (int i = 0; i < searchParamCount; i++) {
+        query->bindValue(i, searchPattern);
+    }
+    if (ftsAvailable && trigramAvailable) {
+        query->bindValue(1, buildTrigramMatchQuery(QString(), searchText.trimmed()));
+    }
 
-            items.append(item);
-        }
-    } else {
-        qDebug() << "Search query error:" << query.lastError().text();
+    if (!query->exec()) {
+        qDebug() << "Search query error:" << query->lastError().text();
+        return false;
     }
 
-    return items;
+    while (query->next()) {
+        rows.append(InventoryRow());
+        inventoryRowFromQuery(*query, rows.last());
+    }
+
+    return true;
 }
 
 bool Database::deleteMaterialType(const QString &type)
@@ -1215,7 +2561,7 @@ bool Database::deleteMaterialType(const QString &type)
         return false;
     }
 
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("DELETE FROM material_types WHERE name = ?");
     query.addBindValue(type);
 
@@ -1223,6 +2569,7 @@ bool Database::deleteMaterialType(const QString &type)
 
     if (success) {
         qDebug() << "Deleted material type:" << type << "affected rows:" << query.numRowsAffected();
+        materialTypeNames.remove(materialTypeIds.take(type));
     } else {
         qDebug() << "Failed to delete material type:" << query.lastError().text();
     }
@@ -1235,12 +2582,8 @@ bool Database::isMaterialTypeUsed(const QString &type)
     int materialId = getMaterialTypeId(type);
     if (materialId == -1) return false;
 
-    QSqlQuery query;
-    query.prepare(
-        "SELECT COUNT(*) FROM inventory WHERE material_type_id = ? "
-        "UNION ALL "
-        "SELECT COUNT(*) FROM models WHERE material_type_id = ?"
-    );
+    QSqlQuery query(db);
+    query.prepare(dictionaryUsedSql("material_type_id"));
     query.addBindValue(materialId);
     query.addBindValue(materialId);
 
@@ -1264,7 +2607,7 @@ bool Database::deleteManufacturer(const QString &manufacturer)
         return false;
     }
 
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare("DELETE FROM manufacturers WHERE name = ?");
     query.addBindValue(manufacturer);
 
@@ -1272,6 +2615,7 @@ bool Database::deleteManufacturer(const QString &manufacturer)
 
     if (success) {
         qDebug() << "Deleted manufacturer:" << manufacturer << "affected rows:" << query.numRowsAffected();
+        manufacturerNames.remove(manufacturerIds.take(manufacturer));
     } else {
         qDebug() << "Failed to delete manufacturer:" << query.lastError().text();
     }
@@ -1284,12 +2628,8 @@ bool Database::isManufacturerUsed(const QString &manufacturer)
     int manufacturerId = getManufacturerId(manufacturer);
     if (manufacturerId == -1) return false;
 
-    QSqlQuery query;
-    query.prepare(
-        "SELECT COUNT(*) FROM inventory WHERE manufacturer_id = ? "
-        "UNION ALL "
-        "SELECT COUNT(*) FROM models WHERE manufacturer_id = ?"
-    );
+    QSqlQuery query(db);
+    query.prepare(dictionaryUsedSql("manufacturer_id"));
     query.addBindValue(manufacturerId);
     query.addBindValue(manufacturerId);
 
@@ -1322,7 +2662,7 @@ bool Database::deleteModel(const QString &materialType, const QString &manufactu
         return false;
     }
 
-    QSqlQuery query;
+    QSqlQuery query(db);
     query.prepare(
         "DELETE FROM models WHERE material_type_id = ? AND manufacturer_id = ? AND name = ?"
     );
@@ -1334,6 +2674,14 @@ bool Database::deleteModel(const QString &materialType, const QString &manufactu
 
     if (success) {
         qDebug() << "Deleted model:" << modelName << "affected rows:" << query.numRowsAffected();
+        QPair<int, int> key(materialId, manufacturerId);
+        auto pairIt = modelIndex.find(key);
+        if (pairIt != modelIndex.end()) {
+            pairIt.value().remove(modelName);
+            if (pairIt.value().isEmpty()) {
+                modelIndex.erase(pairIt);
+            }
+        }
     } else {
         qDebug() << "Failed to delete model:" << query.lastError().text();
     }
@@ -1346,8 +2694,8 @@ bool Database::isModelUsed(const QString &materialType, const QString &manufactu
     int modelId = getModelId(materialType, manufacturer, modelName);
     if (modelId == -1) return false;
 
-    QSqlQuery query;
-    query.prepare("SELECT COUNT(*) FROM inventory WHERE model_id = ?");
+    QSqlQuery query(db);
+    query.prepare(usageCountSql("model_id"));
     query.addBindValue(modelId);
 
     if (query.exec() && query.next()) {
@@ -1363,10 +2711,8 @@ int Database::getUsageCountForMaterialType(const QString &materialType)
     int materialId = getMaterialTypeId(materialType);
     if (materialId == -1) return 0;
 
-    QSqlQuery query;
-    query.prepare(
-        "SELECT COUNT(*) FROM inventory WHERE material_type_id = ?"
-    );
+    QSqlQuery query(db);
+    query.prepare(usageCountSql("material_type_id"));
     query.addBindValue(materialId);
 
     if (query.exec() && query.next()) {
@@ -1381,10 +2727,8 @@ int Database::getUsageCountForManufacturer(const QString &manufacturer)
     int manufacturerId = getManufacturerId(manufacturer);
     if (manufacturerId == -1) return 0;
 
-    QSqlQuery query;
-    query.prepare(
-        "SELECT COUNT(*) FROM inventory WHERE manufacturer_id = ?"
-    );
+    QSqlQuery query(db);
+    query.prepare(usageCountSql("manufacturer_id"));
     query.addBindValue(manufacturerId);
 
     if (query.exec() && query.next()) {
@@ -1409,8 +2753,8 @@ int Database::getUsageCountForModel(const QString &materialType, const QString &
         return 0;
     }
 
-    QSqlQuery query;
-    query.prepare("SELECT COUNT(*) FROM inventory WHERE model_id = ?");
+    QSqlQuery query(db);
+    query.prepare(usageCountSql("model_id"));
     query.addBindValue(modelId);
 
     if (query.exec() && query.next()) {
@@ -1431,38 +2775,48 @@ bool Database::markItemAsWrittenOff(int itemId, const QString &issuedTo,
         return false;
     }
 
-    QSqlQuery query;
+    QSqlQuery query(db);
 
-    // Начинаем транзакцию
-    db.transaction();
+    if (!db.transaction()) {
+        qDebug() << "Failed to start write-off transaction:" << db.lastError().text();
+        return false;
+    }
 
-    // 1. Обновляем статус в инвентаре
-    query.prepare("UPDATE inventory SET status = 'written_off' WHERE id = ?");
+    // 1. Добавляем запись в историю
+    query.prepare(writeOffHistoryItemInsertSql);
     query.addBindValue(itemId);
+    query.addBindValue(issuedTo.trimmed());
+    query.addBindValue(issueDate.toString("yyyy-MM-dd"));
+    query.addBindValue(comments.trimmed());
 
     if (!query.exec()) {
         db.rollback();
-        qDebug() << "Failed to update inventory status:" << query.lastError().text();
+        qDebug() << "Failed to add write-off history:" << query.lastError().text();
         return false;
     }
 
-    // 2. Добавляем запись в историю
-    query.prepare(
-        "INSERT INTO write_off_history (inventory_id, issued_to, issue_date, comments) "
-        "VALUES (?, ?, ?, ?)"
-    );
-    query.addBindValue(itemId);
+    QVariant historyId = query.lastInsertId();
+
+    // 2. Статус и ссылка на текущее списание в самой записи
+    query.prepare(writeOffItemStatusSql);
+    query.addBindValue(historyId);
     query.addBindValue(issuedTo.trimmed());
     query.addBindValue(issueDate.toString("yyyy-MM-dd"));
-    query.addBindValue(comments.trimmed());
+    query.addBindValue(itemId);
 
     if (!query.exec()) {
         db.rollback();
-        qDebug() << "Failed to add write-off history:" << query.lastError().text();
+        qDebug() << "Failed to update inventory status:" << query.lastError().text();
+        return false;
+    }
+
+    if (!db.commit()) {
+        qDebug() << "Failed to commit write-off:" << db.lastError().text();
+        db.rollback();
         return false;
     }
 
-    db.commit();
+    emit inventoryItemsChanged({itemId});
     return true;
 }
 
@@ -1472,15 +2826,19 @@ bool Database::markItemAsAvailable(int itemId)
         return false;
     }
 
-    QSqlQuery query;
-    query.prepare("UPDATE inventory SET status = 'available' WHERE id = ?");
+    // История остается архивом, у записи сбрасывается только текущее списание
+    QSqlQuery query(db);
+    query.prepare(returnItemsSql("?"));
     query.addBindValue(itemId);
 
     bool success = query.exec();
 
     if (success) {
-        // Можно очистить последнюю запись истории или оставить как архив
-        qDebug() << "Item" << itemId << "marked as available";
+        // Запись не была списана - менять и сообщать нечего
+        if (query.numRowsAffected() > 0) {
+            qDebug() << "Item" << itemId << "marked as available";
+            emit inventoryItemsChanged({itemId});
+        }
     } else {
         qDebug() << "Failed to mark item as available:" << query.lastError().text();
     }
@@ -1488,14 +2846,240 @@ bool Database::markItemAsAvailable(int itemId)
     return success;
 }
 
+QString Database::placeholderList(int count)
+{
+    QStringList placeholders;
+    for (int i = 0; i < count; ++i) {
+        placeholders << "?";
+    }
+    return placeholders.join(", ");
+}
+
+bool Database::markItemsAsWrittenOff(const QList<int> &itemIds, const QString &issuedTo,
+                                     const QDate &issueDate, const QString &comments)
+{
+    if (itemIds.isEmpty() || issuedTo.isEmpty()) {
+        return false;
+    }
+
+    QSqlQuery query(db);
+    if (!db.transaction()) {
+        qDebug() << "Failed to start write-off transaction:" << db.lastError().text();
+        return false;
+    }
+
+    // Уведомление - только о позициях, которые действительно списаны
+    QList<int> changedIds;
+
+    // Идентификаторы передаются частями: лимит параметров в старых SQLite - 999
+    const int chunkSize = 500;
+    for (int offset = 0; offset < itemIds.size(); offset += chunkSize) {
+        QList<int> chunk = itemIds.mid(offset, chunkSize);
+        QString inList = placeholderList(chunk.size());
+
+        // 0. Позиции, которые будут списаны (в той же транзакции - набор не изменится)
+        query.prepare(writeOffCandidatesSql(inList));
+        for (int id : chunk) {
+            query.addBindValue(id);
+        }
+
+        if (!query.exec()) {
+            db.rollback();
+            qDebug() << "Failed to select items for write-off:" << query.lastError().text();
+            return false;
+        }
+        while (query.next()) {
+            changedIds.append(query.value(0).toInt());
+        }
+
+        // 1. История одной вставкой; уже списанные позиции пропускаются
+        query.prepare(writeOffHistoryInsertSql(inList));
+        query.addBindValue(issuedTo.trimmed());
+        query.addBindValue(issueDate.toString("yyyy-MM-dd"));
+        query.addBindValue(comments.trimmed());
+        for (int id : chunk) {
+            query.addBindValue(id);
+        }
+
+        if (!query.exec()) {
+            db.rollback();
+            qDebug() << "Failed to add write-off history:" << query.lastError().text();
+            return false;
+        }
+
+        // 2. Статус и текущее списание одним UPDATE - только для позиций, получивших запись истории
+        query.prepare(writeOffStatusSql(inList));
+        query.addBindValue(issuedTo.trimmed());
+        query.addBindValue(issueDate.toString("yyyy-MM-dd"));
+        for (int id : chunk) {
+            query.addBindValue(id);
+        }
+
+        if (!query.exec()) {
+            db.rollback();
+            qDebug() << "Failed to update inventory status:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        qDebug() << "Failed to commit write-off:" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    qDebug() << changedIds.size() << "of" << itemIds.size() << "items marked as written off";
+    if (!changedIds.isEmpty()) {
+        emit inventoryItemsChanged(changedIds);
+    }
+    return true;
+}
+
+bool Database::markItemsAsAvailable(const QList<int> &itemIds)
+{
+    if (itemIds.isEmpty()) {
+        return false;
+    }
+
+    QSqlQuery query(db);
+    if (!db.transaction()) {
+        qDebug() << "Failed to start return transaction:" << db.lastError().text();
+        return false;
+    }
+
+    // Уведомление - только о позициях, которые действительно возвращены
+    QList<int> changedIds;
+
+    const int chunkSize = 500;
+    for (int offset = 0; offset < itemIds.size(); offset += chunkSize) {
+        QList<int> chunk = itemIds.mid(offset, chunkSize);
+        QString inList = placeholderList(chunk.size());
+
+        query.prepare(returnCandidatesSql(inList));
+        for (int id : chunk) {
+            query.addBindValue(id);
+        }
+
+        if (!query.exec()) {
+            db.rollback();
+            qDebug() << "Failed to select items for return:" << query.lastError().text();
+            return false;
+        }
+        while (query.next()) {
+            changedIds.append(query.value(0).toInt());
+        }
+
+        query.prepare(returnItemsSql(inList));
+        for (int id : chunk) {
+            query.addBindValue(id);
+        }
+
+        if (!query.exec()) {
+            db.rollback();
+            qDebug() << "Failed to mark items as available:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        qDebug() << "Failed to commit return:" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    qDebug() << changedIds.size() << "of" << itemIds.size() << "items marked as available";
+    if (!changedIds.isEmpty()) {
+        emit inventoryItemsChanged(changedIds);
+    }
+    return true;
+}
+
+bool Database::updateInventoryItems(const QList<int> &itemIds, InventoryFields fields, const InventoryRow &values)
+{
+    if (itemIds.isEmpty() || !fields) {
+        return false;
+    }
+
+    QStringList assignments;
+    QVariantList assignmentValues;
+
+    if (fields.testFlag(PartNumberField)) {
+        assignments << "part_number = ?";
+        assignmentValues << values.partNumber.trimmed();
+    }
+    if (fields.testFlag(CapacityField) && inventorySchema.hasCapacity) {
+        assignments << "capacity = ?";
+        assignmentValues << values.capacity.trimmed();
+    }
+    if (fields.testFlag(InterfaceTypeField)) {
+        assignments << "interface_type = ?";
+        assignmentValues << values.interfaceType.trimmed();
+    }
+    if (fields.testFlag(NotesField)) {
+        assignments << "notes = ?";
+        assignmentValues << values.notes.trimmed();
+    }
+    if (fields.testFlag(ArrivalDateField)) {
+        if (!values.arrivalDate.isValid()) {
+            qDebug() << "Mass edit: invalid arrival date";
+            return false;
+        }
+        assignments << "arrival_date = ?";
+        assignmentValues << values.arrivalDate.toString("yyyy-MM-dd");
+    }
+    if (fields.testFlag(InvoiceNumberField)) {
+        assignments << "invoice_number = ?";
+        assignmentValues << values.invoiceNumber.trimmed();
+    }
+
+    if (assignments.isEmpty()) {
+        return false;
+    }
+
+    QSqlQuery query(db);
+    if (!db.transaction()) {
+        qDebug() << "Failed to start mass edit transaction:" << db.lastError().text();
+        return false;
+    }
+
+    const int chunkSize = 500;
+    for (int offset = 0; offset < itemIds.size(); offset += chunkSize) {
+        QList<int> chunk = itemIds.mid(offset, chunkSize);
+
+        query.prepare(updateInventoryItemsSql(assignments, placeholderList(chunk.size())));
+        for (const QVariant &value : assignmentValues) {
+            query.addBindValue(value);
+        }
+        for (int id : chunk) {
+            query.addBindValue(id);
+        }
+
+        if (!query.exec()) {
+            db.rollback();
+            qDebug() << "Failed to update inventory items:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    if (!db.commit()) {
+        qDebug() << "Failed to commit mass edit:" << db.lastError().text();
+        db.rollback();
+        return false;
+    }
+
+    qDebug() << itemIds.size() << "items updated, fields:" << assignments.join(", ");
+    emit inventoryItemsChanged(itemIds);
+    return true;
+}
+
 bool Database::isItemWrittenOff(int itemId)
 {
     if (itemId <= 0) {
         return false;
     }
 
-    QSqlQuery query;
-    query.prepare("SELECT status FROM inventory WHERE id = ?");
+    QSqlQuery query(db);
+    query.prepare(itemStatusValueSql);
     query.addBindValue(itemId);
 
     if (query.exec() && query.next()) {
@@ -1514,87 +3098,228 @@ QVariantMap Database::getItemStatus(int itemId)
         return status;
     }
 
-    QSqlQuery query;
-    query.prepare(
-        "SELECT "
-        "i.status, "
-        "COALESCE(w.issued_to, '') as issued_to, "
-        "COALESCE(w.issue_date, '') as issue_date, "
-        "COALESCE(w.comments, '') as comments, "
-        "COALESCE(w.created_at, '') as write_off_date "
-        "FROM inventory i "
-        "LEFT JOIN write_off_history w ON i.id = w.inventory_id "
-        "WHERE i.id = ? "
-        "ORDER BY w.created_at DESC LIMIT 1"
-    );
+    QSqlQuery query(db);
+    query.prepare(itemStatusSql);
     query.addBindValue(itemId);
 
-    if (query.exec() && query.next()) {
-        status["status"] = query.value("status");
-        status["issued_to"] = query.value("issued_to");
-        status["issue_date"] = query.value("issue_date");
-        status["comments"] = query.value("comments");
-        status["write_off_date"] = query.value("write_off_date");
+    if (query.exec() && query.next()) {
+        status["status"] = query.value("status");
+        status["issued_to"] = query.value("issued_to");
+        status["issue_date"] = query.value("issue_date");
+        status["comments"] = query.value("comments");
+        status["write_off_date"] = query.value("write_off_date");
+    }
+
+    return status;
+}
+
+QString Database::writeOffHistorySql(int itemId)
+{
+    QString sql = writeOffHistorySelectSql + "WHERE 1=1";
+
+    if (itemId > 0) {
+        sql += " AND w.inventory_id = ?";
+    }
+
+    sql += " ORDER BY w.created_at DESC";
+    return sql;
+}
+
+QList<QVariantMap> Database::getWriteOffHistory(int itemId)
+{
+    QList<QVariantMap> history;
+
+    QSqlQuery query(db);
+    query.prepare(writeOffHistorySql(itemId));
+    if (itemId > 0) {
+        query.addBindValue(itemId);
+    }
+
+    if (query.exec()) {
+        while (query.next()) {
+            QVariantMap record;
+            record["id"] = query.value(WoId);
+            record["inventory_id"] = query.value(WoInventoryId);
+            record["serial_number"] = query.value(WoSerialNumber);
+            record["part_number"] = query.value(WoPartNumber);
+            record["material_type"] = query.value(WoMaterialType);
+            record["manufacturer"] = query.value(WoManufacturer);
+            record["model"] = query.value(WoModel);
+            record["issued_to"] = query.value(WoIssuedTo);
+            record["issue_date"] = query.value(WoIssueDate);
+            record["comments"] = query.value(WoComments);
+            record["created_at"] = query.value(WoCreatedAt);
+            history.append(record);
+        }
+    }
+
+    return history;
+}
+
+bool Database::getWriteOffHistory(int itemId, QList<WriteOffRecord> &records)
+{
+    records.clear();
+
+    QSqlQuery *query = cachedQuery(writeOffHistorySql(itemId));
+    if (!query) {
+        return false;
+    }
+    if (itemId > 0) {
+        query->bindValue(0, itemId);
+    }
+
+    if (!query->exec()) {
+        qDebug() << "Write-off history query error:" << query->lastError().text();
+        return false;
+    }
+
+    while (query->next()) {
+        records.append(WriteOffRecord());
+        writeOffRecordFromQuery(*query, records.last());
+    }
+
+    return true;
+}
+
+void Database::appendWriteOffFilter(const WriteOffFilter &filter, QString &sql, QVariantList &bindValues)
+{
+    // Получатель - по началу строки: диапазон по индексу (issued_to, issue_date)
+    if (!filter.issuedTo.isEmpty()) {
+        sql += " AND w.issued_to >= ? AND w.issued_to < ?";
+        bindValues << filter.issuedTo << filter.issuedTo + QChar(0xFFFF);
+    }
+
+    if (filter.dateFrom.isValid()) {
+        sql += " AND w.issue_date >= ?";
+        bindValues << filter.dateFrom.toString("yyyy-MM-dd");
+    }
+
+    if (filter.dateTo.isValid()) {
+        sql += " AND w.issue_date <= ?";
+        bindValues << filter.dateTo.toString("yyyy-MM-dd");
+    }
+
+    // Тип и серийный номер хранятся в inventory: сначала отбираются записи ЗИП,
+    // их история находится по индексу (inventory_id, created_at)
+    if (!filter.materialType.isEmpty()) {
+        sql += " AND w.inventory_id IN (SELECT id FROM inventory WHERE material_type_id = ?)";
+        bindValues << getMaterialTypeId(filter.materialType);
+    }
+
+    if (!filter.serialNumber.isEmpty()) {
+        if (trigramAvailable && filter.serialNumber.length() >= 3) {
+            sql += " AND w.inventory_id IN (SELECT rowid FROM inventory_codes_fts WHERE inventory_codes_fts MATCH ?)";
+            bindValues << buildTrigramMatchQuery("serial_number", filter.serialNumber);
+        } else {
+            sql += " AND w.inventory_id IN (SELECT id FROM inventory WHERE serial_number LIKE ?)";
+            bindValues << "%" + filter.serialNumber + "%";
+        }
+    }
+}
+
+QString Database::writeOffPageSql(const WriteOffFilter &filter, bool hasCursor, QVariantList &bindValues)
+{
+    QString sql = writeOffHistorySelectSql + "WHERE 1=1";
+
+    appendWriteOffFilter(filter, sql, bindValues);
+
+    // Keyset по индексу issue_date (id входит в индекс как rowid).
+    // Значения курсора и LIMIT добавляет вызывающий
+    if (hasCursor) {
+        sql += " AND (w.issue_date, w.id) < (?, ?)";
+    }
+
+    sql += " ORDER BY w.issue_date DESC, w.id DESC LIMIT ?";
+    return sql;
+}
+
+Database::WriteOffPage Database::getWriteOffHistoryPage(const QString &cursor, int limit,
+                                                       const WriteOffFilter &filter)
+{
+    WriteOffPage page;
+
+    if (limit <= 0) {
+        return page;
+    }
+
+    bool forward = true;
+    QString cursorDate;
+    int cursorId = 0;
+    bool hasCursor = !cursor.isEmpty();
+    if (hasCursor && !decodePageCursor(cursor, forward, cursorDate, cursorId)) {
+        qDebug() << "Invalid write-off page cursor:" << cursor;
+        return page;
+    }
+
+    QVariantList bindValues;
+    QString sql = writeOffPageSql(filter, hasCursor, bindValues);
+
+    if (hasCursor) {
+        bindValues << cursorDate << cursorId;
+    }
+
+    // Одна лишняя запись показывает, есть ли продолжение
+    bindValues << limit + 1;
+
+    QSqlQuery *query = cachedQuery(sql);
+    if (!query) {
+        return page;
+    }
+
+    for (int i = 0; i < bindValues.size(); ++i) {
+        query->bindValue(i, bindValues[i]);
+    }
+
+    if (!query->exec()) {
+        qDebug() << "Write-off page query error:" << query->lastError().text();
+        return page;
     }
 
-    return status;
+    while (query->next()) {
+        page.records.append(WriteOffRecord());
+        writeOffRecordFromQuery(*query, page.records.last());
+    }
+
+    if (page.records.size() > limit) {
+        page.records.removeLast();
+        const WriteOffRecord &last = page.records.last();
+        page.nextCursor = encodePageCursor(true, last.issueDate.toString("yyyy-MM-dd"), last.id);
+    }
+
+    return page;
 }
 
-QList<QVariantMap> Database::getWriteOffHistory(int itemId)
+int Database::getWriteOffHistoryCount(const WriteOffFilter &filter)
 {
-    QList<QVariantMap> history;
-
-    QSqlQuery query;
-    QString sql =
-        "SELECT "
-        "w.id, "
-        "w.inventory_id, "
-        "i.serial_number, "
-        "i.part_number, "
-        "mt.name as material_type, "
-        "man.name as manufacturer, "
-        "m.name as model, "
-        "w.issued_to, "
-        "w.issue_date, "
-        "w.comments, "
-        "w.created_at "
-        "FROM write_off_history w "
-        "JOIN inventory i ON w.inventory_id = i.id "
-        "JOIN material_types mt ON i.material_type_id = mt.id "
-        "JOIN manufacturers man ON i.manufacturer_id = man.id "
-        "JOIN models m ON i.model_id = m.id "
-        "WHERE 1=1";
+    QVariantList bindValues;
+    QString sql;
 
-    if (itemId > 0) {
-        sql += " AND w.inventory_id = ?";
+    // Общее число записей поддерживают триггеры, COUNT(*) по всей истории не нужен
+    if (filter.isEmpty()) {
+        sql = writeOffTotalSql;
+    } else {
+        sql = writeOffCountSql;
+        appendWriteOffFilter(filter, sql, bindValues);
     }
 
-    sql += " ORDER BY w.created_at DESC";
+    QSqlQuery *query = cachedQuery(sql);
+    if (!query) {
+        return -1;
+    }
 
-    query.prepare(sql);
-    if (itemId > 0) {
-        query.addBindValue(itemId);
+    for (int i = 0; i < bindValues.size(); ++i) {
+        query->bindValue(i, bindValues[i]);
     }
 
-    if (query.exec()) {
-        while (query.next()) {
-            QVariantMap record;
-            record["id"] = query.value("id");
-            record["inventory_id"] = query.value("inventory_id");
-            record["serial_number"] = query.value("serial_number");
-            record["part_number"] = query.value("part_number");
-            record["material_type"] = query.value("material_type");
-            record["manufacturer"] = query.value("manufacturer");
-            record["model"] = query.value("model");
-            record["issued_to"] = query.value("issued_to");
-            record["issue_date"] = query.value("issue_date");
-            record["comments"] = query.value("comments");
-            record["created_at"] = query.value("created_at");
-            history.append(record);
-        }
+    int count = -1;
+    if (query->exec() && query->next()) {
+        count = query->value(0).toInt();
+    } else {
+        qDebug() << "Write-off count query error:" << query->lastError().text();
     }
+    query->finish();
 
-    return history;
+    return count;
 }
 
 Database::DashboardStats Database::getDashboardStats()
@@ -1604,83 +3329,129 @@ Database::DashboardStats Database::getDashboardStats()
     stats.availableItems = 0;
     stats.writtenOffItems = 0;
 
-    QSqlQuery query;
-
-    // Общее количество
-    if (query.exec("SELECT COUNT(*) FROM inventory") && query.next()) {
-        stats.totalItems = query.value(0).toInt();
-    }
-
-    // По статусам
-    query.exec("SELECT status, COUNT(*) FROM inventory GROUP BY status");
-    while (query.next()) {
-        QString status = query.value(0).toString();
-        int count = query.value(1).toInt();
-        if (status == "available") {
-            stats.availableItems = count;
-        } else if (status == "written_off") {
-            stats.writtenOffItems = count;
+    // Счетчики поддерживаются триггерами
+    QSqlQuery *statsQuery = cachedQuery(dashboardStatsSql);
+    if (statsQuery && statsQuery->exec()) {
+        while (statsQuery->next()) {
+            QString scope = statsQuery->value(0).toString();
+            QString key = statsQuery->value(1).toString();
+            int count = statsQuery->value(2).toInt();
+            QString name = statsQuery->value(3).toString();
+
+            if (scope == "total") {
+                stats.totalItems = count;
+            } else if (scope == "status") {
+                if (key == "available") {
+                    stats.availableItems = count;
+                } else if (key == "written_off") {
+                    stats.writtenOffItems = count;
+                }
+            } else if (scope == "material_type") {
+                // Первые 10 по количеству
+                if (!name.isEmpty() && stats.itemsByType.size() < 10) {
+                    stats.itemsByType[name] = count;
+                }
+            } else if (scope == "manufacturer") {
+                if (!name.isEmpty() && stats.itemsByManufacturer.size() < 10) {
+                    stats.itemsByManufacturer[name] = count;
+                }
+            }
         }
+        statsQuery->finish();
     }
 
-    // По типам материалов
-    query.exec("SELECT mt.name, COUNT(*) FROM inventory i "
-               "JOIN material_types mt ON i.material_type_id = mt.id "
-               "GROUP BY mt.name ORDER BY COUNT(*) DESC LIMIT 10");
-    while (query.next()) {
-        stats.itemsByType[query.value(0).toString()] = query.value(1).toInt();
-    }
-
-    // По производителям
-    query.exec("SELECT m.name, COUNT(*) FROM inventory i "
-               "JOIN manufacturers m ON i.manufacturer_id = m.id "
-               "GROUP BY m.name ORDER BY COUNT(*) DESC LIMIT 10");
-    while (query.next()) {
-        stats.itemsByManufacturer[query.value(0).toString()] = query.value(1).toInt();
-    }
+    QSqlQuery query(db);
 
     // Недавняя активность (последние 10 добавлений/изменений)
-    query.exec("SELECT 'Добавлено: ' || mt.name || ' ' || m.name || ' (' || i.serial_number || ')' as text, "
-               "i.created_at as date FROM inventory i "
-               "JOIN material_types mt ON i.material_type_id = mt.id "
-               "JOIN models m ON i.model_id = m.id "
-               "WHERE i.created_at IS NOT NULL "
-               "ORDER BY i.created_at DESC LIMIT 5");
+    query.exec(recentActivitySql);
     while (query.next()) {
         QString text = query.value(0).toString();
         QString date = query.value(1).toDateTime().toString("dd.MM.yyyy HH:mm");
         stats.recentActivity.append(qMakePair(text, date)); // Теперь оба QString
     }
 
+    QDate currentDate = QDate::currentDate();
+    stats.monthlyActivity = getMonthlyRollup(currentDate.addMonths(-5), currentDate);
+
     return stats;
 }
 
 QList<QPair<QDate, int>> Database::getMonthlyStats(int months)
 {
     QList<QPair<QDate, int>> stats;
-    // QDate currentDate = QDate::currentDate();
 
-    QSqlQuery query;
-    query.prepare("SELECT strftime('%Y-%m', arrival_date) as month, COUNT(*) "
-                  "FROM inventory "
-                  "WHERE arrival_date >= date('now', ?) "
-                  "GROUP BY month ORDER BY month");
-
-    QString startDate = QString("-%1 months").arg(months);
-    query.addBindValue(startDate);
+    if (months <= 0) {
+        return stats;
+    }
 
-    if (query.exec()) {
-        while (query.next()) {
-            QString monthStr = query.value(0).toString();
-            int count = query.value(1).toInt();
-            QDate date = QDate::fromString(monthStr + "-01", "yyyy-MM-dd");
-            stats.append(qMakePair(date, count));
+    // months месяцев, последний из них - текущий
+    QDate currentDate = QDate::currentDate();
+    const QList<MonthlyRollup> rollup = getMonthlyRollup(currentDate.addMonths(-(months - 1)), currentDate);
+    for (const MonthlyRollup &month : rollup) {
+        if (month.arrivals > 0) {
+            stats.append(qMakePair(month.month, month.arrivals));
         }
     }
 
     return stats;
 }
 
+QList<Database::MonthlyRollup> Database::getMonthlyRollup(const QDate &from, const QDate &to,
+                                                          const QString &materialType)
+{
+    QList<MonthlyRollup> result;
+
+    // Чтение диапазона по первичному ключу (month, material_type_id)
+    // или по индексу (material_type_id, month) для одного типа
+    QString sql;
+    if (materialType.isEmpty()) {
+        sql = "SELECT month, 0, '', SUM(arrivals), SUM(write_offs), SUM(returns) "
+              "FROM monthly_rollup "
+              "WHERE month BETWEEN ? AND ? "
+              "GROUP BY month ORDER BY month";
+    } else {
+        sql = "SELECT r.month, r.material_type_id, mt.name, r.arrivals, r.write_offs, r.returns "
+              "FROM monthly_rollup r "
+              "JOIN material_types mt ON mt.id = r.material_type_id "
+              "WHERE r.month BETWEEN ? AND ? AND r.material_type_id = ? "
+              "ORDER BY r.month";
+    }
+
+    QSqlQuery *query = cachedQuery(sql);
+    if (!query) {
+        return result;
+    }
+
+    query->bindValue(0, from.toString("yyyy-MM"));
+    query->bindValue(1, to.toString("yyyy-MM"));
+    if (!materialType.isEmpty()) {
+        int materialId = getMaterialTypeId(materialType);
+        if (materialId == -1) {
+            return result;
+        }
+        query->bindValue(2, materialId);
+    }
+
+    if (!query->exec()) {
+        qDebug() << "Error loading monthly rollup:" << query->lastError().text();
+        return result;
+    }
+
+    while (query->next()) {
+        MonthlyRollup month;
+        month.month = QDate::fromString(query->value(0).toString() + "-01", "yyyy-MM-dd");
+        month.materialTypeId = query->value(1).toInt();
+        month.materialType = query->value(2).toString();
+        month.arrivals = query->value(3).toInt();
+        month.writeOffs = query->value(4).toInt();
+        month.returns = query->value(5).toInt();
+        result.append(month);
+    }
+    query->finish();
+
+    return result;
+}
+
 QList<QVariantMap> Database::getItemsForLabels(const QList<int> &itemIds)
 {
     QList<QVariantMap> items;
@@ -1689,24 +3460,22 @@ QList<QVariantMap> Database::getItemsForLabels(const QList<int> &itemIds)
         return items;
     }
 
-    QString ids;
-    for (int i = 0; i < itemIds.size(); ++i) {
-        if (i > 0) ids += ",";
-        ids += QString::number(itemIds[i]);
-    }
+    // Порциями, как и остальные пакетные операции: число параметров запроса ограничено
+    QSqlQuery query(db);
+    const int chunkSize = 500;
+    for (int offset = 0; offset < itemIds.size(); offset += chunkSize) {
+        QList<int> chunk = itemIds.mid(offset, chunkSize);
 
-    QString sql =
-        "SELECT i.id, mt.name as material_type, man.name as manufacturer, "
-        "m.name as model, i.part_number, i.serial_number, i.capacity, "
-        "i.arrival_date "
-        "FROM inventory i "
-        "JOIN material_types mt ON i.material_type_id = mt.id "
-        "JOIN manufacturers man ON i.manufacturer_id = man.id "
-        "JOIN models m ON i.model_id = m.id "
-        "WHERE i.id IN (" + ids + ")";
+        query.prepare(itemsForLabelsSql(placeholderList(chunk.size())));
+        for (int id : chunk) {
+            query.addBindValue(id);
+        }
+
+        if (!query.exec()) {
+            qDebug() << "Failed to load items for labels:" << query.lastError().text();
+            return items;
+        }
 
-    QSqlQuery query;
-    if (query.exec(sql)) {
         while (query.next()) {
             QVariantMap item;
             item["id"] = query.value("id");
@@ -1724,6 +3493,21 @@ QList<QVariantMap> Database::getItemsForLabels(const QList<int> &itemIds)
     return items;
 }
 
+QString Database::filteredInventorySql(const InventoryFilter &filter, QVariantList &bindValues)
+{
+    QString sql = inventoryColumnsSql +
+        "FROM inventory i "
+        "JOIN material_types mt ON i.material_type_id = mt.id "
+        "JOIN manufacturers man ON i.manufacturer_id = man.id "
+        "JOIN models m ON i.model_id = m.id "
+        "WHERE 1=1";
+
+    appendInventoryFilter(filter, sql, bindValues);
+
+    sql += " ORDER BY i.arrival_date DESC, i.id DESC";
+    return sql;
+}
+
 QList<QVariantMap> Database::getFilteredInventory(const QString &materialType,
                                                   const QString &manufacturer,
                                                   const QString &model,
@@ -1734,7 +3518,6 @@ QList<QVariantMap> Database::getFilteredInventory(const QString &materialType,
                                                   const QDate &dateTo)
 {
     QList<QVariantMap> items;
-    QStringList conditions;
     QVariantList bindValues;
 
     qDebug() << "=== getFilteredInventory ===";
@@ -1747,99 +3530,517 @@ QList<QVariantMap> Database::getFilteredInventory(const QString &materialType,
     qDebug() << "dateFrom:" << dateFrom;
     qDebug() << "dateTo:" << dateTo;
 
-    QString sql =
-        "SELECT i.id, i.status, mt.name as material_type, man.name as manufacturer, "
-        "m.name as model, i.part_number, i.serial_number, i.capacity, "
-        "i.interface_type, i.notes, i.arrival_date, i.invoice_number "
-        "FROM inventory i "
-        "JOIN material_types mt ON i.material_type_id = mt.id "
-        "JOIN manufacturers man ON i.manufacturer_id = man.id "
-        "JOIN models m ON i.model_id = m.id "
-        "WHERE 1=1";
+    InventoryFilter filter;
+    filter.materialType = materialType;
+    filter.manufacturer = manufacturer;
+    filter.model = model;
+    filter.partNumber = partNumber;
+    filter.serialNumber = serialNumber;
+    filter.status = status;
+    filter.dateFrom = dateFrom;
+    filter.dateTo = dateTo;
+    QString sql = filteredInventorySql(filter, bindValues);
 
-    if (!materialType.isEmpty()) {
-        sql += " AND mt.name = ?";
-        bindValues << materialType;
-        qDebug() << "Adding material condition:" << materialType;
+    qDebug() << "Final SQL:" << sql;
+    qDebug() << "Bind values count:" << bindValues.size();
+
+    QSqlQuery query(db);
+    query.prepare(sql);
+
+    for (int i = 0; i < bindValues.size(); ++i) {
+        query.addBindValue(bindValues[i]);
+        qDebug() << "Bind value" << i << ":" << bindValues[i].toString();
+    }
+
+    if (query.exec()) {
+        qDebug() << "Query executed successfully, rows returned:" << query.size();
+        while (query.next()) {
+            items.append(inventoryItemFromQuery(query));
+        }
+        qDebug() << "Items found:" << items.size();
+    } else {
+        qDebug() << "Query error:" << query.lastError().text();
+    }
+
+    return items;
+}
+
+bool Database::getFilteredInventory(const InventoryFilter &filter, QList<InventoryRow> &rows)
+{
+    rows.clear();
+
+    QVariantList bindValues;
+    QString sql = filteredInventorySql(filter, bindValues);
+
+    QSqlQuery query(db);
+    query.prepare(sql);
+    for (int i = 0; i < bindValues.size(); ++i) {
+        query.addBindValue(bindValues[i]);
     }
 
-    if (!manufacturer.isEmpty()) {
-        sql += " AND man.name = ?";
-        bindValues << manufacturer;
-        qDebug() << "Adding manufacturer condition:" << manufacturer;
+    if (!query.exec()) {
+        qDebug() << "Query error:" << query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        rows.append(InventoryRow());
+        inventoryRowFromQuery(query, rows.last());
+    }
+
+    return true;
+}
+
+void Database::appendInventoryFilter(const InventoryFilter &filter, QString &sql, QVariantList &bindValues)
+{
+    // Тип и производитель сравниваются по id из кэша справочников
+    if (!filter.materialType.isEmpty()) {
+        sql += " AND i.material_type_id = ?";
+        bindValues << getMaterialTypeId(filter.materialType);
+        qDebug() << "Adding material condition:" << filter.materialType;
     }
 
-    if (!model.isEmpty()) {
-        sql += " AND m.name = ?";
-        bindValues << model;
-        qDebug() << "Adding model condition:" << model;
+    if (!filter.manufacturer.isEmpty()) {
+        sql += " AND i.manufacturer_id = ?";
+        bindValues << getManufacturerId(filter.manufacturer);
+        qDebug() << "Adding manufacturer condition:" << filter.manufacturer;
     }
 
-    if (!partNumber.isEmpty()) {
-        sql += " AND i.part_number LIKE ?";
-        bindValues << "%" + partNumber + "%";
-        qDebug() << "Adding partNumber condition:" << partNumber;
+    if (!filter.model.isEmpty()) {
+        // Модели с таким названием у разных производителей - через индекс по model_id
+        sql += " AND i.model_id IN (SELECT id FROM models WHERE name = ?)";
+        bindValues << filter.model;
+        qDebug() << "Adding model condition:" << filter.model;
+    }
+
+    // Фрагменты от 3 символов ищутся по триграммному индексу, короткие - через LIKE
+    if (!filter.partNumber.isEmpty()) {
+        if (trigramAvailable && filter.partNumber.length() >= 3) {
+            sql += " AND i.id IN (SELECT rowid FROM inventory_codes_fts WHERE inventory_codes_fts MATCH ?)";
+            bindValues << buildTrigramMatchQuery("part_number", filter.partNumber);
+        } else {
+            sql += " AND i.part_number LIKE ?";
+            bindValues << "%" + filter.partNumber + "%";
+        }
+        qDebug() << "Adding partNumber condition:" << filter.partNumber;
     }
 
-    if (!serialNumber.isEmpty()) {
-        sql += " AND i.serial_number LIKE ?";
-        bindValues << "%" + serialNumber + "%";
-        qDebug() << "Adding serialNumber condition:" << serialNumber;
+    if (!filter.serialNumber.isEmpty()) {
+        if (trigramAvailable && filter.serialNumber.length() >= 3) {
+            sql += " AND i.id IN (SELECT rowid FROM inventory_codes_fts WHERE inventory_codes_fts MATCH ?)";
+            bindValues << buildTrigramMatchQuery("serial_number", filter.serialNumber);
+        } else {
+            sql += " AND i.serial_number LIKE ?";
+            bindValues << "%" + filter.serialNumber + "%";
+        }
+        qDebug() << "Adding serialNumber condition:" << filter.serialNumber;
     }
 
-    if (!status.isEmpty() && status != "all") {
+    if (!filter.status.isEmpty() && filter.status != "all") {
         sql += " AND i.status = ?";
-        bindValues << status;
-        qDebug() << "Adding status condition:" << status;
+        bindValues << filter.status;
+        qDebug() << "Adding status condition:" << filter.status;
     }
 
-    if (dateFrom.isValid()) {
+    if (filter.dateFrom.isValid()) {
         sql += " AND i.arrival_date >= ?";
-        bindValues << dateFrom.toString("yyyy-MM-dd");
-        qDebug() << "Adding dateFrom condition:" << dateFrom.toString("yyyy-MM-dd");
+        bindValues << filter.dateFrom.toString("yyyy-MM-dd");
+        qDebug() << "Adding dateFrom condition:" << filter.dateFrom.toString("yyyy-MM-dd");
     }
 
-    if (dateTo.isValid()) {
+    if (filter.dateTo.isValid()) {
         sql += " AND i.arrival_date <= ?";
-        bindValues << dateTo.toString("yyyy-MM-dd");
-        qDebug() << "Adding dateTo condition:" << dateTo.toString("yyyy-MM-dd");
+        bindValues << filter.dateTo.toString("yyyy-MM-dd");
+        qDebug() << "Adding dateTo condition:" << filter.dateTo.toString("yyyy-MM-dd");
     }
+}
 
-    sql += " ORDER BY i.arrival_date DESC, i.id DESC";
+QString Database::encodePageCursor(bool forward, const QVariantMap &item)
+{
+    // Курсор - позиция записи в порядке (arrival_date, id) и направление
+    return encodePageCursor(forward, item["arrival_date"].toString(), item["id"].toInt());
+}
 
-    qDebug() << "Final SQL:" << sql;
-    qDebug() << "Bind values count:" << bindValues.size();
+QString Database::encodePageCursor(bool forward, const QString &date, int id)
+{
+    QString raw = QString("%1:%2:%3")
+                      .arg(forward ? "n" : "p")
+                      .arg(date)
+                      .arg(id);
+    return QString::fromLatin1(raw.toUtf8().toBase64());
+}
 
-    QSqlQuery query;
-    query.prepare(sql);
+bool Database::decodePageCursor(const QString &cursor, bool &forward, QString &arrivalDate, int &id)
+{
+    QStringList parts = QString::fromUtf8(QByteArray::fromBase64(cursor.toLatin1())).split(':');
+    if (parts.size() != 3 || (parts[0] != "n" && parts[0] != "p")) {
+        return false;
+    }
+
+    bool ok = false;
+    forward = parts[0] == "n";
+    arrivalDate = parts[1];
+    id = parts[2].toInt(&ok);
+    return ok;
+}
+
+QString Database::inventoryPageSql(const InventoryFilter &filter, bool hasCursor, bool forward,
+                                   QVariantList &bindValues)
+{
+    QString sql = inventoryColumnsSql + inventoryJoinsSql + "WHERE 1=1";
+
+    appendInventoryFilter(filter, sql, bindValues);
+
+    // Keyset-пагинация по индексу (arrival_date, id): без OFFSET,
+    // стоимость не зависит от номера страницы. Значения курсора и LIMIT добавляет вызывающий
+    if (hasCursor) {
+        sql += forward ? " AND (i.arrival_date, i.id) < (?, ?)"
+                       : " AND (i.arrival_date, i.id) > (?, ?)";
+    }
+
+    sql += forward ? " ORDER BY i.arrival_date DESC, i.id DESC"
+                   : " ORDER BY i.arrival_date ASC, i.id ASC";
+    sql += " LIMIT ?";
+    return sql;
+}
+
+Database::InventoryPage Database::getInventoryPage(const QString &cursor, int limit,
+                                                   const InventoryFilter &filter)
+{
+    InventoryPage page;
+
+    if (limit <= 0) {
+        return page;
+    }
+
+    bool forward = true;
+    QString cursorDate;
+    int cursorId = 0;
+    bool hasCursor = !cursor.isEmpty();
+    if (hasCursor && !decodePageCursor(cursor, forward, cursorDate, cursorId)) {
+        qDebug() << "Invalid page cursor:" << cursor;
+        return page;
+    }
+
+    QVariantList bindValues;
+    QString sql = inventoryPageSql(filter, hasCursor, forward, bindValues);
+
+    if (hasCursor) {
+        bindValues << cursorDate << cursorId;
+    }
+
+    // Одна лишняя запись показывает, есть ли продолжение
+    bindValues << limit + 1;
+
+    QSqlQuery *query = cachedQuery(sql);
+    if (!query) {
+        return page;
+    }
 
     for (int i = 0; i < bindValues.size(); ++i) {
-        query.addBindValue(bindValues[i]);
-        qDebug() << "Bind value" << i << ":" << bindValues[i].toString();
+        query->bindValue(i, bindValues[i]);
     }
 
-    if (query.exec()) {
-        qDebug() << "Query executed successfully, rows returned:" << query.size();
+    if (!query->exec()) {
+        qDebug() << "Page query error:" << query->lastError().text();
+        return page;
+    }
+
+    while (query->next()) {
+        page.items.append(inventoryItemFromQuery(*query));
+    }
+
+    bool hasMore = page.items.size() > limit;
+    if (hasMore) {
+        page.items.removeLast();
+    }
+
+    if (!forward) {
+        // Назад выбирали в обратном порядке - разворачиваем
+        std::reverse(page.items.begin(), page.items.end());
+    }
+
+    if (page.items.isEmpty()) {
+        return page;
+    }
+
+    bool hasNext = forward ? hasMore : true;
+    bool hasPrevious = forward ? hasCursor : hasMore;
+
+    if (hasNext) {
+        page.nextCursor = encodePageCursor(true, page.items.last());
+    }
+    if (hasPrevious) {
+        page.previousCursor = encodePageCursor(false, page.items.first());
+    }
+
+    return page;
+}
+
+QString Database::inventoryByIdsSql(const InventoryFilter &filter, int idCount, QVariantList &bindValues)
+{
+    // Строки ищутся по первичному ключу, условия фильтра проверяются только на них.
+    // Значения id привязываются перед значениями фильтра
+    QString sql = inventoryColumnsSql + inventoryJoinsSql +
+                  "WHERE i.id IN (" + placeholderList(idCount) + ")";
+
+    appendInventoryFilter(filter, sql, bindValues);
+    return sql;
+}
+
+Database::InventoryRefresh Database::getInventoryItemsByIds(const QList<int> &itemIds,
+                                                            const InventoryFilter &filter)
+{
+    InventoryRefresh refresh;
+
+    const int chunkSize = 500;
+    for (int offset = 0; offset < itemIds.size(); offset += chunkSize) {
+        QList<int> chunk = itemIds.mid(offset, chunkSize);
+
+        QVariantList filterValues;
+        QSqlQuery query(db);
+        query.prepare(inventoryByIdsSql(filter, chunk.size(), filterValues));
+        for (int id : chunk) {
+            query.addBindValue(id);
+        }
+        for (const QVariant &value : filterValues) {
+            query.addBindValue(value);
+        }
+
+        if (!query.exec()) {
+            qDebug() << "Failed to load inventory items by id:" << query.lastError().text();
+            return refresh;
+        }
+
         while (query.next()) {
-            QVariantMap item;
-            item["id"] = query.value("id");
-            item["status"] = query.value("status");
-            item["material_type"] = query.value("material_type");
-            item["manufacturer"] = query.value("manufacturer");
-            item["model"] = query.value("model");
-            item["part_number"] = query.value("part_number");
-            item["serial_number"] = query.value("serial_number");
-            item["capacity"] = query.value("capacity");
-            item["interface_type"] = query.value("interface_type");
-            item["notes"] = query.value("notes");
-            item["arrival_date"] = query.value("arrival_date");
-            item["invoice_number"] = query.value("invoice_number");
-            items.append(item);
+            refresh.items.append(inventoryItemFromQuery(query));
         }
-        qDebug() << "Items found:" << items.size();
-    } else {
-        qDebug() << "Query error:" << query.lastError().text();
     }
 
-    return items;
+    refresh.ok = true;
+    return refresh;
+}
+
+QList<Database::QueryPlanEntry> Database::queryPlanCatalog()
+{
+    // Новый запрос в классе добавляется и сюда. Запросы, собираемые из частей,
+    // берутся из тех же функций, что используются при работе
+    QList<QueryPlanEntry> entries;
+    QVariantList unusedBinds;
+
+    QStringList types = getMaterialTypes();
+    QStringList manufacturers = getManufacturers();
+
+    // Основной список и поиск
+    entries << QueryPlanEntry{"getInventoryItems", selectInventorySql, "полный список по индексу (arrival_date, id)"};
+    entries << QueryPlanEntry{"getInventoryItemById", selectInventoryByIdSql, QString()};
+    entries << QueryPlanEntry{"searchInventory", searchInventorySql,
+                              ftsAvailable ? QString() : QString("LIKE без полнотекстового индекса")};
+    entries << QueryPlanEntry{"updateInventoryItem", updateInventorySql, QString()};
+    entries << QueryPlanEntry{"deleteInventoryItem", deleteInventoryItemSql, QString()};
+    entries << QueryPlanEntry{"checkSerialNumber", serialNumberCountSql, QString()};
+    entries << QueryPlanEntry{"checkSerialNumberOther", serialNumberOtherCountSql, QString()};
+    entries << QueryPlanEntry{"checkInventoryItemExists", inventoryItemExistsSql, QString()};
+    entries << QueryPlanEntry{"bulkInsertItem", bulkInsertItemSql, QString()};
+    entries << QueryPlanEntry{"getItemsForLabels", itemsForLabelsSql(placeholderList(3)), QString()};
+
+    // Фильтры: по одному условию, как их собирает appendInventoryFilter
+    QList<QPair<QString, InventoryFilter>> filters;
+    InventoryFilter filter;
+    filter.materialType = types.value(0);
+    filters << qMakePair(QString("materialType"), filter);
+    filter = InventoryFilter();
+    filter.manufacturer = manufacturers.value(0);
+    filters << qMakePair(QString("manufacturer"), filter);
+    filter = InventoryFilter();
+    filter.model = "model";
+    filters << qMakePair(QString("model"), filter);
+    filter = InventoryFilter();
+    filter.status = "written_off";
+    filters << qMakePair(QString("status"), filter);
+    filter = InventoryFilter();
+    filter.dateFrom = QDate::currentDate().addYears(-1);
+    filter.dateTo = QDate::currentDate();
+    filters << qMakePair(QString("dates"), filter);
+    filter = InventoryFilter();
+    filter.partNumber = "PN-1";
+    filters << qMakePair(QString("partNumber"), filter);
+    filter = InventoryFilter();
+    filter.serialNumber = "SN-1";
+    filters << qMakePair(QString("serialNumber"), filter);
+
+    const QString likeScan = trigramAvailable ? QString() : QString("LIKE без триграммного индекса");
+    for (const auto &named : filters) {
+        bool textFilter = named.first == "partNumber" || named.first == "serialNumber";
+        entries << QueryPlanEntry{"getFilteredInventory/" + named.first,
+                                  filteredInventorySql(named.second, unusedBinds),
+                                  textFilter ? likeScan : QString()};
+        entries << QueryPlanEntry{"getInventoryPage/" + named.first,
+                                  inventoryPageSql(named.second, true, true, unusedBinds),
+                                  textFilter ? likeScan : QString()};
+    }
+
+    const QString pageScan = "обход индекса (arrival_date, id), останавливается по LIMIT";
+    entries << QueryPlanEntry{"getInventoryPage/first", inventoryPageSql(InventoryFilter(), false, true, unusedBinds), pageScan};
+    entries << QueryPlanEntry{"getInventoryPage/next", inventoryPageSql(InventoryFilter(), true, true, unusedBinds), QString()};
+    entries << QueryPlanEntry{"getInventoryPage/previous", inventoryPageSql(InventoryFilter(), true, false, unusedBinds), QString()};
+    entries << QueryPlanEntry{"getInventoryItemsByIds", inventoryByIdsSql(InventoryFilter(), 3, unusedBinds), QString()};
+    filter = InventoryFilter();
+    filter.status = "available";
+    entries << QueryPlanEntry{"getInventoryItemsByIds/status", inventoryByIdsSql(filter, 3, unusedBinds), QString()};
+
+    // Справочники: проверки использования
+    entries << QueryPlanEntry{"isMaterialTypeUsed", dictionaryUsedSql("material_type_id"), QString()};
+    entries << QueryPlanEntry{"isManufacturerUsed", dictionaryUsedSql("manufacturer_id"), QString()};
+    entries << QueryPlanEntry{"getUsageCountForMaterialType", usageCountSql("material_type_id"), QString()};
+    entries << QueryPlanEntry{"getUsageCountForManufacturer", usageCountSql("manufacturer_id"), QString()};
+    entries << QueryPlanEntry{"getUsageCountForModel", usageCountSql("model_id"), QString()};
+    entries << QueryPlanEntry{"getMaterialTreeRows", materialTreeSql, QString()};
+    entries << QueryPlanEntry{"getModelItemCounts", modelItemCountsSql(placeholderList(3)), QString()};
+    entries << QueryPlanEntry{"itemModelId", itemModelIdSql, QString()};
+    // Тела триггеров полнотекстового индекса при переименовании в справочниках
+    entries << QueryPlanEntry{"material_types_fts_update", itemsByReferenceSql("material_type_id", "?"), QString()};
+    entries << QueryPlanEntry{"manufacturers_fts_update", itemsByReferenceSql("manufacturer_id", "?"), QString()};
+    entries << QueryPlanEntry{"models_fts_update", itemsByReferenceSql("model_id", "?"), QString()};
+
+    // Списание и возврат
+    entries << QueryPlanEntry{"markItemAsWrittenOff", writeOffItemStatusSql, QString()};
+    entries << QueryPlanEntry{"markItemAsAvailable", returnItemsSql("?"), QString()};
+    entries << QueryPlanEntry{"markItemsAsAvailable/select", returnCandidatesSql(placeholderList(3)), QString()};
+    entries << QueryPlanEntry{"markItemsAsAvailable/status", returnItemsSql(placeholderList(3)), QString()};
+    entries << QueryPlanEntry{"markItemsAsWrittenOff/select", writeOffCandidatesSql(placeholderList(3)), QString()};
+    entries << QueryPlanEntry{"markItemsAsWrittenOff/history", writeOffHistoryInsertSql(placeholderList(3)), QString()};
+    entries << QueryPlanEntry{"markItemsAsWrittenOff/status", writeOffStatusSql(placeholderList(3)), QString()};
+    // Действия внешних ключей выполняет сам SQLite: каскадное удаление истории
+    // и сброс ссылки на удаленную запись истории. Здесь - их эквивалент для проверки индексов
+    entries << QueryPlanEntry{"deleteInventoryItem/cascade",
+                              "DELETE FROM write_off_history WHERE inventory_id = ?", QString()};
+    entries << QueryPlanEntry{"write_off_history/set_null",
+                              "UPDATE inventory SET write_off_id = NULL WHERE write_off_id = ?", QString()};
+    entries << QueryPlanEntry{"updateInventoryItems",
+                              updateInventoryItemsSql({"part_number = ?", "notes = ?"}, placeholderList(3)),
+                              QString()};
+    entries << QueryPlanEntry{"isItemWrittenOff", itemStatusValueSql, QString()};
+    entries << QueryPlanEntry{"getItemStatus", itemStatusSql, QString()};
+    entries << QueryPlanEntry{"getWriteOffHistory/item", writeOffHistorySql(1), QString()};
+    entries << QueryPlanEntry{"getWriteOffHistory/all", writeOffHistorySql(-1),
+                              "вся история по индексу created_at"};
+
+    // Постраничная история: по одному условию, с курсором и без
+    QList<QPair<QString, WriteOffFilter>> writeOffFilters;
+    writeOffFilters << qMakePair(QString("all"), WriteOffFilter());
+    WriteOffFilter writeOffFilter;
+    writeOffFilter.issuedTo = "Иванов";
+    writeOffFilters << qMakePair(QString("issuedTo"), writeOffFilter);
+    writeOffFilter = WriteOffFilter();
+    writeOffFilter.dateFrom = QDate::currentDate().addYears(-1);
+    writeOffFilter.dateTo = QDate::currentDate();
+    writeOffFilters << qMakePair(QString("dates"), writeOffFilter);
+    writeOffFilter = WriteOffFilter();
+    writeOffFilter.materialType = types.value(0);
+    writeOffFilters << qMakePair(QString("materialType"), writeOffFilter);
+    writeOffFilter = WriteOffFilter();
+    writeOffFilter.serialNumber = "SN-1";
+    writeOffFilters << qMakePair(QString("serialNumber"), writeOffFilter);
+
+    for (const auto &named : writeOffFilters) {
+        bool serialFilter = named.first == "serialNumber";
+        QString countSql = writeOffCountSql;
+        appendWriteOffFilter(named.second, countSql, unusedBinds);
+
+        entries << QueryPlanEntry{"getWriteOffHistoryPage/" + named.first,
+                                  writeOffPageSql(named.second, false, unusedBinds),
+                                  named.first == "all" ? QString("обход индекса issue_date, останавливается по LIMIT")
+                                                       : serialFilter ? likeScan : QString()};
+        entries << QueryPlanEntry{"getWriteOffHistoryPage/next/" + named.first,
+                                  writeOffPageSql(named.second, true, unusedBinds),
+                                  serialFilter ? likeScan : QString()};
+        if (named.first != "all") {
+            entries << QueryPlanEntry{"getWriteOffHistoryCount/" + named.first, countSql,
+                                      serialFilter ? likeScan : QString()};
+        }
+    }
+    entries << QueryPlanEntry{"getWriteOffHistoryCount/all", writeOffTotalSql, QString()};
+
+    // Статистика
+    entries << QueryPlanEntry{"getDashboardStats/stats", dashboardStatsSql, QString()};
+    entries << QueryPlanEntry{"getDashboardStats/recent", recentActivitySql, QString()};
+    entries << QueryPlanEntry{"checkInventoryStats", inventoryStatsSourceSql,
+                              "пересчет счетчиков по всей таблице"};
+    entries << QueryPlanEntry{"monthly_rollup_write_off", itemMaterialTypeSql("?"), QString()};
+
+    return entries;
+}
+
+bool Database::checkQueryPlans(QStringList &report)
+{
+    // Имя таблицы, за которым может идти псевдоним (FROM inventory i, JOIN write_off_history w)
+    static const QRegularExpression tablePattern(
+        "\\b(inventory|write_off_history)\\b(?:\\s+(?:AS\\s+)?(\\w+))?",
+        QRegularExpression::CaseInsensitiveOption);
+    // "SCAN i", "SCAN i USING INDEX ...", в старых версиях SQLite "SCAN TABLE inventory AS i"
+    static const QRegularExpression scanPattern("^SCAN (?:TABLE )?(\\w+)(?: AS (\\w+))?");
+    static const QStringList keywords = {
+        "where", "set", "order", "group", "limit", "on", "join", "left", "inner",
+        "values", "when", "begin", "using", "union", "select"
+    };
+
+    bool success = true;
+    const QList<QueryPlanEntry> entries = queryPlanCatalog();
+
+    for (const QueryPlanEntry &entry : entries) {
+        QSet<QString> watchedNames;
+        QRegularExpressionMatchIterator tables = tablePattern.globalMatch(entry.sql);
+        while (tables.hasNext()) {
+            QRegularExpressionMatch match = tables.next();
+            watchedNames.insert(match.captured(1).toLower());
+            QString alias = match.captured(2).toLower();
+            if (!alias.isEmpty() && !keywords.contains(alias)) {
+                watchedNames.insert(alias);
+            }
+        }
+
+        QSqlQuery query(db);
+        if (!query.prepare("EXPLAIN QUERY PLAN " + entry.sql)) {
+            report << QString("ERROR %1: %2").arg(entry.name, query.lastError().text());
+            success = false;
+            continue;
+        }
+
+        // Значения параметров на план не влияют
+        int paramCount = entry.sql.count('?');
+        for (int i = 0; i < paramCount; ++i) {
+            query.bindValue(i, QVariant());
+        }
+
+        if (!query.exec()) {
+            report << QString("ERROR %1: %2").arg(entry.name, query.lastError().text());
+            success = false;
+            continue;
+        }
+
+        while (query.next()) {
+            QString detail = query.value(3).toString();
+            QRegularExpressionMatch scan = scanPattern.match(detail);
+            if (!scan.hasMatch()) {
+                continue;
+            }
+
+            bool watched = watchedNames.contains(scan.captured(1).toLower()) ||
+                           watchedNames.contains(scan.captured(2).toLower());
+            if (!watched) {
+                continue;
+            }
+
+            if (entry.allowedScan.isEmpty()) {
+                report << QString("FAIL %1: %2").arg(entry.name, detail);
+                success = false;
+            } else {
+                report << QString("allowed %1: %2 (%3)").arg(entry.name, detail, entry.allowedScan);
+            }
+        }
+    }
+
+    report << QString("%1 statements checked").arg(entries.size());
+    return success;
 }
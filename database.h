@@ -11,6 +11,7 @@
 #include <QDate>
 #include <QVariantMap>
 #include <QPair>
+#include <QHash>
 
 class Database : public QObject
 {
@@ -18,8 +19,54 @@ class Database : public QObject
 
 public:
     explicit Database(QObject *parent = nullptr);
+    // Соединение с указанным именем - для использования вне GUI-потока
+    explicit Database(const QString &connectionName, QObject *parent = nullptr);
     ~Database();
 
+    // Строка инвентаря: заполняется по номерам колонок, без QVariantMap
+    struct InventoryRow {
+        int id = 0;
+        QString status;
+        QString materialType;
+        QString manufacturer;
+        QString model;
+        QString partNumber;
+        QString serialNumber;
+        QString capacity;
+        QString interfaceType;
+        QString notes;
+        QDate arrivalDate;
+        QString invoiceNumber;
+        QString createdAt;
+        QString updatedAt;
+    };
+
+    // Запись истории списаний
+    struct WriteOffRecord {
+        int id = 0;
+        int inventoryId = 0;
+        QString serialNumber;
+        QString partNumber;
+        QString materialType;
+        QString manufacturer;
+        QString model;
+        QString issuedTo;
+        QDate issueDate;
+        QString comments;
+        QString createdAt;
+    };
+
+    // Движение по месяцам (таблица monthly_rollup). Для сводки по всем типам
+    // materialTypeId = 0 и materialType пустой
+    struct MonthlyRollup {
+        QDate month;          // Первое число месяца
+        int materialTypeId = 0;
+        QString materialType;
+        int arrivals = 0;
+        int writeOffs = 0;
+        int returns = 0;
+    };
+
     // Структура для статистики
     struct DashboardStats {
         int totalItems;
@@ -28,11 +75,19 @@ public:
         QMap<QString, int> itemsByType;
         QMap<QString, int> itemsByManufacturer;
         QList<QPair<QString, QString>> recentActivity; // Изменено: QString вместо int для даты
+        QList<MonthlyRollup> monthlyActivity; // Последние месяцы, все типы
     };
 
+    // Путь к файлу базы задается до initDatabase (по умолчанию zip_inventory.db в текущем каталоге)
+    void setDatabasePath(const QString &path);
+
     bool initDatabase();
     bool createTables();
 
+    // EXPLAIN QUERY PLAN для всех запросов класса: SCAN по inventory и write_off_history
+    // допускается только там, где он явно разрешен. В report - строка на каждое сканирование
+    bool checkQueryPlans(QStringList &report);
+
     // Методы для работы с материалами
     bool addMaterialType(const QString &type);
     QStringList getMaterialTypes();
@@ -52,6 +107,18 @@ public:
     bool deleteModel(const QString &materialType, const QString &manufacturer, const QString &modelName);
     bool isModelUsed(const QString &materialType, const QString &manufacturer, const QString &modelName);
 
+    // Дерево материалов одним запросом: тип -> производитель -> модель.
+    // Тип без моделей приходит одной строкой с пустыми manufacturer и model
+    struct MaterialTreeRow {
+        QString materialType;
+        QString manufacturer;
+        QString model;
+        int itemCount = 0;  // Записей инвентаря этой модели
+    };
+    QList<MaterialTreeRow> getMaterialTreeRows();
+    // Строки дерева только для указанных моделей (после добавления и удаления записей)
+    QList<MaterialTreeRow> getModelItemCounts(const QList<int> &modelIds);
+
     // Методы для работы с записями ЗИП
     bool addInventoryItem(const QString &materialType, const QString &manufacturer, const QString &modelName,
                           const QString &partNumber, const QString &serialNumber, const QString &capacity,
@@ -65,10 +132,37 @@ public:
 
     bool deleteInventoryItem(int itemId);
 
+    // Поля для массового редактирования
+    enum InventoryField {
+        PartNumberField    = 0x01,
+        CapacityField      = 0x02,
+        InterfaceTypeField = 0x04,
+        NotesField         = 0x08,
+        ArrivalDateField   = 0x10,
+        InvoiceNumberField = 0x20
+    };
+    Q_DECLARE_FLAGS(InventoryFields, InventoryField)
+
+    // Одно UPDATE ... WHERE id IN (...) для всех записей в одной транзакции.
+    // Значения берутся из values только для полей, отмеченных в fields
+    bool updateInventoryItems(const QList<int> &itemIds, InventoryFields fields, const InventoryRow &values);
+
+    // Пакетная вставка (импорт): одна транзакция, один подготовленный запрос.
+    // Занятый серийный номер отсекает сам INSERT (поиск по индексу на строку).
+    // Ошибка в строке не прерывает пакет - причина возвращается в error
+    bool beginBulkInsert();
+    bool bulkInsertItem(const InventoryRow &row, QString &error);
+    bool commitBulkInsert();
+    void rollbackBulkInsert();
+
     QList<QVariantMap> getInventoryItems();
     QVariantMap getInventoryItemById(int itemId);
     QList<QVariantMap> searchInventory(const QString &searchText);
 
+    // Типизированные варианты выборок
+    bool getInventoryItems(QList<InventoryRow> &rows);
+    bool searchInventory(const QString &searchText, QList<InventoryRow> &rows);
+
     // Новые методы для фильтрации
     QList<QVariantMap> getFilteredInventory(const QString &materialType = "",
                                             const QString &manufacturer = "",
@@ -89,31 +183,261 @@ public:
     bool markItemAsWrittenOff(int itemId, const QString &issuedTo,
                              const QDate &issueDate, const QString &comments);
     bool markItemAsAvailable(int itemId);
+    // Пакетные варианты: одна транзакция, история - одной вставкой
+    bool markItemsAsWrittenOff(const QList<int> &itemIds, const QString &issuedTo,
+                               const QDate &issueDate, const QString &comments);
+    bool markItemsAsAvailable(const QList<int> &itemIds);
     bool isItemWrittenOff(int itemId);
     QVariantMap getItemStatus(int itemId);
     QList<QVariantMap> getWriteOffHistory(int itemId = -1);
+    bool getWriteOffHistory(int itemId, QList<WriteOffRecord> &records);
 
     // Методы для статистики
     DashboardStats getDashboardStats();
+    // Сверка счетчиков inventory_stats с таблицей inventory, при расхождении - пересчет.
+    // false - только если пересчитать не удалось
+    bool checkInventoryStats();
+    // Поступления за последние months месяцев, включая текущий
     QList<QPair<QDate, int>> getMonthlyStats(int months = 6);
+    // Месяцы from..to включительно (учитываются только год и месяц) одним чтением
+    // по индексу. Пустой materialType - сумма по всем типам
+    QList<MonthlyRollup> getMonthlyRollup(const QDate &from, const QDate &to,
+                                          const QString &materialType = QString());
+
+    // Постраничная выборка (keyset по arrival_date, id)
+    struct InventoryFilter {
+        QString materialType;
+        QString manufacturer;
+        QString model;
+        QString partNumber;
+        QString serialNumber;
+        QString status;     // "" или "all" - без фильтра по статусу
+        QDate dateFrom;
+        QDate dateTo;
+    };
+
+    struct InventoryPage {
+        QList<QVariantMap> items;
+        QString nextCursor;     // Пустой - дальше записей нет
+        QString previousCursor; // Пустой - это первая страница
+    };
+
+    InventoryPage getInventoryPage(const QString &cursor = QString(), int limit = 200,
+                                   const InventoryFilter &filter = InventoryFilter());
+
+    // Текущие строки по списку id - для обновления уже показанного списка после изменений.
+    // Удаленные и не подходящие под filter записи в items не попадают
+    struct InventoryRefresh {
+        bool ok = false;        // false - запрос не выполнен, items не полный
+        QList<QVariantMap> items;
+    };
+
+    InventoryRefresh getInventoryItemsByIds(const QList<int> &itemIds,
+                                            const InventoryFilter &filter = InventoryFilter());
+
+    // Постраничная история списаний (keyset по issue_date, id, новые выдачи первыми)
+    struct WriteOffFilter {
+        QString issuedTo;       // Начало имени получателя, с учетом регистра
+        QDate dateFrom;         // Период по дате выдачи
+        QDate dateTo;
+        QString materialType;
+        QString serialNumber;   // Фрагмент серийного номера
+
+        bool isEmpty() const
+        {
+            return issuedTo.isEmpty() && !dateFrom.isValid() && !dateTo.isValid() &&
+                   materialType.isEmpty() && serialNumber.isEmpty();
+        }
+    };
+
+    struct WriteOffPage {
+        QList<WriteOffRecord> records;
+        QString nextCursor;     // Пустой - дальше записей нет
+    };
+
+    WriteOffPage getWriteOffHistoryPage(const QString &cursor = QString(), int limit = 200,
+                                        const WriteOffFilter &filter = WriteOffFilter());
+    // Без фильтра - счетчик из inventory_stats, с фильтром - COUNT по индексу условия. -1 при ошибке
+    int getWriteOffHistoryCount(const WriteOffFilter &filter = WriteOffFilter());
+
+    bool getFilteredInventory(const InventoryFilter &filter, QList<InventoryRow> &rows);
 
     // Методы для печати этикеток
     QList<QVariantMap> getItemsForLabels(const QList<int> &itemIds);
 
+    // Соединение только для чтения, своё для каждого потока (для пула потоков).
+    // Возвращает nullptr, если открыть соединение не удалось
+    static Database *readerForCurrentThread();
+    // Справочники изменены через другое соединение: каждое соединение чтения
+    // перечитает их при следующей выдаче readerForCurrentThread()
+    static void invalidateReaderDictionaries();
+
+    // Ожидание блокировки файла другими соединениями, мс
+    static const int busyTimeoutMs = 5000;
+
+    // Профили настройки хранилища: synchronous, cache_size, mmap_size, temp_store
+    enum StorageProfile {
+        DesktopSafeProfile, // "desktop-safe" - по умолчанию
+        BulkLoadProfile,    // "bulk-load" - только на время импорта: без fsync, сбой может повредить файл
+        ReadMostlyProfile   // "read-mostly" - киоск/просмотр, больше кэша
+    };
+
+    static QString storageProfileName(StorageProfile profile);
+    static StorageProfile storageProfileFromName(const QString &name);
+
+    // Профиль из настроек приложения (storage/profile), применяется при открытии соединений.
+    // bulk-load в настройках не сохраняется: false
+    static StorageProfile configuredStorageProfile();
+    static bool setConfiguredStorageProfile(StorageProfile profile);
+
+    // Применяется к этому соединению сразу
+    bool applyStorageProfile(StorageProfile profile);
+    // Для всех соединений чтения: каждое переключается при следующей выдаче readerForCurrentThread()
+    static void setReaderStorageProfile(StorageProfile profile);
+    StorageProfile storageProfile() const;
+
+    // Временное переключение профиля, например на время импорта
+    class ScopedStorageProfile
+    {
+    public:
+        ScopedStorageProfile(Database *database, StorageProfile profile);
+        ~ScopedStorageProfile();
+
+    private:
+        Database *database;
+        StorageProfile previousProfile;
+    };
+
+    // Перечитать справочники после изменений через другое соединение
+    void reloadDictionaryCache();
+
+    // Статистика кэша подготовленных запросов
+    int statementCacheHits() const;
+    int statementCacheMisses() const;
+
+signals:
+    // Записи инвентаря изменены через это соединение (после фиксации транзакции).
+    // Пакетный импорт уведомлений по записям не дает
+    void inventoryItemsAdded(const QList<int> &itemIds);
+    void inventoryItemsChanged(const QList<int> &itemIds);
+    void inventoryItemsRemoved(const QList<int> &itemIds);
+    // Изменилось число записей моделей: добавление, удаление, смена модели записи
+    void modelItemCountsChanged(const QList<int> &modelIds);
+
 private:
     QSqlDatabase db;
     QString databasePath;
+    QString connectionName; // Пустое - соединение по умолчанию
+    StorageProfile currentStorageProfile = DesktopSafeProfile;
+
+    // Состояние пакетной вставки
+    bool bulkInsertActive = false;
+
+    // Кэш подготовленных запросов: ключ - текст SQL, живут до закрытия соединения
+    QHash<QString, QSqlQuery*> statementCache;
+    int cacheHits;
+    int cacheMisses;
+
+    bool openReadConnection();
+    void configureConnection();
+
+    QSqlQuery *cachedQuery(const QString &sql);
+    void clearStatementCache();
+
+    // Снимок структуры таблицы inventory, фиксируется после миграций
+    struct InventorySchema {
+        bool hasStatus = false;
+        bool hasCapacity = false;
+        bool hasCreatedAt = false;
+        bool hasUpdatedAt = false;
+    };
+    InventorySchema inventorySchema;
+
+    // Заранее собранные под снимок структуры запросы
+    QString selectInventorySql;
+    QString selectInventoryByIdSql;
+    QString searchInventorySql;
+    int searchParamCount = 0;
+    QString updateInventorySql;
+    QString inventoryColumnsSql; // SELECT-часть без FROM
+    QString inventoryJoinsSql;   // FROM inventory i с LEFT JOIN справочников
+
+    void refreshSchemaSnapshot();
+    QVariantMap inventoryItemFromQuery(const QSqlQuery &query) const;
+    static void inventoryRowFromQuery(const QSqlQuery &query, InventoryRow &row);
+    static void writeOffRecordFromQuery(const QSqlQuery &query, WriteOffRecord &record);
+    QString filteredInventorySql(const InventoryFilter &filter, QVariantList &bindValues);
+    static QString writeOffHistorySql(int itemId);
+    void appendWriteOffFilter(const WriteOffFilter &filter, QString &sql, QVariantList &bindValues);
+    QString writeOffPageSql(const WriteOffFilter &filter, bool hasCursor, QVariantList &bindValues);
+
+    // Полнотекстовый индекс для поиска (FTS5)
+    bool ftsAvailable = false;
+    bool trigramAvailable = false;
+    void detectSearchIndexes();
+    static QString buildFtsMatchQuery(const QString &searchText);
+    static QString buildTrigramMatchQuery(const QString &column, const QString &fragment);
+
+    // Кэш справочников: загружается при старте и обновляется в addX/deleteX
+    QHash<QString, int> materialTypeIds;
+    QHash<int, QString> materialTypeNames;
+    QHash<QString, int> manufacturerIds;
+    QHash<int, QString> manufacturerNames;
+    // (тип материала, производитель) -> (название модели -> id)
+    QHash<QPair<int, int>, QHash<QString, int>> modelIndex;
+
+    void loadDictionaryCache();
+    int dictionaryGeneration = 0; // Версия справочников, загруженных соединением чтения
+
+    void appendInventoryFilter(const InventoryFilter &filter, QString &sql, QVariantList &bindValues);
+    QString inventoryPageSql(const InventoryFilter &filter, bool hasCursor, bool forward, QVariantList &bindValues);
+    QString inventoryByIdsSql(const InventoryFilter &filter, int idCount, QVariantList &bindValues);
+    static QString encodePageCursor(bool forward, const QVariantMap &item);
+    static QString encodePageCursor(bool forward, const QString &date, int id);
+    static bool decodePageCursor(const QString &cursor, bool &forward, QString &arrivalDate, int &id);
 
     // Вспомогательные методы
+    static QString placeholderList(int count);
     int getMaterialTypeId(const QString &materialType);
     int getManufacturerId(const QString &manufacturer);
     int getModelId(const QString &materialType, const QString &manufacturer, const QString &modelName);
-    bool recreateTableWithStatus();
+    int itemModelId(int itemId); // -1, если записи нет
+
+    // Миграции структуры БД: номер последней примененной хранится в PRAGMA user_version,
+    // каждая выполняется в своей транзакции
+    struct Migration {
+        int version;
+        const char *description;
+        bool (Database::*apply)();
+    };
+    static const QList<Migration> &migrations();
+    bool runMigrations();
+    bool migrateInitialSchema();
+    bool migrateArrivalIdIndex();
+    bool migrateSearchIndexes();
+    bool migrateInventoryStats();
+    bool migrateMonthlyRollup();
+    bool migrateLookupIndexes();
+    bool migrateCurrentWriteOff();
+    bool migrateWriteOffPaging();
+    bool migrateRecentActivityIndex();
+
+    // Запросы для проверки планов; allowedScan - почему сканирование допустимо
+    struct QueryPlanEntry {
+        QString name;
+        QString sql;
+        QString allowedScan;
+    };
+    QList<QueryPlanEntry> queryPlanCatalog();
+    bool rebuildInventoryStats();
 
     // Методы для работы со структурой БД
-    bool updateDatabaseStructure();
+    bool hasUniqueSerialConstraint();
+    bool rebuildInventoryTable(const QStringList &oldColumns);
     QStringList getTableColumns(const QString &tableName);
 
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Database::InventoryFields)
+
 #endif // DATABASE_H
@@ -0,0 +1,15 @@
+# Слой данных: общий для приложения и проектов в tests/
+QT *= core sql
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/database.cpp \
+    $$PWD/asyncdatabase.cpp \
+    $$PWD/inventoryimporter.cpp
+
+HEADERS += \
+    $$PWD/database.h \
+    $$PWD/asyncdatabase.h \
+    $$PWD/inventoryimporter.h
@@ -0,0 +1,231 @@
+#include "inventoryimporter.h"
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+
+InventoryImporter::InventoryImporter(Database *database)
+    : database(database)
+{
+}
+
+InventoryImporter::Report InventoryImporter::importCsv(const QString &fileName)
+{
+    Report report;
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        report.fatalError = "Не удалось открыть файл";
+        return report;
+    }
+
+    QTextStream stream(&file);
+    #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        stream.setEncoding(QStringConverter::Utf8);
+    #else
+        stream.setCodec("UTF-8");
+    #endif
+
+    // Разделитель определяется по строке заголовка (экспорт программы использует ';')
+    QString headerLine = stream.readLine();
+    QChar delimiter = detectDelimiter(headerLine);
+    QTextStream headerStream(&headerLine, QIODevice::ReadOnly);
+    QStringList header;
+    int lineNumber = 0;
+    readRecord(headerStream, delimiter, header, lineNumber);
+
+    QHash<int, Field> columns = mapHeader(header);
+    QList<Field> mapped = columns.values();
+    if (!mapped.contains(MaterialTypeField) || !mapped.contains(ManufacturerField) ||
+        !mapped.contains(ModelField)) {
+        report.fatalError = "В заголовке нет колонок типа материала, производителя и модели";
+        return report;
+    }
+
+    // Импорт без fsync на каждую запись; прежний профиль вернется по выходу из блока
+    Database::ScopedStorageProfile bulkProfile(database, Database::BulkLoadProfile);
+
+    if (!database->beginBulkInsert()) {
+        report.fatalError = "Не удалось начать транзакцию";
+        return report;
+    }
+
+    QStringList fields;
+    while (true) {
+        int recordLine = lineNumber + 1;
+        if (!readRecord(stream, delimiter, fields, lineNumber)) {
+            break;
+        }
+
+        // Пустые строки в конце таблицы
+        if (fields.join(QString()).trimmed().isEmpty()) {
+            continue;
+        }
+
+        Database::InventoryRow row;
+        QString dateError;
+        for (auto it = columns.constBegin(); it != columns.constEnd(); ++it) {
+            if (it.key() >= fields.size()) {
+                continue;
+            }
+            const QString &value = fields.at(it.key());
+
+            switch (it.value()) {
+            case MaterialTypeField:  row.materialType = value; break;
+            case ManufacturerField:  row.manufacturer = value; break;
+            case ModelField:         row.model = value; break;
+            case PartNumberField:    row.partNumber = value; break;
+            case SerialNumberField:  row.serialNumber = value; break;
+            case CapacityField:      row.capacity = value; break;
+            case InterfaceTypeField: row.interfaceType = value; break;
+            case NotesField:         row.notes = value; break;
+            case InvoiceNumberField: row.invoiceNumber = value; break;
+            case ArrivalDateField:
+                row.arrivalDate = parseDate(value);
+                if (!value.trimmed().isEmpty() && !row.arrivalDate.isValid()) {
+                    dateError = QString("Неверная дата: %1").arg(value);
+                }
+                break;
+            }
+        }
+
+        QString error = dateError;
+        if (error.isEmpty() && database->bulkInsertItem(row, error)) {
+            report.imported++;
+            continue;
+        }
+
+        report.failed++;
+        if (report.errors.size() < maxReportedErrors) {
+            report.errors.append(QString("Строка %1: %2").arg(recordLine).arg(error));
+        }
+    }
+
+    if (!database->commitBulkInsert()) {
+        report.fatalError = "Не удалось записать данные";
+        report.imported = 0;
+    }
+
+    report.elapsedMs = timer.elapsed();
+    qDebug() << "CSV import finished:" << report.imported << "imported,"
+             << report.failed << "failed in" << report.elapsedMs << "ms";
+
+    return report;
+}
+
+QChar InventoryImporter::detectDelimiter(const QString &headerLine)
+{
+    int semicolons = headerLine.count(';');
+    int commas = headerLine.count(',');
+    int tabs = headerLine.count('\t');
+
+    if (tabs > semicolons && tabs > commas) {
+        return '\t';
+    }
+    return commas > semicolons ? QChar(',') : QChar(';');
+}
+
+bool InventoryImporter::readRecord(QTextStream &stream, QChar delimiter, QStringList &fields, int &lineNumber)
+{
+    fields.clear();
+    if (stream.atEnd()) {
+        return false;
+    }
+
+    QString field;
+    bool inQuotes = false;
+
+    // Поле в кавычках может содержать перевод строки - дочитываем следующие строки
+    do {
+        QString line = stream.readLine();
+        lineNumber++;
+
+        for (int i = 0; i < line.size(); ++i) {
+            QChar c = line.at(i);
+            if (inQuotes) {
+                if (c == '"') {
+                    if (i + 1 < line.size() && line.at(i + 1) == '"') {
+                        field += '"';
+                        ++i;
+                    } else {
+                        inQuotes = false;
+                    }
+                } else {
+                    field += c;
+                }
+            } else if (c == '"') {
+                inQuotes = true;
+            } else if (c == delimiter) {
+                fields.append(field);
+                field.clear();
+            } else {
+                field += c;
+            }
+        }
+
+        if (inQuotes) {
+            field += '\n';
+        }
+    } while (inQuotes && !stream.atEnd());
+
+    fields.append(field);
+    return true;
+}
+
+QHash<int, InventoryImporter::Field> InventoryImporter::mapHeader(const QStringList &header)
+{
+    // Русские заголовки совпадают с отчетом "Текущий инвентарь"
+    static const QHash<QString, Field> names = {
+        {"тип", MaterialTypeField},
+        {"тип материала", MaterialTypeField},
+        {"material_type", MaterialTypeField},
+        {"производитель", ManufacturerField},
+        {"manufacturer", ManufacturerField},
+        {"модель", ModelField},
+        {"model", ModelField},
+        {"part number", PartNumberField},
+        {"part_number", PartNumberField},
+        {"серийный номер", SerialNumberField},
+        {"serial_number", SerialNumberField},
+        {"объем", CapacityField},
+        {"объём", CapacityField},
+        {"capacity", CapacityField},
+        {"интерфейс", InterfaceTypeField},
+        {"interface_type", InterfaceTypeField},
+        {"примечание", NotesField},
+        {"notes", NotesField},
+        {"дата прихода", ArrivalDateField},
+        {"дата поступления", ArrivalDateField},
+        {"arrival_date", ArrivalDateField},
+        {"накладная", InvoiceNumberField},
+        {"номер накладной", InvoiceNumberField},
+        {"invoice_number", InvoiceNumberField}
+    };
+
+    QHash<int, Field> columns;
+    for (int i = 0; i < header.size(); ++i) {
+        QString name = header.at(i);
+        name.remove(QChar(0xFEFF)); // BOM в начале файла из Excel
+        name = name.trimmed().toLower();
+        auto it = names.constFind(name);
+        if (it != names.constEnd()) {
+            columns.insert(i, it.value());
+        }
+    }
+    return columns;
+}
+
+QDate InventoryImporter::parseDate(const QString &text)
+{
+    QString value = text.trimmed();
+    if (value.isEmpty()) {
+        return QDate();
+    }
+
+    QDate date = QDate::fromString(value, "yyyy-MM-dd");
+    if (!date.isValid()) {
+        date = QDate::fromString(value, "dd.MM.yyyy");
+    }
+    return date;
+}
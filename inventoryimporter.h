@@ -0,0 +1,51 @@
+#ifndef INVENTORYIMPORTER_H
+#define INVENTORYIMPORTER_H
+
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include "database.h"
+
+// Импорт поставок из CSV-файла поставщика.
+// Файл читается построчно, все строки вставляются в одной транзакции;
+// ошибочные строки пропускаются и попадают в отчет.
+class InventoryImporter
+{
+public:
+    struct Report {
+        int imported = 0;
+        int failed = 0;
+        QStringList errors;   // "Строка N: причина" (не больше maxReportedErrors)
+        QString fatalError;   // Файл не прочитан или транзакция не записана
+        qint64 elapsedMs = 0;
+    };
+
+    static const int maxReportedErrors = 500;
+
+    explicit InventoryImporter(Database *database);
+
+    Report importCsv(const QString &fileName);
+
+private:
+    enum Field {
+        MaterialTypeField,
+        ManufacturerField,
+        ModelField,
+        PartNumberField,
+        SerialNumberField,
+        CapacityField,
+        InterfaceTypeField,
+        NotesField,
+        ArrivalDateField,
+        InvoiceNumberField
+    };
+
+    Database *database;
+
+    static QChar detectDelimiter(const QString &headerLine);
+    static bool readRecord(QTextStream &stream, QChar delimiter, QStringList &fields, int &lineNumber);
+    static QHash<int, Field> mapHeader(const QStringList &header);
+    static QDate parseDate(const QString &text);
+};
+
+#endif // INVENTORYIMPORTER_H
@@ -0,0 +1,202 @@
+#include "inventorysearch.h"
+#include "asyncdatabase.h"
+#include <QTimer>
+#include <QDebug>
+
+InventorySearch::InventorySearch(AsyncDatabase *asyncDb, const QString &requestKey, QObject *parent)
+    : QObject(parent)
+    , asyncDb(asyncDb)
+    , requestKey(requestKey)
+    , debounceTimer(new QTimer(this))
+    , generation(0)
+    , hasResults(false)
+{
+    debounceTimer->setSingleShot(true);
+    debounceTimer->setInterval(debounceMs);
+    connect(debounceTimer, &QTimer::timeout, this, &InventorySearch::runSearch);
+}
+
+void InventorySearch::setText(const QString &text)
+{
+    pendingText = text.simplified();
+
+    if (pendingText.isEmpty()) {
+        // Очистка показывается сразу, ответ на последний запрос уже не нужен
+        debounceTimer->stop();
+        ++generation;
+        hasResults = false;
+        results.clear();
+        emit cleared();
+        return;
+    }
+
+    // Текст отличается только пробелами - показан уже нужный результат
+    if (hasResults && pendingText == resultText) {
+        debounceTimer->stop();
+        ++generation;
+        return;
+    }
+
+    if (canNarrow(pendingText)) {
+        debounceTimer->stop();
+        narrowTo(pendingText);
+        return;
+    }
+
+    debounceTimer->start();
+}
+
+void InventorySearch::invalidate()
+{
+    hasResults = false;
+    results.clear();
+}
+
+void InventorySearch::runSearch()
+{
+    int requestGeneration = ++generation;
+    QString text = pendingText;
+
+    // Запрос с тем же ключом отменяет предыдущий, если тот еще не начал выполняться
+    AsyncDatabase::watch(asyncDb->searchInventory(text, requestKey), this,
+                         [this, requestGeneration, text](const QList<QVariantMap> &items) {
+        if (requestGeneration != generation) {
+            return;
+        }
+
+        hasResults = true;
+        resultText = text;
+        results = items;
+
+        // Пока шел запрос, текст успели дополнить - сужаем, не дожидаясь паузы
+        if (debounceTimer->isActive() && canNarrow(pendingText)) {
+            debounceTimer->stop();
+            narrowTo(pendingText);
+            return;
+        }
+
+        emit resultsReady(results);
+    });
+}
+
+bool InventorySearch::canNarrow(const QString &text) const
+{
+    // Результат по более длинному тексту - подмножество прежнего: префиксы слов (FTS),
+    // подстроки (триграммы, LIKE). Триграммный индекс не ищет фрагменты короче
+    // 3 символов, поэтому по такому короткому тексту найдено не все, что нужно сузить
+    return hasResults && resultText.length() >= 3 && text.startsWith(resultText);
+}
+
+void InventorySearch::narrowTo(const QString &text)
+{
+    ++generation;
+
+    // Слово запроса в кавычках: его токены должны идти подряд, последний - префиксом
+    QList<QStringList> phrases;
+    for (const QString &word : text.split(' ', Qt::SkipEmptyParts)) {
+        phrases.append(tokens(word));
+    }
+    const QString fragment = text.toCaseFolded();
+
+    QList<QVariantMap> narrowed;
+    for (const QVariantMap &item : results) {
+        if (matches(item, phrases, fragment)) {
+            narrowed.append(item);
+        }
+    }
+
+    qDebug() << "Search narrowed locally:" << results.size() << "->" << narrowed.size();
+
+    resultText = text;
+    results = narrowed;
+    emit resultsReady(results);
+}
+
+QString InventorySearch::searchKey(const QString &value)
+{
+    // Как unicode61 с remove_diacritics: без учета регистра и диакритических знаков
+    QString decomposed = value.normalized(QString::NormalizationForm_KD);
+    QString key;
+    key.reserve(decomposed.size());
+    for (const QChar &ch : decomposed) {
+        if (ch.category() != QChar::Mark_NonSpacing) {
+            key.append(ch);
+        }
+    }
+    return key.toCaseFolded();
+}
+
+QStringList InventorySearch::tokens(const QString &value)
+{
+    // Буквы и цифры образуют слово, все остальное - разделитель
+    const QString key = searchKey(value);
+    QStringList result;
+    QString current;
+    for (const QChar &ch : key) {
+        if (ch.isLetterOrNumber()) {
+            current.append(ch);
+        } else if (!current.isEmpty()) {
+            result.append(current);
+            current.clear();
+        }
+    }
+    if (!current.isEmpty()) {
+        result.append(current);
+    }
+    return result;
+}
+
+bool InventorySearch::containsPhrasePrefix(const QStringList &valueTokens, const QStringList &phrase)
+{
+    if (phrase.isEmpty()) {
+        return false;
+    }
+
+    const int last = phrase.size() - 1;
+    for (int start = 0; start + last < valueTokens.size(); ++start) {
+        int i = 0;
+        while (i < last && valueTokens.at(start + i) == phrase.at(i)) {
+            ++i;
+        }
+        if (i == last && valueTokens.at(start + last).startsWith(phrase.at(last))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InventorySearch::matches(const QVariantMap &item, const QList<QStringList> &phrases, const QString &fragment)
+{
+    // То же условие, что в запросе к базе. Фрагмент ищется триграммным индексом
+    // в серийном номере и Part Number (без учета регистра)
+    static const char *const codeColumns[] = {"serial_number", "part_number"};
+    for (const char *column : codeColumns) {
+        if (item.value(column).toString().toCaseFolded().contains(fragment)) {
+            return true;
+        }
+    }
+
+    // Каждое слово - префикс слова в одной из колонок полнотекстового индекса
+    static const char *const ftsColumns[] = {"serial_number", "part_number", "capacity",
+                                             "material_type", "manufacturer", "model",
+                                             "notes", "invoice_number"};
+
+    QList<QStringList> columnTokens;
+    for (const char *column : ftsColumns) {
+        columnTokens.append(tokens(item.value(column).toString()));
+    }
+
+    for (const QStringList &phrase : phrases) {
+        bool found = false;
+        for (const QStringList &valueTokens : columnTokens) {
+            if (containsPhrasePrefix(valueTokens, phrase)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return !phrases.isEmpty();
+}
@@ -0,0 +1,60 @@
+#ifndef INVENTORYSEARCH_H
+#define INVENTORYSEARCH_H
+
+#include <QObject>
+#include <QVariantMap>
+
+class AsyncDatabase;
+class QTimer;
+
+// Поиск по мере набора: запрос уходит после паузы в наборе и выполняется в пуле чтения.
+// Ответ на устаревший текст отбрасывается по номеру поколения. Если новый текст
+// продолжает уже найденный, результат сужается на месте без запроса к базе
+class InventorySearch : public QObject
+{
+    Q_OBJECT
+
+public:
+    InventorySearch(AsyncDatabase *asyncDb, const QString &requestKey, QObject *parent = nullptr);
+
+    // Пауза в наборе перед запросом, мс
+    static const int debounceMs = 250;
+
+    void setText(const QString &text);
+
+    // Записи изменились - сохраненный результат больше не годится для сужения
+    void invalidate();
+
+signals:
+    void resultsReady(const QList<QVariantMap> &items);
+    // Строка поиска очищена - нужен основной список
+    void cleared();
+
+private:
+    AsyncDatabase *asyncDb;
+    QString requestKey;
+    QTimer *debounceTimer;
+    QString pendingText;
+
+    // Каждый новый запрос, сужение или очистка увеличивают поколение
+    int generation;
+
+    // Последний показанный результат и текст, по которому он получен
+    bool hasResults;
+    QString resultText;
+    QList<QVariantMap> results;
+
+    void runSearch();
+    bool canNarrow(const QString &text) const;
+    void narrowTo(const QString &text);
+
+    static QString searchKey(const QString &value);
+    // Слова значения, как их выделяет токенизатор unicode61
+    static QStringList tokens(const QString &value);
+    static bool containsPhrasePrefix(const QStringList &valueTokens, const QStringList &phrase);
+    // phrases - слова запроса, разобранные на токены; fragment - весь текст для поиска
+    // по фрагменту серийного номера и Part Number
+    static bool matches(const QVariantMap &item, const QList<QStringList> &phrases, const QString &fragment);
+};
+
+#endif // INVENTORYSEARCH_H
@@ -0,0 +1,515 @@
+#include "inventorytablemodel.h"
+#include "asyncdatabase.h"
+#include <algorithm>
+#include <numeric>
+#include <functional>
+
+InventoryTableModel::InventoryTableModel(AsyncDatabase *asyncDb, const QString &requestKey, QObject *parent)
+    : QAbstractTableModel(parent)
+    , asyncDb(asyncDb)
+    , requestKey(requestKey)
+    , rowByIdValid(true)
+    , fixedList(false)
+    , lastPageId(0)
+    , pageRequestPending(false)
+    , listGeneration(0)
+    , sortColumn(-1)
+    , sortOrder(Qt::DescendingOrder)
+{
+}
+
+void InventoryTableModel::loadFirstPage(const Database::InventoryFilter &filter)
+{
+    pageFilter = filter;
+    fixedList = false;
+    nextCursor.clear();
+    ++listGeneration;
+    requestPage();
+}
+
+void InventoryTableModel::requestPage()
+{
+    pageRequestPending = true;
+
+    bool firstPage = nextCursor.isEmpty();
+    int generation = listGeneration;
+
+    // Страницы идут по убыванию даты прихода. Другой порядок по части списка был бы
+    // неверным, поэтому при нем остаток списка загружается одним запросом
+    int limit = sortedByQuery() ? pageSize : remainingRowsLimit;
+
+    AsyncDatabase::watch(asyncDb->getInventoryPage(nextCursor, limit, pageFilter, requestKey),
+                         this, [this, firstPage, generation](const Database::InventoryPage &page) {
+        if (generation != listGeneration) {
+            return;
+        }
+
+        pageRequestPending = false;
+        nextCursor = page.nextCursor;
+        if (!page.items.isEmpty()) {
+            lastPageDate = QDate::fromString(page.items.last()["arrival_date"].toString(), "yyyy-MM-dd");
+            lastPageId = page.items.last()["id"].toInt();
+        }
+
+        if (firstPage) {
+            // Старый список виден, пока не пришла замена
+            beginResetModel();
+            resetRows();
+            appendRows(newRows(page.items));
+            if (sortColumn >= 0) {
+                sortRows();
+            }
+            endResetModel();
+            emit firstPageLoaded();
+        } else {
+            QVector<Row> added = newRows(page.items);
+            if (!added.isEmpty()) {
+                beginInsertRows(QModelIndex(), rows.size(), rows.size() + added.size() - 1);
+                appendRows(added);
+                endInsertRows();
+
+                if (!sortedByQuery()) {
+                    sortLoadedRows();
+                }
+            }
+        }
+
+        // Порядок сменили, пока шла страница обычного размера
+        if (!sortedByQuery() && !nextCursor.isEmpty()) {
+            requestPage();
+        }
+    });
+}
+
+void InventoryTableModel::setItems(const QList<QVariantMap> &items, const Database::InventoryFilter &filter)
+{
+    asyncDb->cancel(requestKey);
+    ++listGeneration;
+    pageRequestPending = false;
+    pageFilter = filter;
+    fixedList = true;
+    nextCursor.clear();
+
+    beginResetModel();
+    resetRows();
+    appendRows(newRows(items));
+    if (sortColumn >= 0) {
+        sortRows();
+    }
+    endResetModel();
+}
+
+void InventoryTableModel::resetRows()
+{
+    rows.clear();
+    sharedNames.clear();
+    rowById.clear();
+    rowByIdValid = true;
+}
+
+QVector<InventoryTableModel::Row> InventoryTableModel::newRows(const QList<QVariantMap> &items)
+{
+    QVector<Row> result;
+    result.reserve(items.size());
+    for (const QVariantMap &item : items) {
+        Row row = rowFromItem(item);
+        // Запись, уже вставленная по уведомлению об изменении, второй раз не добавляется
+        if (rowForId(row.id) < 0) {
+            result.append(row);
+        }
+    }
+    return result;
+}
+
+void InventoryTableModel::appendRows(const QVector<Row> &newRows)
+{
+    rows.reserve(rows.size() + newRows.size());
+    for (const Row &row : newRows) {
+        if (rowByIdValid) {
+            rowById.insert(row.id, rows.size());
+        }
+        rows.append(row);
+    }
+}
+
+InventoryTableModel::Row InventoryTableModel::rowFromItem(const QVariantMap &item)
+{
+    Row row;
+    row.id = item["id"].toInt();
+    row.writtenOff = item["status"].toString() == "written_off";
+    row.materialType = sharedName(item["material_type"].toString());
+    row.manufacturer = sharedName(item["manufacturer"].toString());
+    row.model = sharedName(item["model"].toString());
+    row.partNumber = item["part_number"].toString();
+    row.serialNumber = item["serial_number"].toString();
+    row.capacity = sharedName(item["capacity"].toString());
+    row.interfaceType = sharedName(item["interface_type"].toString());
+    row.arrivalDate = QDate::fromString(item["arrival_date"].toString(), "yyyy-MM-dd");
+    row.invoiceNumber = item["invoice_number"].toString();
+    return row;
+}
+
+QString InventoryTableModel::sharedName(const QString &name)
+{
+    // Копия из множества разделяет данные со всеми строками с тем же значением
+    return *sharedNames.insert(name);
+}
+
+int InventoryTableModel::itemId(int row) const
+{
+    return row >= 0 && row < rows.size() ? rows.at(row).id : -1;
+}
+
+bool InventoryTableModel::isWrittenOff(int row) const
+{
+    return row >= 0 && row < rows.size() && rows.at(row).writtenOff;
+}
+
+QString InventoryTableModel::serialNumber(int row) const
+{
+    return row >= 0 && row < rows.size() ? rows.at(row).serialNumber : QString();
+}
+
+QList<int> InventoryTableModel::itemIds() const
+{
+    QList<int> ids;
+    ids.reserve(rows.size());
+    for (const Row &row : rows) {
+        ids.append(row.id);
+    }
+    return ids;
+}
+
+int InventoryTableModel::rowForId(int itemId) const
+{
+    if (!rowByIdValid) {
+        rowById.clear();
+        rowById.reserve(rows.size());
+        for (int i = 0; i < rows.size(); ++i) {
+            rowById.insert(rows.at(i).id, i);
+        }
+        rowByIdValid = true;
+    }
+
+    return rowById.value(itemId, -1);
+}
+
+void InventoryTableModel::itemsAdded(const QList<int> &itemIds)
+{
+    // В готовый список (результат поиска) новые записи не попадают
+    if (!fixedList) {
+        fetchItems(itemIds);
+    }
+}
+
+void InventoryTableModel::itemsChanged(const QList<int> &itemIds)
+{
+    fetchItems(itemIds);
+}
+
+void InventoryTableModel::itemsRemoved(const QList<int> &itemIds)
+{
+    // Снизу вверх: удаление строки не сдвигает номера оставшихся в списке
+    QList<int> removedRows;
+    for (int id : itemIds) {
+        int row = rowForId(id);
+        if (row >= 0) {
+            removedRows.append(row);
+        }
+    }
+    std::sort(removedRows.begin(), removedRows.end(), std::greater<int>());
+
+    for (int row : removedRows) {
+        removeRowAt(row);
+    }
+}
+
+void InventoryTableModel::fetchItems(const QList<int> &itemIds)
+{
+    if (itemIds.isEmpty()) {
+        return;
+    }
+
+    // Строки перечитываются с условиями текущего списка: не подходящие больше убираются
+    AsyncDatabase::watch(asyncDb->getInventoryItemsByIds(itemIds, pageFilter), this,
+                         [this, itemIds](const Database::InventoryRefresh &refresh) {
+        if (refresh.ok) {
+            applyItems(itemIds, refresh.items);
+        }
+    });
+}
+
+void InventoryTableModel::applyItems(const QList<int> &itemIds, const QList<QVariantMap> &items)
+{
+    // Все строки пакета обновляются на месте, новые добавляются одним блоком, а порядок
+    // восстанавливается одной перестановкой: номера строк не сдвигаются внутри цикла
+    QSet<int> foundIds;
+    QList<int> missingIds;
+    QVector<int> changedRows;
+    QVector<Row> added;
+
+    for (const QVariantMap &item : items) {
+        Row row = rowFromItem(item);
+        foundIds.insert(row.id);
+
+        int current = rowForId(row.id);
+        if (comesWithNextPage(row)) {
+            // Строка ушла за последнюю загруженную - вернется со своей страницей
+            if (current >= 0) {
+                missingIds.append(row.id);
+            }
+        } else if (current >= 0) {
+            rows[current] = row;
+            changedRows.append(current);
+        } else if (!fixedList) {
+            added.append(row);
+        }
+    }
+
+    if (!changedRows.isEmpty()) {
+        auto bounds = std::minmax_element(changedRows.constBegin(), changedRows.constEnd());
+        emit dataChanged(index(*bounds.first, 0), index(*bounds.second, ColumnCount - 1));
+    }
+
+    // Список был упорядочен, поэтому достаточно проверить соседей измененных строк
+    bool reorder = false;
+    if (sortColumn >= 0) {
+        for (int row : changedRows) {
+            if ((row > 0 && lessThan(rows.at(row), rows.at(row - 1)))
+                || (row + 1 < rows.size() && lessThan(rows.at(row + 1), rows.at(row)))) {
+                reorder = true;
+                break;
+            }
+        }
+    }
+
+    if (!added.isEmpty()) {
+        if (sortColumn < 0) {
+            // Без выбранной сортировки новые записи - в начале списка
+            beginInsertRows(QModelIndex(), 0, added.size() - 1);
+            rows.insert(0, added.size(), Row());
+            std::copy(added.constBegin(), added.constEnd(), rows.begin());
+            rowByIdValid = false;
+            endInsertRows();
+        } else {
+            beginInsertRows(QModelIndex(), rows.size(), rows.size() + added.size() - 1);
+            appendRows(added);
+            endInsertRows();
+            reorder = true;
+        }
+    }
+
+    if (reorder) {
+        sortLoadedRows();
+    }
+
+    // Не найденные удалены или больше не подходят под условия списка
+    for (int id : itemIds) {
+        if (!foundIds.contains(id)) {
+            missingIds.append(id);
+        }
+    }
+    itemsRemoved(missingIds);
+}
+
+bool InventoryTableModel::comesWithNextPage(const Row &row) const
+{
+    if (nextCursor.isEmpty()) {
+        return false;
+    }
+
+    return row.arrivalDate < lastPageDate || (row.arrivalDate == lastPageDate && row.id < lastPageId);
+}
+
+void InventoryTableModel::removeRowAt(int row)
+{
+    beginRemoveRows(QModelIndex(), row, row);
+    rows.remove(row);
+    endRemoveRows();
+    rowByIdValid = false;
+}
+
+int InventoryTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int InventoryTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant InventoryTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size()) {
+        return QVariant();
+    }
+
+    const Row &row = rows.at(index.row());
+
+    switch (role) {
+    case ItemIdRole:
+        return row.id;
+
+    case StatusRole:
+        // Оформление по статусу рисует StatusItemDelegate
+        return row.writtenOff ? QString("written_off") : QString("available");
+
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case IdColumn:
+            return row.id;
+        case StatusColumn:
+            return row.writtenOff ? QString("written_off") : QString("available");
+        case MaterialTypeColumn:
+            return row.materialType;
+        case ManufacturerColumn:
+            return row.manufacturer;
+        case ModelColumn:
+            return row.model;
+        case PartNumberColumn:
+            return row.partNumber;
+        case SerialNumberColumn:
+            return row.serialNumber;
+        case CapacityColumn:
+            return row.capacity;
+        case InterfaceColumn:
+            return row.interfaceType;
+        case ArrivalDateColumn:
+            return row.arrivalDate.toString("dd.MM.yyyy");
+        case InvoiceColumn:
+            return row.invoiceNumber;
+        default:
+            return QVariant();
+        }
+
+    default:
+        return QVariant();
+    }
+}
+
+QVariant InventoryTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    static const QStringList headers = {"ID", "Статус", "Тип", "Производитель", "Модель", "Part Number",
+                                        "Серийный номер", "Объем", "Интерфейс", "Дата прихода", "Накладная"};
+    return headers.value(section);
+}
+
+bool InventoryTableModel::lessThan(const Row &left, const Row &right) const
+{
+    int result = 0;
+
+    switch (sortColumn) {
+    case StatusColumn:
+        result = int(left.writtenOff) - int(right.writtenOff);
+        break;
+    case MaterialTypeColumn:
+        result = left.materialType.compare(right.materialType, Qt::CaseInsensitive);
+        break;
+    case ManufacturerColumn:
+        result = left.manufacturer.compare(right.manufacturer, Qt::CaseInsensitive);
+        break;
+    case ModelColumn:
+        result = left.model.compare(right.model, Qt::CaseInsensitive);
+        break;
+    case PartNumberColumn:
+        result = left.partNumber.compare(right.partNumber, Qt::CaseInsensitive);
+        break;
+    case SerialNumberColumn:
+        result = left.serialNumber.compare(right.serialNumber, Qt::CaseInsensitive);
+        break;
+    case CapacityColumn:
+        result = left.capacity.compare(right.capacity, Qt::CaseInsensitive);
+        break;
+    case InterfaceColumn:
+        result = left.interfaceType.compare(right.interfaceType, Qt::CaseInsensitive);
+        break;
+    case ArrivalDateColumn:
+        result = left.arrivalDate < right.arrivalDate ? -1 : (right.arrivalDate < left.arrivalDate ? 1 : 0);
+        break;
+    case InvoiceColumn:
+        result = left.invoiceNumber.compare(right.invoiceNumber, Qt::CaseInsensitive);
+        break;
+    default:
+        break;
+    }
+
+    // Равные значения - по id, как в запросе
+    if (result == 0) {
+        result = left.id - right.id;
+    }
+
+    return sortOrder == Qt::AscendingOrder ? result < 0 : result > 0;
+}
+
+void InventoryTableModel::sort(int column, Qt::SortOrder order)
+{
+    sortColumn = column;
+    sortOrder = order;
+    sortLoadedRows();
+
+    // Сортировка относится ко всему списку: недогруженные записи загружаются сразу
+    if (!sortedByQuery() && !nextCursor.isEmpty() && !pageRequestPending) {
+        requestPage();
+    }
+}
+
+bool InventoryTableModel::sortedByQuery() const
+{
+    return sortColumn < 0 || (sortColumn == ArrivalDateColumn && sortOrder == Qt::DescendingOrder);
+}
+
+void InventoryTableModel::sortLoadedRows()
+{
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+
+    // Выделение и текущая строка переносятся на новые номера строк
+    QVector<int> newRowOf = sortRows();
+
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QModelIndexList newIndexes;
+    newIndexes.reserve(oldIndexes.size());
+    for (const QModelIndex &oldIndex : oldIndexes) {
+        newIndexes.append(index(newRowOf.at(oldIndex.row()), oldIndex.column()));
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+}
+
+QVector<int> InventoryTableModel::sortRows()
+{
+    QVector<int> order(rows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int left, int right) {
+        return lessThan(rows.at(left), rows.at(right));
+    });
+
+    QVector<Row> sorted;
+    sorted.reserve(rows.size());
+    QVector<int> newRowOf(rows.size());
+    for (int i = 0; i < order.size(); ++i) {
+        sorted.append(rows.at(order.at(i)));
+        newRowOf[order.at(i)] = i;
+    }
+    rows.swap(sorted);
+    rowByIdValid = false;
+
+    return newRowOf;
+}
+
+bool InventoryTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !pageRequestPending && !nextCursor.isEmpty();
+}
+
+void InventoryTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (canFetchMore(parent)) {
+        requestPage();
+    }
+}
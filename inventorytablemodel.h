@@ -0,0 +1,143 @@
+#ifndef INVENTORYTABLEMODEL_H
+#define INVENTORYTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include <QSet>
+#include <QHash>
+#include <QDate>
+#include <limits>
+#include "database.h"
+
+class AsyncDatabase;
+
+// Основной список ЗИП для QTableView. Строки хранятся компактно в одном массиве,
+// ячейки формируются в data() по запросу представления. Основной список догружается
+// страницами через canFetchMore/fetchMore, готовый список (поиск, фильтр) задается целиком.
+// При сортировке не по убыванию даты прихода основной список загружается полностью.
+// После изменений в базе перечитываются и переставляются только затронутые строки
+class InventoryTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    // Колонки ID и статус скрыты в представлении
+    enum Column {
+        IdColumn,
+        StatusColumn,
+        MaterialTypeColumn,
+        ManufacturerColumn,
+        ModelColumn,
+        PartNumberColumn,
+        SerialNumberColumn,
+        CapacityColumn,
+        InterfaceColumn,
+        ArrivalDateColumn,
+        InvoiceColumn,
+        ColumnCount
+    };
+
+    enum Role {
+        ItemIdRole = Qt::UserRole + 1,
+        StatusRole
+    };
+
+    InventoryTableModel(AsyncDatabase *asyncDb, const QString &requestKey, QObject *parent = nullptr);
+
+    // Первая страница основного списка; следующие - по fetchMore при прокрутке
+    void loadFirstPage(const Database::InventoryFilter &filter);
+    // Готовый список без догрузки. filter - условия, по которым он получен: с ними
+    // перечитываются измененные строки. Для результата поиска условия пустые
+    void setItems(const QList<QVariantMap> &items,
+                  const Database::InventoryFilter &filter = Database::InventoryFilter());
+
+    int itemId(int row) const;
+    bool isWrittenOff(int row) const;
+    QString serialNumber(int row) const;
+    QList<int> itemIds() const;
+    int rowForId(int itemId) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+public slots:
+    // Уведомления Database/AsyncDatabase об изменении записей
+    void itemsAdded(const QList<int> &itemIds);
+    void itemsChanged(const QList<int> &itemIds);
+    void itemsRemoved(const QList<int> &itemIds);
+
+signals:
+    // Первая страница основного списка показана
+    void firstPageLoaded();
+
+private:
+    static const int pageSize = 200;
+    // Лимит запроса всех оставшихся записей (к нему добавляется одна проверочная)
+    static const int remainingRowsLimit = std::numeric_limits<int>::max() - 1;
+
+    struct Row {
+        int id = 0;
+        bool writtenOff = false;
+        QString materialType;
+        QString manufacturer;
+        QString model;
+        QString partNumber;
+        QString serialNumber;
+        QString capacity;
+        QString interfaceType;
+        QDate arrivalDate;
+        QString invoiceNumber;
+    };
+
+    AsyncDatabase *asyncDb;
+    QString requestKey;
+    QVector<Row> rows;
+
+    // id -> номер строки. Строится при первом обращении после перестановки строк
+    mutable QHash<int, int> rowById;
+    mutable bool rowByIdValid;
+
+    // Названия из справочников повторяются в тысячах строк - храним одну копию
+    QSet<QString> sharedNames;
+
+    // Условия текущего списка: страниц основного или готового списка
+    Database::InventoryFilter pageFilter;
+    // Готовый список: новые записи в него не добавляются
+    bool fixedList;
+    QString nextCursor;
+    // Последняя загруженная запись в порядке запроса: более старые придут со следующей страницей
+    QDate lastPageDate;
+    int lastPageId;
+    bool pageRequestPending;
+    // Ответы на запросы, после которых список был заменен, отбрасываются
+    int listGeneration;
+
+    // Порядок, выбранный пользователем; -1 - порядок запроса (по дате прихода)
+    int sortColumn;
+    Qt::SortOrder sortOrder;
+
+    void requestPage();
+    void resetRows();
+    QVector<Row> newRows(const QList<QVariantMap> &items);
+    void appendRows(const QVector<Row> &newRows);
+    Row rowFromItem(const QVariantMap &item);
+    void fetchItems(const QList<int> &itemIds);
+    void applyItems(const QList<int> &itemIds, const QList<QVariantMap> &items);
+    bool comesWithNextPage(const Row &row) const;
+    void removeRowAt(int row);
+    QString sharedName(const QString &name);
+    bool lessThan(const Row &left, const Row &right) const;
+    // Возвращает новый номер для каждой прежней строки
+    QVector<int> sortRows();
+    void sortLoadedRows();
+    // Выбранный порядок совпадает с порядком страниц (по убыванию даты прихода)
+    bool sortedByQuery() const;
+};
+
+#endif // INVENTORYTABLEMODEL_H
@@ -5,30 +5,51 @@
 #include <QDate>
 #include <QFileDialog>
 #include <QTextStream>
-#include <QTreeWidgetItem>
 #include <QStandardItemModel>
 #include <QCompleter>
 #include <QHeaderView>
 #include <QStyle>
-#include <QTableWidgetSelectionRange>
 #include <QInputDialog>
 #include <QComboBox>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QSplitter>
 #include <QTimer>
+#include <QActionGroup>
+#include <QStatusBar>
+#include <QItemSelectionModel>
 
 #include "labelprintdialog.h"
 #include "advancedfilterdialog.h"
+#include "asyncdatabase.h"
+#include "masseditdialog.h"
+#include "writeoffhistorydialog.h"
+#include "inventorytablemodel.h"
+#include "inventorysearch.h"
+#include "materialtreemodel.h"
+#include "statusitemdelegate.h"
+
+namespace {
+// Все запросы, заполняющие таблицу, идут под одним ключом: новый отменяет старый
+const QString InventoryTableRequest = "inventoryTable";
+const QString ReportRequest = "report";
+const QString MaterialsTreeRequest = "materialsTree";
+const QString MaterialTreeCountsRequest = "materialTreeCounts";
+}
 
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , db(new Database(this))
-    , contextMenuItem(nullptr)
+    , asyncDb(nullptr)
+    , dashboardWidget(nullptr)
     , currentEditId(-1)
+    , inventoryModel(nullptr)
+    , inventorySearch(nullptr)
+    , materialTreeModel(nullptr)
 {
+    startupTimer.start();
     ui->setupUi(this);
 
 
@@ -48,41 +69,114 @@ MainWindow::MainWindow(QWidget *parent)
 
 
     if (!db->initDatabase()) {
-            QMessageBox::critical(this, "Ошибка", "Не удалось инициализировать базу данных");
-            return;
-        }
+        QMessageBox::critical(this, "Ошибка", "Не удалось инициализировать базу данных");
+        return;
+    }
+    logStartupStage("database");
 
-        setupUI();
-        setupConnections();
-        setupSortMenu();
-        refreshCompleters();
-        loadMaterialsTree();
+    // Рабочий поток открывает своё соединение после создания структуры БД
+    asyncDb = new AsyncDatabase(this);
+    asyncDb->start();
+    connect(asyncDb, &AsyncDatabase::dataModified, this, [this]() {
+        db->reloadDictionaryCache();
+    });
+
+    inventoryModel = new InventoryTableModel(asyncDb, InventoryTableRequest, this);
+    connect(inventoryModel, &InventoryTableModel::firstPageLoaded, this, [this]() {
+        finishStartupStage("inventory page");
+    });
+
+    // После изменений таблица не перечитывается: модель обновляет только затронутые строки.
+    // Все записи в базу идут через рабочий поток, уведомления приходят от него
+    connect(asyncDb, &AsyncDatabase::inventoryItemsAdded, inventoryModel, &InventoryTableModel::itemsAdded);
+    connect(asyncDb, &AsyncDatabase::inventoryItemsChanged, inventoryModel, &InventoryTableModel::itemsChanged);
+    connect(asyncDb, &AsyncDatabase::inventoryItemsRemoved, inventoryModel, &InventoryTableModel::itemsRemoved);
+
+    // Поиск по мере набора; результат, сохраненный для сужения, после изменений устаревает
+    inventorySearch = new InventorySearch(asyncDb, InventoryTableRequest, this);
+    connect(inventorySearch, &InventorySearch::resultsReady, this, &MainWindow::showInventoryList);
+    connect(inventorySearch, &InventorySearch::cleared, this, [this]() {
         loadInventoryTable();
+    });
+    connect(asyncDb, &AsyncDatabase::dataModified, inventorySearch, &InventorySearch::invalidate);
 
-        ui->arrivalDateEdit->setDate(QDate::currentDate());
-        updateInterfaceVisibility();
+    // При добавлении и удалении записей перечитываются счетчики только затронутых моделей
+    materialTreeModel = new MaterialTreeModel(this);
+    connect(asyncDb, &AsyncDatabase::modelItemCountsChanged, this, &MainWindow::updateMaterialTreeCounts);
+
+    setupUI();
+    setupConnections();
+    setupSortMenu();
+
+    // Окно показывается сразу; первая страница списка, дерево, справочники
+    // и статистика догружаются в фоне, каждый этап отмечается в журнале
+    pendingStartupStages = QStringList{"inventory page", "completers", "materials tree", "dashboard"};
+    loadInventoryTable();
 
-        connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::about);
+    ui->arrivalDateEdit->setDate(QDate::currentDate());
+    updateInterfaceVisibility();
 
-        // НЕ СОЗДАЕМ НОВЫЙ виджет, а используем существующий из UI
-            dashboardWidget = ui->dashboardWidget;  // Просто присваиваем указатель
+    connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::about);
+    setupStorageProfileMenu();
+    setupMaintenanceMenu();
 
-            // Устанавливаем database для существующего виджета
-            dashboardWidget->setDatabase(db);
+    // НЕ СОЗДАЕМ НОВЫЙ виджет, а используем существующий из UI
+    dashboardWidget = ui->dashboardWidget;  // Просто присваиваем указатель
 
-            // Убедимся, что виджет видим
-            dashboardWidget->setVisible(true);
+    // Убедимся, что виджет видим
+    dashboardWidget->setVisible(true);
 
-            // Подключаем обновление статистики при переключении на вкладку
-            connect(ui->tabWidget, &QTabWidget::currentChanged, [this](int index) {
-                if (index == 2) { // Индекс вкладки статистики
-                    qDebug() << "Stats tab activated, refreshing...";
-                    dashboardWidget->refreshStats();
-                }
-            });
+    connect(dashboardWidget, &DashboardWidget::statsUpdated, this, [this]() {
+        finishStartupStage("dashboard");
+    });
 
+    // Подключаем обновление статистики при переключении на вкладку
+    connect(ui->tabWidget, &QTabWidget::currentChanged, [this](int index) {
+        if (index == 2) { // Индекс вкладки статистики
+            qDebug() << "Stats tab activated, refreshing...";
+            dashboardWidget->refreshStats();
+        }
+    });
+
+    logStartupStage("window setup");
+
+    // Выполнится после показа окна, при первом проходе цикла событий
+    QTimer::singleShot(0, this, &MainWindow::startBackgroundLoading);
+}
+
+void MainWindow::startBackgroundLoading()
+{
+    logStartupStage("window shown");
+
+    // Справочники уже в кэше соединения - заполнение не обращается к файлу
+    refreshCompleters();
+    finishStartupStage("completers");
+
+    loadMaterialsTree();
+
+    // Устанавливаем database для существующего виджета (статистика грузится в пуле чтения)
+    dashboardWidget->setAsyncDatabase(asyncDb);
+    dashboardWidget->setDatabase(db);
+}
+
+void MainWindow::logStartupStage(const QString &stage)
+{
+    qDebug() << "Startup:" << stage << "at" << startupTimer.elapsed() << "ms";
+}
+
+void MainWindow::finishStartupStage(const QString &stage)
+{
+    // Повторные загрузки после запуска не отмечаются
+    if (!pendingStartupStages.removeOne(stage)) {
+        return;
     }
 
+    logStartupStage(stage);
+    if (pendingStartupStages.isEmpty()) {
+        qDebug() << "Startup: complete in" << startupTimer.elapsed() << "ms";
+    }
+}
+
 MainWindow::~MainWindow()
 {
     delete ui;
@@ -99,36 +193,37 @@ void MainWindow::setupUI()
     treeContextMenu->addSeparator();
     treeContextMenu->addAction(refreshAction);
 
-    // Настройка таблицы инвентаря
-    QStringList headers = {"ID", "Статус", "Тип", "Производитель", "Модель", "Part Number",
-                              "Серийный номер", "Объем", "Интерфейс", "Дата прихода", "Накладная"};
-        ui->inventoryTable->setColumnCount(headers.size());
-        ui->inventoryTable->setHorizontalHeaderLabels(headers);
+    // Таблица инвентаря: ячейки выдает модель, следующие страницы она же догружает при прокрутке
+    ui->inventoryTable->setModel(inventoryModel);
+    ui->inventoryTable->setItemDelegate(new StatusItemDelegate(InventoryTableModel::StatusRole,
+                                                               InventoryTableModel::MaterialTypeColumn,
+                                                               ui->inventoryTable));
 
-        // Скрываем колонки ID и статус (будем использовать визуальные обозначения)
-        ui->inventoryTable->setColumnHidden(0, true);  // ID
-        ui->inventoryTable->setColumnHidden(1, true);  // Статус
+    // Скрываем колонки ID и статус (будем использовать визуальные обозначения)
+    ui->inventoryTable->setColumnHidden(InventoryTableModel::IdColumn, true);
+    ui->inventoryTable->setColumnHidden(InventoryTableModel::StatusColumn, true);
 
     // Настраиваем режимы отображения
-    ui->inventoryTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    ui->inventoryTable->setSelectionMode(QAbstractItemView::ExtendedSelection);
     ui->inventoryTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     ui->inventoryTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
-    // Включаем сортировку по клику на заголовки
+    // Высота строк одинаковая: представлению не нужно измерять каждую строку
+    ui->inventoryTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+
+    // Включаем сортировку по клику на заголовки; начальный порядок совпадает с порядком запроса
+    ui->inventoryTable->horizontalHeader()->setSortIndicator(InventoryTableModel::ArrivalDateColumn, Qt::DescendingOrder);
     ui->inventoryTable->setSortingEnabled(true);
 
     // Настраиваем ширину колонок
     ui->inventoryTable->horizontalHeader()->setStretchLastSection(true);
     ui->inventoryTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
 
-    // Скрываем колонку ID
-    ui->inventoryTable->setColumnHidden(0, true);
-
     // Устанавливаем минимальные ширины для важных колонок
-    ui->inventoryTable->setColumnWidth(1, 120);  // Тип
-    ui->inventoryTable->setColumnWidth(2, 120);  // Производитель
-    ui->inventoryTable->setColumnWidth(5, 150);  // Серийный номер
-    ui->inventoryTable->setColumnWidth(8, 100);  // Дата прихода
+    ui->inventoryTable->setColumnWidth(InventoryTableModel::MaterialTypeColumn, 120);
+    ui->inventoryTable->setColumnWidth(InventoryTableModel::ManufacturerColumn, 120);
+    ui->inventoryTable->setColumnWidth(InventoryTableModel::SerialNumberColumn, 150);
+    ui->inventoryTable->setColumnWidth(InventoryTableModel::ArrivalDateColumn, 100);
 
     // Автодополнение
     materialCompleter = new QCompleter(this);
@@ -203,7 +298,8 @@ void MainWindow::setupUI()
     ui->interfaceLabel->setVisible(false);
     ui->interfaceCombo->setVisible(false);
 
-    // Настройка дерева
+    // Настройка дерева: узлы раскрываются по требованию
+    ui->materialsTree->setModel(materialTreeModel);
     ui->materialsTree->setHeaderHidden(true);
     ui->leftFrame->setMaximumWidth(550);
 
@@ -229,15 +325,6 @@ void MainWindow::setupUI()
     treeContextMenu->addSeparator();
     treeContextMenu->addAction(refreshAction);
 
-      // Добавляем колонку статуса в таблицу
-
-        ui->inventoryTable->setColumnCount(headers.size());
-        ui->inventoryTable->setHorizontalHeaderLabels(headers);
-
-        // Скрываем колонки ID и статус (будем использовать иконки)
-        ui->inventoryTable->setColumnHidden(0, true);  // ID
-        ui->inventoryTable->setColumnHidden(1, true);  // Статус
-
         // Настраиваем контекстное меню для таблицы
         setupContextMenu();
 
@@ -250,13 +337,15 @@ void MainWindow::setupUI()
     connect(ui->advancedFilterButton, &QPushButton::clicked, this, &MainWindow::onAdvancedFilter);
 
     // Автоматическое включение/выключение кнопки удаления
-    connect(ui->materialsTree, &QTreeWidget::itemSelectionChanged, [this]() {
-        QTreeWidgetItem* item = ui->materialsTree->currentItem();
-        bool enableDelete = item && item != ui->materialsTree->topLevelItem(0);
+    connect(ui->materialsTree->selectionModel(), &QItemSelectionModel::currentChanged,
+            this, [this](const QModelIndex &current) {
+        bool enableDelete = current.isValid() &&
+                            materialTreeModel->level(current) != MaterialTreeModel::RootLevel;
         ui->deleteFromTreeButton->setEnabled(enableDelete);
     });
 
     connect(ui->printLabelsButton, &QPushButton::clicked, this, &MainWindow::onPrintLabels);
+    connect(ui->importButton, &QPushButton::clicked, this, &MainWindow::onImportInventory);
 
     // Добавляем фильтр статуса
     QHBoxLayout *filterLayout = new QHBoxLayout();
@@ -287,26 +376,9 @@ void MainWindow::onStatusFilterChanged()
     QString filter = statusFilterCombo->currentData().toString();
     qDebug() << "Filter changed to:" << filter;
 
-    if (filter == "all") {
-        loadInventoryTable();
-    } else {
-        // Загружаем все данные из БД
-        QList<QVariantMap> allItems = db->getInventoryItems();
-        QList<QVariantMap> filteredItems;
-
-        for (const QVariantMap &item : allItems) {
-            QString status = item["status"].toString();
-            qDebug() << "Checking item ID:" << item["id"].toInt()
-                     << "Status:" << status << "Filter:" << filter;
-
-            if (status == filter) {
-                filteredItems.append(item);
-            }
-        }
-
-        qDebug() << "Filtered items count:" << filteredItems.size();
-        loadInventoryTable(filteredItems);
-    }
+    // Фильтр по статусу применяется в запросе постраничной выборки
+    pageFilter.status = filter;
+    loadFirstInventoryPage();
 }
 
 
@@ -318,79 +390,47 @@ void MainWindow::setupContextMenu()
     returnAction = new QAction("✅ Вернуть в наличие", this);
     showHistoryAction = new QAction("📋 История списаний", this);
 
+    massEditAction = new QAction("✏️ Изменить выбранные...", this);
+
     inventoryContextMenu->addAction(writeOffAction);
     inventoryContextMenu->addAction(returnAction);
     inventoryContextMenu->addSeparator();
+    inventoryContextMenu->addAction(massEditAction);
+    inventoryContextMenu->addSeparator();
     inventoryContextMenu->addAction(showHistoryAction);
 
     // Подключаем слоты
     connect(writeOffAction, &QAction::triggered, this, &MainWindow::onWriteOffItem);
     connect(returnAction, &QAction::triggered, this, &MainWindow::onReturnItem);
+    connect(massEditAction, &QAction::triggered, this, &MainWindow::onMassEditItems);
     connect(showHistoryAction, &QAction::triggered, this, &MainWindow::onShowWriteOffHistory);
 
     // Устанавливаем контекстное меню для таблицы
     ui->inventoryTable->setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(ui->inventoryTable, &QTableWidget::customContextMenuRequested,
+    connect(ui->inventoryTable, &QTableView::customContextMenuRequested,
             this, [this](const QPoint &pos) {
-                QTableWidgetItem *item = ui->inventoryTable->itemAt(pos);
-                if (item) {
-                    int row = item->row();
-                    int itemId = ui->inventoryTable->item(row, 0)->text().toInt();
-                    bool isWrittenOff = db->isItemWrittenOff(itemId);
+                if (ui->inventoryTable->indexAt(pos).isValid()) {
+                    // Статус берем из модели: для выделения из многих строк не нужен запрос на каждую
+                    bool hasAvailable = false;
+                    bool hasWrittenOff = false;
+                    const QModelIndexList rows = ui->inventoryTable->selectionModel()->selectedRows();
+                    for (const QModelIndex &index : rows) {
+                        if (inventoryModel->isWrittenOff(index.row())) {
+                            hasWrittenOff = true;
+                        } else {
+                            hasAvailable = true;
+                        }
+                    }
 
                     // Настраиваем доступность действий
-                    writeOffAction->setEnabled(!isWrittenOff);
-                    returnAction->setEnabled(isWrittenOff);
+                    writeOffAction->setEnabled(hasAvailable);
+                    returnAction->setEnabled(hasWrittenOff);
 
                     inventoryContextMenu->exec(ui->inventoryTable->viewport()->mapToGlobal(pos));
                 }
             });
 }
 
-void MainWindow::updateRowAppearance(int row, bool isWrittenOff)
-{
-    if (row < 0 || row >= ui->inventoryTable->rowCount()) {
-        return;
-    }
-
-    for (int col = 0; col < ui->inventoryTable->columnCount(); ++col) {
-        QTableWidgetItem *item = ui->inventoryTable->item(row, col);
-        if (item) {
-            if (isWrittenOff) {
-                // Красный перечеркнутый текст для списанных
-                QFont font = item->font();
-                font.setStrikeOut(true);
-                item->setFont(font);
-                item->setForeground(QBrush(QColor(255, 100, 100))); // Красный
-
-                // Добавляем эмодзи красного крестика в колонку типа материала
-                if (col == 2) { // Колонка "Тип" (после скрытых ID и статуса)
-                    QString currentText = item->text();
-                    if (!currentText.startsWith("❌ ")) {
-                        item->setText("❌ " + currentText);
-                    }
-                }
-            } else {
-                // Возвращаем обычный вид
-                QFont font = item->font();
-                font.setStrikeOut(false);
-                item->setFont(font);
-                item->setForeground(QBrush(QColor(0, 0, 0))); // Черный
-
-                // Убираем эмодзи красного крестика
-                if (col == 2) {
-                    QString currentText = item->text();
-                    if (currentText.startsWith("❌ ")) {
-                        item->setText(currentText.mid(3)); // Убираем "❌ "
-                    }
-                }
-            }
-        }
-    }
-}
-
-
-
 void MainWindow::setupConnections()
 {
     connect(ui->addButton, &QPushButton::clicked, this, &MainWindow::onAddItem);
@@ -403,13 +443,14 @@ void MainWindow::setupConnections()
     connect(ui->searchLineEdit, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
     connect(ui->materialTypeCombo, &QComboBox::currentTextChanged, this, &MainWindow::onMaterialTypeChanged);
     connect(ui->manufacturerCombo, &QComboBox::currentTextChanged, this, &MainWindow::onManufacturerChanged);
-    connect(ui->materialsTree, &QTreeWidget::itemClicked, this, &MainWindow::onTreeItemClicked);
-    connect(ui->inventoryTable, &QTableWidget::itemSelectionChanged, this, &MainWindow::onTableSelectionChanged);
+    connect(ui->materialsTree, &QTreeView::clicked, this, &MainWindow::onTreeItemClicked);
+    connect(ui->inventoryTable->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &MainWindow::onTableSelectionChanged);
 
 
 
     // Контекстное меню дерева
-    connect(ui->materialsTree, &QTreeWidget::customContextMenuRequested,
+    connect(ui->materialsTree, &QTreeView::customContextMenuRequested,
             this, &MainWindow::onTreeCustomContextMenu);
     connect(deleteAction, &QAction::triggered, this, &MainWindow::onDeleteFromTree);
     connect(refreshAction, &QAction::triggered, this, &MainWindow::onRefreshTree);
@@ -488,122 +529,90 @@ void MainWindow::refreshCompleters()
 
 void MainWindow::loadMaterialsTree()
 {
-    ui->materialsTree->clear();
-
-    QTreeWidgetItem *rootItem = new QTreeWidgetItem(ui->materialsTree);
-    rootItem->setText(0, "📦 Все материалы");
-
-    QStringList materials = db->getMaterialTypes();
-    for (const QString &material : materials) {
-        QTreeWidgetItem *materialItem = new QTreeWidgetItem(rootItem);
-        materialItem->setText(0, "📁 " + material);
-
-        QStringList manufacturers = db->getManufacturers();
-        for (const QString &manufacturer : manufacturers) {
-            QStringList models = db->getModelsByMaterialAndManufacturer(material, manufacturer);
-            if (!models.isEmpty()) {
-                QTreeWidgetItem *manufacturerItem = new QTreeWidgetItem(materialItem);
-                manufacturerItem->setText(0, "🏭 " + manufacturer);
+    // Дерево строится из одного запроса в пуле чтения; новый вызов отменяет предыдущий
+    AsyncDatabase::watch(asyncDb->getMaterialTreeRows(MaterialsTreeRequest), this,
+                         [this](const QList<Database::MaterialTreeRow> &rows) {
+        // Раскрытые узлы и выделение сохраняются: модель меняет только отличия
+        materialTreeModel->setRows(rows);
+        ui->materialsTree->expand(materialTreeModel->rootIndex());
+        finishStartupStage("materials tree");
+    });
+}
 
-                for (const QString &model : models) {
-                    QTreeWidgetItem *modelItem = new QTreeWidgetItem(manufacturerItem);
-                    modelItem->setText(0, "📄 " + model);
-                }
-            }
-        }
+void MainWindow::updateMaterialTreeCounts(const QList<int> &modelIds)
+{
+    // Новый запрос отменяет предыдущий, поэтому в него входят все еще не перечитанные модели
+    for (int modelId : modelIds) {
+        pendingTreeModelIds.insert(modelId);
     }
 
-    ui->materialsTree->expandAll();
+    AsyncDatabase::watch(asyncDb->getModelItemCounts(pendingTreeModelIds.values(), MaterialTreeCountsRequest), this,
+                         [this](const QList<Database::MaterialTreeRow> &rows) {
+        pendingTreeModelIds.clear();
+        materialTreeModel->setModelItemCounts(rows);
+    });
 }
 
-void MainWindow::loadInventoryTable(const QList<QVariantMap> &items)
+void MainWindow::loadInventoryTable(const QList<QVariantMap> &items, const Database::InventoryFilter &filter)
 {
-    // Временно отключаем сортировку
-    ui->inventoryTable->setSortingEnabled(false);
-    ui->inventoryTable->clearContents();
-
-    QList<QVariantMap> inventoryItems = items.isEmpty() ? db->getInventoryItems() : items;
-
-    ui->inventoryTable->setRowCount(inventoryItems.size());
-
-    qDebug() << "Loading" << inventoryItems.size() << "items into table";
-
-    for (int i = 0; i < inventoryItems.size(); ++i) {
-        const QVariantMap &item = inventoryItems[i];
-
-        // Статус
-        QString status = item["status"].toString();
-        if (status.isEmpty()) {
-            status = "available";
-        }
-
-        qDebug() << "Row" << i << "ID:" << item["id"].toInt() << "Status:" << status;
-
-        // Заполняем таблицу
-        ui->inventoryTable->setItem(i, 0, new QTableWidgetItem(item["id"].toString()));
-        ui->inventoryTable->setItem(i, 1, new QTableWidgetItem(status));
-
-        // Для типа материала добавляем/убираем эмодзи в зависимости от статуса
-        QString materialType = item["material_type"].toString();
-        if (status == "written_off") {
-            ui->inventoryTable->setItem(i, 2, new QTableWidgetItem("❌ " + materialType));
-        } else {
-            ui->inventoryTable->setItem(i, 2, new QTableWidgetItem(materialType));
-        }
-
-        ui->inventoryTable->setItem(i, 3, new QTableWidgetItem(item["manufacturer"].toString()));
-        ui->inventoryTable->setItem(i, 4, new QTableWidgetItem(item["model"].toString()));
-        ui->inventoryTable->setItem(i, 5, new QTableWidgetItem(item["part_number"].toString()));
-        ui->inventoryTable->setItem(i, 6, new QTableWidgetItem(item["serial_number"].toString()));
-        ui->inventoryTable->setItem(i, 7, new QTableWidgetItem(item["capacity"].toString()));
-        ui->inventoryTable->setItem(i, 8, new QTableWidgetItem(item["interface_type"].toString()));
-
-        // Дата
-        QString dateStr = item["arrival_date"].toString();
-        QTableWidgetItem *dateItem = new QTableWidgetItem(formatDateForDisplay(dateStr));
-        dateItem->setData(Qt::UserRole, QDate::fromString(dateStr, "yyyy-MM-dd"));
-        ui->inventoryTable->setItem(i, 9, dateItem);
-
-        ui->inventoryTable->setItem(i, 10, new QTableWidgetItem(item["invoice_number"].toString()));
-
-        // Обновляем внешний вид в зависимости от статуса
-        bool isWrittenOff = (status == "written_off");
-        updateRowAppearance(i, isWrittenOff);
+    if (items.isEmpty()) {
+        // Без готового списка показываем первую страницу основного списка
+        loadFirstInventoryPage();
+        return;
     }
 
-    // Включаем сортировку
-    ui->inventoryTable->setSortingEnabled(true);
+    inventoryModel->setItems(items, filter);
+}
 
-    // Устанавливаем сортировку по дате
-    ui->inventoryTable->sortByColumn(9, Qt::DescendingOrder);
+void MainWindow::showInventoryList(const QList<QVariantMap> &items)
+{
+    // Готовый список (поиск, фильтр) показывается целиком, без догрузки
+    inventoryModel->setItems(items);
 }
 
+void MainWindow::loadFirstInventoryPage()
+{
+    inventoryModel->loadFirstPage(pageFilter);
+}
 
 void MainWindow::onWriteOffItem()
 {
-    QList<QTableWidgetItem*> selectedItems = ui->inventoryTable->selectedItems();
-    if (selectedItems.isEmpty()) {
+    QList<int> itemIds = selectedItemIds();
+    if (itemIds.isEmpty()) {
         QMessageBox::warning(this, "Внимание", "Выберите запись для списания");
         return;
     }
 
-    int row = ui->inventoryTable->currentRow();
-    int itemId = ui->inventoryTable->item(row, 0)->text().toInt();
+    if (itemIds.size() > 1) {
+        showWriteOffDialog(itemIds, QVariantMap());
+        return;
+    }
 
-    showWriteOffDialog(itemId);
+    // Для одной позиции диалог показывает её данные - они читаются в пуле чтения
+    AsyncDatabase::watch(asyncDb->getInventoryItemById(itemIds.first()), this,
+                         [this, itemIds](const QVariantMap &item) {
+        if (item.isEmpty()) {
+            QMessageBox::warning(this, "Ошибка", "Не удалось загрузить информацию о позиции");
+            return;
+        }
+        showWriteOffDialog(itemIds, item);
+    });
 }
 
-void MainWindow::showWriteOffDialog(int itemId)
+QList<int> MainWindow::selectedItemIds() const
 {
-    // Получаем информацию о позиции
-    QVariantMap item = db->getInventoryItemById(itemId);
-    if (item.isEmpty()) {
-        QMessageBox::warning(this, "Ошибка", "Не удалось загрузить информацию о позиции");
-        return;
+    QList<int> itemIds;
+    const QModelIndexList rows = ui->inventoryTable->selectionModel()->selectedRows();
+    for (const QModelIndex &index : rows) {
+        itemIds.append(inventoryModel->itemId(index.row()));
     }
+    return itemIds;
+}
 
+void MainWindow::showWriteOffDialog(const QList<int> &itemIds, const QVariantMap &item)
+{
     QDialog dialog(this);
-    dialog.setWindowTitle("Списание позиции");
+    dialog.setWindowTitle(itemIds.size() == 1 ? "Списание позиции" : "Списание позиций");
     dialog.setFixedSize(400, 300);
 
     QVBoxLayout *layout = new QVBoxLayout(&dialog);
@@ -612,17 +621,23 @@ void MainWindow::showWriteOffDialog(int itemId)
     QGroupBox *infoGroup = new QGroupBox("Информация о позиции", &dialog);
     QFormLayout *infoLayout = new QFormLayout(infoGroup);
 
-    QLabel *typeLabel = new QLabel(item["material_type"].toString(), infoGroup);
-    QLabel *manufacturerLabel = new QLabel(item["manufacturer"].toString(), infoGroup);
-    QLabel *modelLabel = new QLabel(item["model"].toString(), infoGroup);
-    QLabel *serialLabel = new QLabel(item["serial_number"].toString(), infoGroup);
-    QLabel *partLabel = new QLabel(item["part_number"].toString(), infoGroup);
-
-    infoLayout->addRow("Тип:", typeLabel);
-    infoLayout->addRow("Производитель:", manufacturerLabel);
-    infoLayout->addRow("Модель:", modelLabel);
-    infoLayout->addRow("Серийный номер:", serialLabel);
-    infoLayout->addRow("Part Number:", partLabel);
+    if (itemIds.size() > 1) {
+        // Для нескольких позиций - только их количество, получатель общий
+        infoGroup->setTitle("Выбранные позиции");
+        infoLayout->addRow("Количество:", new QLabel(QString::number(itemIds.size()), infoGroup));
+    } else {
+        QLabel *typeLabel = new QLabel(item["material_type"].toString(), infoGroup);
+        QLabel *manufacturerLabel = new QLabel(item["manufacturer"].toString(), infoGroup);
+        QLabel *modelLabel = new QLabel(item["model"].toString(), infoGroup);
+        QLabel *serialLabel = new QLabel(item["serial_number"].toString(), infoGroup);
+        QLabel *partLabel = new QLabel(item["part_number"].toString(), infoGroup);
+
+        infoLayout->addRow("Тип:", typeLabel);
+        infoLayout->addRow("Производитель:", manufacturerLabel);
+        infoLayout->addRow("Модель:", modelLabel);
+        infoLayout->addRow("Серийный номер:", serialLabel);
+        infoLayout->addRow("Part Number:", partLabel);
+    }
 
     // Поля для списания
     QGroupBox *writeOffGroup = new QGroupBox("Данные списания", &dialog);
@@ -661,113 +676,57 @@ void MainWindow::showWriteOffDialog(int itemId)
             return;
         }
 
-        if (db->markItemAsWrittenOff(itemId, issuedTo, issueDate, comments)) {
-            QMessageBox::information(this, "Успех", "Позиция успешно списана");
-
-            // Обновляем отображение
-            int row = findRowByItemId(itemId);
-            if (row >= 0) {
-                updateRowAppearance(row, true);
+        AsyncDatabase::watch(asyncDb->markItemsAsWrittenOff(itemIds, issuedTo, issueDate, comments), this,
+                             [this, itemIds](bool success) {
+            if (success) {
+                QMessageBox::information(this, "Успех", itemIds.size() == 1
+                                         ? QString("Позиция успешно списана")
+                                         : QString("Списано позиций: %1").arg(itemIds.size()));
+            } else {
+                QMessageBox::critical(this, "Ошибка", "Не удалось списать позицию");
             }
-
-            // Обновляем данные в таблице
-            loadInventoryTable();
-        } else {
-            QMessageBox::critical(this, "Ошибка", "Не удалось списать позицию");
-        }
-    }
-}
-
-int MainWindow::findRowByItemId(int itemId)
-{
-    for (int row = 0; row < ui->inventoryTable->rowCount(); ++row) {
-        if (ui->inventoryTable->item(row, 0)->text().toInt() == itemId) {
-            return row;
-        }
+        });
     }
-    return -1;
 }
 
 void MainWindow::onReturnItem()
 {
-    QList<QTableWidgetItem*> selectedItems = ui->inventoryTable->selectedItems();
-    if (selectedItems.isEmpty()) {
+    QList<int> itemIds = selectedItemIds();
+    if (itemIds.isEmpty()) {
         QMessageBox::warning(this, "Внимание", "Выберите списанную запись для возврата");
         return;
     }
 
-    int row = ui->inventoryTable->currentRow();
-    int itemId = ui->inventoryTable->item(row, 0)->text().toInt();
-
-    QString serialNumber = ui->inventoryTable->item(row, 5)->text();
+    QString question;
+    if (itemIds.size() == 1) {
+        QString serialNumber = inventoryModel->serialNumber(ui->inventoryTable->currentIndex().row());
+        question = QString("Вернуть позицию в наличие?\nСерийный номер: %1").arg(serialNumber);
+    } else {
+        question = QString("Вернуть в наличие выбранные позиции (%1)?").arg(itemIds.size());
+    }
 
     QMessageBox::StandardButton reply = QMessageBox::question(
-        this, "Подтверждение возврата",
-        QString("Вернуть позицию в наличие?\nСерийный номер: %1").arg(serialNumber),
+        this, "Подтверждение возврата", question,
         QMessageBox::Yes | QMessageBox::No
     );
 
     if (reply == QMessageBox::Yes) {
-        if (db->markItemAsAvailable(itemId)) {
-            QMessageBox::information(this, "Успех", "Позиция возвращена в наличие");
-
-            // Обновляем отображение
-            updateRowAppearance(row, false);
-
-            // Обновляем данные в таблице
-            loadInventoryTable();
-        } else {
-            QMessageBox::critical(this, "Ошибка", "Не удалось вернуть позицию");
-        }
+        AsyncDatabase::watch(asyncDb->markItemsAsAvailable(itemIds), this, [this, itemIds](bool success) {
+            if (success) {
+                QMessageBox::information(this, "Успех", itemIds.size() == 1
+                                         ? QString("Позиция возвращена в наличие")
+                                         : QString("Возвращено позиций: %1").arg(itemIds.size()));
+            } else {
+                QMessageBox::critical(this, "Ошибка", "Не удалось вернуть позицию");
+            }
+        });
     }
 }
 
 void MainWindow::onShowWriteOffHistory()
 {
-    QDialog historyDialog(this);
-    historyDialog.setWindowTitle("История списаний");
-    historyDialog.resize(800, 600);
-
-    QVBoxLayout *layout = new QVBoxLayout(&historyDialog);
-
-    // Таблица истории
-    QTableWidget *historyTable = new QTableWidget(&historyDialog);
-    historyTable->setColumnCount(9);
-    QStringList headers = {"ID", "Тип", "Производитель", "Модель", "Part Number",
-                          "Серийный номер", "Кому выдано", "Дата выдачи", "Комментарий"};
-    historyTable->setHorizontalHeaderLabels(headers);
-    historyTable->setColumnHidden(0, true);
-    historyTable->setAlternatingRowColors(true);
-    historyTable->setSortingEnabled(true);
-
-    // Загружаем историю
-    QList<QVariantMap> history = db->getWriteOffHistory();
-    historyTable->setRowCount(history.size());
-
-    for (int i = 0; i < history.size(); ++i) {
-        const QVariantMap &record = history[i];
-
-        historyTable->setItem(i, 0, new QTableWidgetItem(record["id"].toString()));
-        historyTable->setItem(i, 1, new QTableWidgetItem(record["material_type"].toString()));
-        historyTable->setItem(i, 2, new QTableWidgetItem(record["manufacturer"].toString()));
-        historyTable->setItem(i, 3, new QTableWidgetItem(record["model"].toString()));
-        historyTable->setItem(i, 4, new QTableWidgetItem(record["part_number"].toString()));
-        historyTable->setItem(i, 5, new QTableWidgetItem(record["serial_number"].toString()));
-        historyTable->setItem(i, 6, new QTableWidgetItem(record["issued_to"].toString()));
-        historyTable->setItem(i, 7, new QTableWidgetItem(formatDateForDisplay(record["issue_date"].toString())));
-        historyTable->setItem(i, 8, new QTableWidgetItem(record["comments"].toString()));
-    }
-
-    historyTable->resizeColumnsToContents();
-
-    layout->addWidget(historyTable);
-
-    // Кнопки
-    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, &historyDialog);
-    layout->addWidget(buttonBox);
-
-    connect(buttonBox, &QDialogButtonBox::rejected, &historyDialog, &QDialog::reject);
-
+    // История загружается страницами, общее число - по счетчику или индексу фильтра
+    WriteOffHistoryDialog historyDialog(asyncDb, db->getMaterialTypes(), this);
     historyDialog.exec();
 }
 
@@ -791,19 +750,19 @@ void MainWindow::loadItemForEdit(int itemId)
     qDebug() << "=== loadItemForEdit called ===";
     qDebug() << "Item ID to edit:" << itemId;
 
-    QVariantMap item = db->getInventoryItemById(itemId);
-
-    if (!db->checkInventoryItemExists(itemId)) {
-        QMessageBox::warning(this, "Ошибка", "Запись не найдена");
-        return;
-    }
+    AsyncDatabase::watch(asyncDb->getInventoryItemById(itemId), this, [this, itemId](const QVariantMap &item) {
+        if (item.isEmpty()) {
+            QMessageBox::warning(this, "Ошибка", "Запись не найдена");
+            qDebug() << "Failed to load item for editing";
+            return;
+        }
 
-    if (item.isEmpty()) {
-        QMessageBox::warning(this, "Ошибка", "Не удалось загрузить данные для редактирования");
-        qDebug() << "Failed to load item for editing";
-        return;
-    }
+        fillEditForm(itemId, item);
+    });
+}
 
+void MainWindow::fillEditForm(int itemId, const QVariantMap &item)
+{
     currentEditId = itemId;
 
     ui->materialTypeCombo->setCurrentText(item["material_type"].toString());
@@ -896,25 +855,27 @@ void MainWindow::onAddItem()
         return;
     }
 
-    // Добавляем в справочники
-    db->addMaterialType(materialType);
-    db->addManufacturer(manufacturer);
-    db->addModel(materialType, manufacturer, modelName);
-
-    // Добавляем запись (теперь серийный номер может быть пустым)
-    if (db->addInventoryItem(materialType, manufacturer, modelName, partNumber,
-                             serialNumber, capacity, interfaceType, notes,
-                             arrivalDate, invoiceNumber)) {
-        QMessageBox::information(this, "Успех", "Позиция успешно добавлена");
-
-        refreshCompleters();
-        loadMaterialsTree();
-        loadInventoryTable();
-        clearForm();
-    } else {
-        QMessageBox::critical(this, "Ошибка",
-            "Не удалось добавить позицию. Возможно, серийный номер уже существует.");
-    }
+    // Справочники пополняются в той же задаче рабочего потока, что и запись
+    // (теперь серийный номер может быть пустым). До ответа повторно добавить нельзя
+    ui->addButton->setEnabled(false);
+    AsyncDatabase::watch(asyncDb->addInventoryItem(materialType, manufacturer, modelName, partNumber,
+                                                   serialNumber, capacity, interfaceType, notes,
+                                                   arrivalDate, invoiceNumber),
+                         this, [this](bool success) {
+        ui->addButton->setEnabled(currentEditId <= 0);
+
+        if (success) {
+            QMessageBox::information(this, "Успех", "Позиция успешно добавлена");
+
+            // Дерево обновится по сигналу inventoryItemsAdded. Кэш справочников
+            // уже перечитан по dataModified - он приходит раньше результата задачи
+            refreshCompleters();
+            clearForm();
+        } else {
+            QMessageBox::critical(this, "Ошибка",
+                "Не удалось добавить позицию. Возможно, серийный номер уже существует.");
+        }
+    });
 }
 
 void MainWindow::onUpdateItem()
@@ -957,36 +918,39 @@ void MainWindow::onUpdateItem()
     }
 
     // Обновляем запись (serialNumber может быть пустым)
-    if (db->updateInventoryItem(currentEditId, materialType, manufacturer, modelName,
-                               partNumber, serialNumber, capacity, interfaceType,
-                               notes, arrivalDate, invoiceNumber)) {
-        QMessageBox::information(this, "Успех", "Позиция успешно обновлена");
-        qDebug() << "Update successful!";
-
-        refreshCompleters();
-        loadMaterialsTree();
-        loadInventoryTable();
-        clearForm();
-        setEditMode(false);
-    } else {
-        QMessageBox::critical(this, "Ошибка", "Не удалось обновить позицию");
-        qDebug() << "Update failed!";
-    }
+    ui->updateButton->setEnabled(false);
+    AsyncDatabase::watch(asyncDb->updateInventoryItem(currentEditId, materialType, manufacturer, modelName,
+                                                      partNumber, serialNumber, capacity, interfaceType,
+                                                      notes, arrivalDate, invoiceNumber),
+                         this, [this](bool success) {
+        if (success) {
+            QMessageBox::information(this, "Успех", "Позиция успешно обновлена");
+            qDebug() << "Update successful!";
+
+            refreshCompleters();
+            loadMaterialsTree();
+            clearForm();
+            setEditMode(false);
+        } else {
+            ui->updateButton->setEnabled(currentEditId > 0);
+            QMessageBox::critical(this, "Ошибка", "Не удалось обновить позицию");
+            qDebug() << "Update failed!";
+        }
+    });
 }
 
 void MainWindow::onDeleteItem()
 {
-    QList<QTableWidgetItem*> selectedItems = ui->inventoryTable->selectedItems();
-    if (selectedItems.isEmpty()) {
+    if (!ui->inventoryTable->selectionModel()->hasSelection()) {
         QMessageBox::warning(this, "Внимание", "Выберите запись для удаления");
         return;
     }
 
-    int row = ui->inventoryTable->currentRow();
+    int row = ui->inventoryTable->currentIndex().row();
     if (row < 0) return;
 
-    int itemId = ui->inventoryTable->item(row, 0)->text().toInt();
-    QString serialNumber = ui->inventoryTable->item(row, 5)->text();
+    int itemId = inventoryModel->itemId(row);
+    QString serialNumber = inventoryModel->serialNumber(row);
 
     QMessageBox::StandardButton reply = QMessageBox::question(
         this, "Подтверждение удаления",
@@ -995,15 +959,16 @@ void MainWindow::onDeleteItem()
     );
 
     if (reply == QMessageBox::Yes) {
-        if (db->deleteInventoryItem(itemId)) {
-            QMessageBox::information(this, "Успех", "Запись успешно удалена");
-            loadInventoryTable();
-            ui->editButton->setEnabled(false);
-            ui->deleteButton->setEnabled(false);
-            dashboardWidget->refreshStats();
-        } else {
-            QMessageBox::critical(this, "Ошибка", "Не удалось удалить запись");
-        }
+        AsyncDatabase::watch(asyncDb->deleteInventoryItem(itemId), this, [this](bool success) {
+            if (success) {
+                QMessageBox::information(this, "Успех", "Запись успешно удалена");
+                ui->editButton->setEnabled(false);
+                ui->deleteButton->setEnabled(false);
+                dashboardWidget->refreshStats();
+            } else {
+                QMessageBox::critical(this, "Ошибка", "Не удалось удалить запись");
+            }
+        });
     }
 }
 
@@ -1015,27 +980,22 @@ void MainWindow::onCancelEdit()
 
 void MainWindow::onEditItem()
 {
-    QList<QTableWidgetItem*> selectedItems = ui->inventoryTable->selectedItems();
-    if (selectedItems.isEmpty()) {
+    if (!ui->inventoryTable->selectionModel()->hasSelection()) {
         QMessageBox::warning(this, "Внимание", "Выберите запись для редактирования");
         return;
     }
 
-    int row = ui->inventoryTable->currentRow();
+    int row = ui->inventoryTable->currentIndex().row();
     if (row < 0) return;
 
-    int itemId = ui->inventoryTable->item(row, 0)->text().toInt();
+    int itemId = inventoryModel->itemId(row);
     loadItemForEdit(itemId);
 }
 
 void MainWindow::onSearchTextChanged(const QString &text)
 {
-    if (text.isEmpty()) {
-        loadInventoryTable();
-    } else {
-        QList<QVariantMap> searchResults = db->searchInventory(text);
-        loadInventoryTable(searchResults);
-    }
+    // Запрос уходит после паузы в наборе, продолжение найденного текста сужает результат на месте
+    inventorySearch->setText(text);
 }
 
 void MainWindow::onMaterialTypeChanged(const QString &text)
@@ -1078,7 +1038,7 @@ void MainWindow::onManufacturerChanged(const QString &text)
 
 void MainWindow::onTableSelectionChanged()
 {
-    bool hasSelection = !ui->inventoryTable->selectedItems().isEmpty();
+    bool hasSelection = ui->inventoryTable->selectionModel()->hasSelection();
     ui->editButton->setEnabled(hasSelection);
     ui->deleteButton->setEnabled(hasSelection);
 }
@@ -1108,11 +1068,28 @@ void MainWindow::onGenerateReport()
                                                    reportTypes, 0, false, &ok);
         if (!ok) return;
 
+        file.close();
+
         if (reportType == "История списаний") {
             exportWriteOffHistory(fileName);
             return;
         }
 
+    // Выборка выполняется в рабочем потоке, файл пишется по готовности
+    AsyncDatabase::watch(asyncDb->getInventoryItems(ReportRequest), this,
+                         [this, fileName](const QList<QVariantMap> &items) {
+        writeInventoryReport(fileName, items);
+    });
+}
+
+void MainWindow::writeInventoryReport(const QString &fileName, const QList<QVariantMap> &items)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось создать файл");
+        return;
+    }
+
     QTextStream stream(&file);
     #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
         stream.setEncoding(QStringConverter::Utf8);
@@ -1124,7 +1101,6 @@ void MainWindow::onGenerateReport()
     stream << "ID;Тип;Производитель;Модель;Part Number;Серийный номер;Объем;Интерфейс;Дата прихода;Накладная;Примечание";
 
     // Добавляем дополнительные поля если они есть
-    QList<QVariantMap> items = db->getInventoryItems();
     if (!items.isEmpty() && items.first().contains("created_at")) {
         stream << ";Создано";
     }
@@ -1165,55 +1141,54 @@ void MainWindow::onGenerateReport()
 
 void MainWindow::exportWriteOffHistory(const QString &fileName)
 {
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(this, "Ошибка", "Не удалось создать файл");
-        return;
-    }
-
-    QTextStream stream(&file);
-    #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        stream.setEncoding(QStringConverter::Utf8);
-    #else
-        stream.setCodec("UTF-8");
-    #endif
+    // Выборка выполняется в рабочем потоке, файл пишется по готовности
+    AsyncDatabase::watch(asyncDb->getWriteOffHistory(-1, ReportRequest), this,
+                         [this, fileName](const QList<QVariantMap> &history) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            QMessageBox::critical(this, "Ошибка", "Не удалось создать файл");
+            return;
+        }
 
-    stream << "ID;Тип;Производитель;Модель;Part Number;Серийный номер;"
-           << "Кому выдано;Дата выдачи;Комментарий;Дата списания\n";
-
-    QList<QVariantMap> history = db->getWriteOffHistory();
-    for (const QVariantMap &record : history) {
-        stream << record["id"].toString() << ";"
-               << record["material_type"].toString() << ";"
-               << record["manufacturer"].toString() << ";"
-               << record["model"].toString() << ";"
-               << record["part_number"].toString() << ";"
-               << record["serial_number"].toString() << ";"
-               << record["issued_to"].toString() << ";"
-               << record["issue_date"].toString() << ";"
-               << record["comments"].toString().replace("\n", " ") << ";"
-               << record["created_at"].toString() << "\n";
-    }
+        QTextStream stream(&file);
+        #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+            stream.setEncoding(QStringConverter::Utf8);
+        #else
+            stream.setCodec("UTF-8");
+        #endif
+
+        stream << "ID;Тип;Производитель;Модель;Part Number;Серийный номер;"
+               << "Кому выдано;Дата выдачи;Комментарий;Дата списания\n";
+
+        for (const QVariantMap &record : history) {
+            stream << record["id"].toString() << ";"
+                   << record["material_type"].toString() << ";"
+                   << record["manufacturer"].toString() << ";"
+                   << record["model"].toString() << ";"
+                   << record["part_number"].toString() << ";"
+                   << record["serial_number"].toString() << ";"
+                   << record["issued_to"].toString() << ";"
+                   << record["issue_date"].toString() << ";"
+                   << record["comments"].toString().replace("\n", " ") << ";"
+                   << record["created_at"].toString() << "\n";
+        }
 
-    file.close();
-    QMessageBox::information(this, "Успех",
-        QString("Отчет истории списаний успешно сформирован\nФайл: %1").arg(fileName));
+        file.close();
+        QMessageBox::information(this, "Успех",
+            QString("Отчет истории списаний успешно сформирован\nФайл: %1").arg(fileName));
+    });
 }
 
 void MainWindow::onTreeCustomContextMenu(const QPoint &pos)
 {
-    QTreeWidgetItem* item = ui->materialsTree->itemAt(pos);
+    QModelIndex index = ui->materialsTree->indexAt(pos);
 
-    if (item) {
+    if (index.isValid()) {
         // Не разрешаем удаление корневого элемента "Все материалы"
-        if (item == ui->materialsTree->topLevelItem(0)) {
-            deleteAction->setEnabled(false);
-        } else {
-            deleteAction->setEnabled(true);
-        }
+        deleteAction->setEnabled(materialTreeModel->level(index) != MaterialTreeModel::RootLevel);
 
         // Сохраняем выбранный элемент для использования в слотах
-        contextMenuItem = item;
+        contextMenuIndex = index;
 
         // Показываем меню
         treeContextMenu->exec(ui->materialsTree->viewport()->mapToGlobal(pos));
@@ -1222,32 +1197,64 @@ void MainWindow::onTreeCustomContextMenu(const QPoint &pos)
 
 void MainWindow::onDeleteFromTree()
 {
-    if (!contextMenuItem) return;
+    // Кнопка под деревом удаляет текущий элемент
+    if (!contextMenuIndex.isValid()) {
+        contextMenuIndex = ui->materialsTree->currentIndex();
+    }
+    if (!contextMenuIndex.isValid()) return;
 
     deleteSelectedTreeItem();
 }
 
 void MainWindow::deleteSelectedTreeItem()
 {
-    if (!contextMenuItem) return;
+    if (!contextMenuIndex.isValid()) return;
 
-    QString itemText = contextMenuItem->text(0);
-    QString cleanText = getItemTextWithoutEmoji(itemText);
+    // Узел запоминается до ответа пула чтения: дерево за это время может перестроиться
+    QPersistentModelIndex index = contextMenuIndex;
+    contextMenuIndex = QPersistentModelIndex();
 
-    // Определяем уровень элемента более точно
-    QTreeWidgetItem* parent = contextMenuItem->parent();
-    QTreeWidgetItem* grandParent = parent ? parent->parent() : nullptr;
-    QTreeWidgetItem* greatGrandParent = grandParent ? grandParent->parent() : nullptr;
-
-    bool isModel = (parent && grandParent && greatGrandParent); // Уровень 3 (модель)
-    bool isManufacturer = (parent && grandParent && !greatGrandParent); // Уровень 2 (производитель)
-    bool isMaterialType = (parent && !grandParent); // Уровень 1 (тип материала)
+    // Названия берутся из модели дерева, без разбора отображаемого текста
+    MaterialTreeModel::Level level = materialTreeModel->level(index);
+    QString itemName = index.data(MaterialTreeModel::NameRole).toString();
 
     qDebug() << "=== deleteSelectedTreeItem ===";
-    qDebug() << "Item text:" << itemText;
-    qDebug() << "Clean text:" << cleanText;
-    qDebug() << "Levels: parent=" << parent << " grandParent=" << grandParent << " greatGrandParent=" << greatGrandParent;
-    qDebug() << "isModel:" << isModel << " isManufacturer:" << isManufacturer << " isMaterialType:" << isMaterialType;
+    qDebug() << "Item name:" << itemName << "level:" << level;
+
+    // Число записей, использующих элемент, считается в пуле чтения
+    QFuture<int> usageCount;
+    switch (level) {
+    case MaterialTreeModel::ModelLevel:
+        usageCount = asyncDb->getUsageCountForModel(materialTreeModel->materialType(index),
+                                                    materialTreeModel->manufacturer(index), itemName);
+        break;
+    case MaterialTreeModel::ManufacturerLevel:
+        usageCount = asyncDb->getUsageCountForManufacturer(itemName);
+        break;
+    case MaterialTreeModel::MaterialTypeLevel:
+        usageCount = asyncDb->getUsageCountForMaterialType(itemName);
+        break;
+    default:
+        qDebug() << "Unknown item level or root item selected";
+        QMessageBox::information(this, "Информация", "Нельзя удалить корневой элемент или элемент неизвестного уровня");
+        return;
+    }
+
+    AsyncDatabase::watch(usageCount, this, [this, index](int count) {
+        confirmTreeItemDeletion(index, count);
+    });
+}
+
+void MainWindow::confirmTreeItemDeletion(const QPersistentModelIndex &index, int usageCount)
+{
+    if (!index.isValid()) return;
+
+    MaterialTreeModel::Level level = materialTreeModel->level(index);
+    QString itemName = index.data(MaterialTreeModel::NameRole).toString();
+
+    bool isModel = level == MaterialTreeModel::ModelLevel;
+    bool isManufacturer = level == MaterialTreeModel::ManufacturerLevel;
+    bool isMaterialType = level == MaterialTreeModel::MaterialTypeLevel;
 
     QString message;
     QString details;
@@ -1255,16 +1262,15 @@ void MainWindow::deleteSelectedTreeItem()
 
     if (isModel) {
         // Это модель (3 уровень)
-        QString modelName = cleanText;
-        QString manufacturer = getItemTextWithoutEmoji(parent->text(0));
-        QString materialType = getItemTextWithoutEmoji(grandParent->text(0));
+        QString modelName = itemName;
+        QString manufacturer = materialTreeModel->manufacturer(index);
+        QString materialType = materialTreeModel->materialType(index);
 
         qDebug() << "Model details:";
         qDebug() << "  Model:" << modelName;
         qDebug() << "  Manufacturer:" << manufacturer;
         qDebug() << "  Material type:" << materialType;
 
-        int usageCount = db->getUsageCountForModel(materialType, manufacturer, modelName);
         qDebug() << "Usage count:" << usageCount;
 
         message = QString("Удалить модель '%1'?").arg(modelName);
@@ -1291,13 +1297,17 @@ void MainWindow::deleteSelectedTreeItem()
             );
 
             if (reply == QMessageBox::Yes) {
-                if (db->deleteModel(materialType, manufacturer, modelName)) {
-                    QMessageBox::information(this, "Успех", "Модель успешно удалена");
-                    loadMaterialsTree();
-                    refreshCompleters();
-                } else {
-                    QMessageBox::warning(this, "Ошибка", "Не удалось удалить модель");
-                }
+                AsyncDatabase::watch(asyncDb->deleteModel(materialType, manufacturer, modelName), this,
+                                     [this, index](bool success) {
+                    if (success) {
+                        // Узел убирается из дерева на месте, без перечитывания
+                        materialTreeModel->removeNode(index);
+                        QMessageBox::information(this, "Успех", "Модель успешно удалена");
+                        refreshCompleters();
+                    } else {
+                        QMessageBox::warning(this, "Ошибка", "Не удалось удалить модель");
+                    }
+                });
             }
         } else {
             QMessageBox::information(this, "Невозможно удалить", details);
@@ -1305,14 +1315,13 @@ void MainWindow::deleteSelectedTreeItem()
 
     } else if (isManufacturer) {
         // Это производитель (2 уровень)
-        QString manufacturer = cleanText;
-        QString materialType = getItemTextWithoutEmoji(parent->text(0));
+        QString manufacturer = itemName;
+        QString materialType = materialTreeModel->materialType(index);
 
         qDebug() << "Manufacturer details:";
         qDebug() << "  Manufacturer:" << manufacturer;
         qDebug() << "  Material type:" << materialType;
 
-        int usageCount = db->getUsageCountForManufacturer(manufacturer);
         qDebug() << "Usage count for manufacturer:" << usageCount;
 
         message = QString("Удалить производителя '%1'?").arg(manufacturer);
@@ -1345,13 +1354,15 @@ void MainWindow::deleteSelectedTreeItem()
             );
 
             if (reply == QMessageBox::Yes) {
-                if (db->deleteManufacturer(manufacturer)) {
-                    QMessageBox::information(this, "Успех", "Производитель успешно удален");
-                    loadMaterialsTree();
-                    refreshCompleters();
-                } else {
-                    QMessageBox::warning(this, "Ошибка", "Не удалось удалить производителя");
-                }
+                AsyncDatabase::watch(asyncDb->deleteManufacturer(manufacturer), this, [this](bool success) {
+                    if (success) {
+                        QMessageBox::information(this, "Успех", "Производитель успешно удален");
+                        loadMaterialsTree();
+                        refreshCompleters();
+                    } else {
+                        QMessageBox::warning(this, "Ошибка", "Не удалось удалить производителя");
+                    }
+                });
             }
         } else {
             QMessageBox::information(this, "Невозможно удалить", details);
@@ -1359,12 +1370,11 @@ void MainWindow::deleteSelectedTreeItem()
 
     } else if (isMaterialType) {
         // Это тип материала (1 уровень)
-        QString materialType = cleanText;
+        QString materialType = itemName;
 
         qDebug() << "Material type details:";
         qDebug() << "  Material type:" << materialType;
 
-        int usageCount = db->getUsageCountForMaterialType(materialType);
         qDebug() << "Usage count for material type:" << usageCount;
 
         message = QString("Удалить тип материала '%1'?").arg(materialType);
@@ -1396,23 +1406,21 @@ void MainWindow::deleteSelectedTreeItem()
             );
 
             if (reply == QMessageBox::Yes) {
-                if (db->deleteMaterialType(materialType)) {
-                    QMessageBox::information(this, "Успех", "Тип материала успешно удален");
-                    loadMaterialsTree();
-                    refreshCompleters();
-                } else {
-                    QMessageBox::warning(this, "Ошибка", "Не удалось удалить тип материала");
-                }
+                AsyncDatabase::watch(asyncDb->deleteMaterialType(materialType), this,
+                                     [this, index](bool success) {
+                    if (success) {
+                        materialTreeModel->removeNode(index);
+                        QMessageBox::information(this, "Успех", "Тип материала успешно удален");
+                        refreshCompleters();
+                    } else {
+                        QMessageBox::warning(this, "Ошибка", "Не удалось удалить тип материала");
+                    }
+                });
             }
         } else {
             QMessageBox::information(this, "Невозможно удалить", details);
         }
-    } else {
-        qDebug() << "Unknown item level or root item selected";
-        QMessageBox::information(this, "Информация", "Нельзя удалить корневой элемент или элемент неизвестного уровня");
     }
-
-    contextMenuItem = nullptr;
 }
 
 void MainWindow::onRefreshTree()
@@ -1421,55 +1429,22 @@ void MainWindow::onRefreshTree()
     QMessageBox::information(this, "Обновление", "Дерево материалов обновлено");
 }
 
-QString MainWindow::getItemTextWithoutEmoji(const QString &textWithEmoji)
-{
-    // Удаляем эмодзи и пробел в начале
-    // Эмодзи могут занимать 2 символа (некоторые 4)
-    QString result = textWithEmoji;
-
-    // Удаляем первый символ (эмодзи) и пробел, если они есть
-    if (!result.isEmpty()) {
-        // Проверяем, есть ли пробел после эмодзи
-        for (int i = 0; i < result.length() - 1; i++) {
-            if (result[i] == ' ') {
-                // Если нашли пробел, возвращаем все после него
-                return result.mid(i + 1);
-            }
-        }
-    }
-
-    return result;
-}
-
-void MainWindow::onTreeItemClicked(QTreeWidgetItem *item, int column)
+void MainWindow::onTreeItemClicked(const QModelIndex &index)
 {
-    Q_UNUSED(column);
-
-    if (!item) return;
+    if (!index.isValid()) return;
 
-    if (item == ui->materialsTree->topLevelItem(0)) {
+    MaterialTreeModel::Level level = materialTreeModel->level(index);
+    if (level == MaterialTreeModel::RootLevel) {
         return;
     }
 
-    if (item->parent() && item->parent()->parent() && item->parent()->parent()->parent()) {
-        QString modelName = getItemTextWithoutEmoji(item->text(0));
-        QString manufacturer = getItemTextWithoutEmoji(item->parent()->text(0));
-        QString materialType = getItemTextWithoutEmoji(item->parent()->parent()->text(0));
-
-        ui->materialTypeCombo->setCurrentText(materialType);
-        ui->manufacturerCombo->setCurrentText(manufacturer);
-        ui->modelCombo->setCurrentText(modelName);
-    }
-    else if (item->parent() && item->parent()->parent()) {
-        QString manufacturer = getItemTextWithoutEmoji(item->text(0));
-        QString materialType = getItemTextWithoutEmoji(item->parent()->text(0));
-
-        ui->materialTypeCombo->setCurrentText(materialType);
-        ui->manufacturerCombo->setCurrentText(manufacturer);
+    // Форма заполняется значениями узла и его родителей
+    ui->materialTypeCombo->setCurrentText(materialTreeModel->materialType(index));
+    if (level == MaterialTreeModel::ManufacturerLevel || level == MaterialTreeModel::ModelLevel) {
+        ui->manufacturerCombo->setCurrentText(materialTreeModel->manufacturer(index));
     }
-    else if (item->parent()) {
-        QString materialType = getItemTextWithoutEmoji(item->text(0));
-        ui->materialTypeCombo->setCurrentText(materialType);
+    if (level == MaterialTreeModel::ModelLevel) {
+        ui->modelCombo->setCurrentText(materialTreeModel->model(index));
     }
 }
 
@@ -1509,68 +1484,48 @@ void MainWindow::setupSortMenu()
 
 void MainWindow::onSortByDateDesc()
 {
-    ui->inventoryTable->sortItems(8, Qt::DescendingOrder); // Колонка 8 - дата прихода
+    ui->inventoryTable->sortByColumn(InventoryTableModel::ArrivalDateColumn, Qt::DescendingOrder);
     ui->sortButton->setText("📊 Сортировка: по дате ▼");
 }
 
 void MainWindow::onSortByDateAsc()
 {
-    ui->inventoryTable->sortItems(8, Qt::AscendingOrder);
+    ui->inventoryTable->sortByColumn(InventoryTableModel::ArrivalDateColumn, Qt::AscendingOrder);
     ui->sortButton->setText("📊 Сортировка: по дате ▲");
 }
 
 void MainWindow::onSortByType()
 {
-    ui->inventoryTable->sortItems(1, Qt::AscendingOrder); // Колонка 1 - тип
+    ui->inventoryTable->sortByColumn(InventoryTableModel::MaterialTypeColumn, Qt::AscendingOrder);
     ui->sortButton->setText("📊 Сортировка: по типу");
 }
 
 void MainWindow::onSortByManufacturer()
 {
-    ui->inventoryTable->sortItems(2, Qt::AscendingOrder); // Колонка 2 - производитель
+    ui->inventoryTable->sortByColumn(InventoryTableModel::ManufacturerColumn, Qt::AscendingOrder);
     ui->sortButton->setText("📊 Сортировка: по производителю");
 }
 
 void MainWindow::onSortByModel()
 {
-    ui->inventoryTable->sortItems(3, Qt::AscendingOrder); // Колонка 3 - модель
+    ui->inventoryTable->sortByColumn(InventoryTableModel::ModelColumn, Qt::AscendingOrder);
     ui->sortButton->setText("📊 Сортировка: по модели");
 }
 
 void MainWindow::onSortBySerial()
 {
-    ui->inventoryTable->sortItems(5, Qt::AscendingOrder); // Колонка 5 - серийный номер
+    ui->inventoryTable->sortByColumn(InventoryTableModel::SerialNumberColumn, Qt::AscendingOrder);
     ui->sortButton->setText("📊 Сортировка: по серийному номеру");
 }
 
 void MainWindow::onPrintLabels()
 {
     // Получаем выбранные элементы
-    QList<int> selectedIds;
-    QList<QTableWidgetItem*> selectedItems = ui->inventoryTable->selectedItems();
-
-    if (selectedItems.isEmpty()) {
-        // Если ничего не выбрано, печатаем все видимые
-        for (int row = 0; row < ui->inventoryTable->rowCount(); ++row) {
-            bool ok;
-            int id = ui->inventoryTable->item(row, 0)->text().toInt(&ok);
-            if (ok) {
-                selectedIds.append(id);
-            }
-        }
-    } else {
-        // Печатаем только выбранные
-        QSet<int> rows;
-        for (QTableWidgetItem *item : selectedItems) {
-            rows.insert(item->row());
-        }
-        for (int row : rows) {
-            bool ok;
-            int id = ui->inventoryTable->item(row, 0)->text().toInt(&ok);
-            if (ok) {
-                selectedIds.append(id);
-            }
-        }
+    QList<int> selectedIds = selectedItemIds();
+
+    if (selectedIds.isEmpty()) {
+        // Если ничего не выбрано, печатаем все загруженные
+        selectedIds = inventoryModel->itemIds();
     }
 
     if (selectedIds.isEmpty()) {
@@ -1578,17 +1533,17 @@ void MainWindow::onPrintLabels()
         return;
     }
 
-    // Получаем данные из БД
-    QList<QVariantMap> items = db->getItemsForLabels(selectedIds);
-
-    if (items.isEmpty()) {
-        QMessageBox::warning(this, "Ошибка", "Не удалось загрузить данные для печати");
-        return;
-    }
+    // Данные для этикеток читаются в пуле чтения
+    AsyncDatabase::watch(asyncDb->getItemsForLabels(selectedIds), this, [this](const QList<QVariantMap> &items) {
+        if (items.isEmpty()) {
+            QMessageBox::warning(this, "Ошибка", "Не удалось загрузить данные для печати");
+            return;
+        }
 
-    // Показываем диалог печати
-    LabelPrintDialog dialog(items, this);
-    dialog.exec();
+        // Показываем диалог печати
+        LabelPrintDialog dialog(items, this);
+        dialog.exec();
+    });
 }
 
 void MainWindow::onAdvancedFilter()
@@ -1670,20 +1625,22 @@ void MainWindow::onAdvancedFilter()
         qDebug() << "dateFrom:" << params.dateFrom.toString("dd.MM.yyyy");
         qDebug() << "dateTo:" << params.dateTo.toString("dd.MM.yyyy");
 
-        // Применяем фильтр
-        QList<QVariantMap> filteredItems = db->getFilteredInventory(
-            params.materialType,
-            params.manufacturer,
-            params.model,
-            params.partNumber,
-            params.serialNumber,
-            params.status,
-            params.useDateRange ? params.dateFrom : QDate(),
-            params.useDateRange ? params.dateTo : QDate()
-        );
-
-        qDebug() << "Filtered items count:" << filteredItems.size();
-        loadInventoryTable(filteredItems);
+        // Применяем фильтр: запрос под ключом таблицы отменяет ожидающую загрузку или поиск
+        Database::InventoryFilter filter;
+        filter.materialType = params.materialType;
+        filter.manufacturer = params.manufacturer;
+        filter.model = params.model;
+        filter.partNumber = params.partNumber;
+        filter.serialNumber = params.serialNumber;
+        filter.status = params.status;
+        filter.dateFrom = params.useDateRange ? params.dateFrom : QDate();
+        filter.dateTo = params.useDateRange ? params.dateTo : QDate();
+
+        AsyncDatabase::watch(asyncDb->getFilteredInventory(filter, InventoryTableRequest), this,
+                             [this, filter](const QList<QVariantMap> &filteredItems) {
+            qDebug() << "Filtered items count:" << filteredItems.size();
+            loadInventoryTable(filteredItems, filter);
+        });
 
         // Показываем индикатор активного фильтра
         if (!params.materialType.isEmpty() || !params.manufacturer.isEmpty() ||
@@ -1708,6 +1665,132 @@ void MainWindow::refreshStats()
 }
 
 
+void MainWindow::onMassEditItems()
+{
+    QList<int> itemIds = selectedItemIds();
+    if (itemIds.isEmpty()) {
+        QMessageBox::warning(this, "Внимание", "Выберите записи для редактирования");
+        return;
+    }
+
+    QStringList interfaces;
+    for (int i = 0; i < ui->interfaceCombo->count(); ++i) {
+        interfaces << ui->interfaceCombo->itemText(i);
+    }
+
+    MassEditDialog dialog(itemIds.size(), interfaces, this);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+
+    Database::InventoryFields fields = dialog.fields();
+    Database::InventoryRow values = dialog.values();
+
+    AsyncDatabase::watch(asyncDb->updateInventoryItems(itemIds, fields, values), this,
+                         [this, itemIds](bool success) {
+        if (!success) {
+            QMessageBox::critical(this, "Ошибка", "Не удалось изменить записи");
+            return;
+        }
+
+        // Строки таблицы обновляет модель по уведомлению об изменении
+        statusBar()->showMessage(QString("Изменено записей: %1").arg(itemIds.size()), 5000);
+    });
+}
+
+void MainWindow::onImportInventory()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, "Импорт поставки", QString(),
+                                                    "CSV Files (*.csv);;Text Files (*.txt)");
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    ui->importButton->setEnabled(false);
+    statusBar()->showMessage("Импорт: " + fileName);
+
+    AsyncDatabase::watch(asyncDb->importCsv(fileName), this,
+                         [this](const InventoryImporter::Report &report) {
+        ui->importButton->setEnabled(true);
+        statusBar()->clearMessage();
+
+        if (!report.fatalError.isEmpty()) {
+            QMessageBox::critical(this, "Ошибка импорта", report.fatalError);
+            return;
+        }
+
+        // Справочники обновляются по сигналу dataModified и здесь. Пакетный импорт
+        // уведомлений по записям не дает - таблица перечитывается целиком
+        refreshCompleters();
+        loadMaterialsTree();
+        loadInventoryTable();
+
+        QString message = QString("Загружено записей: %1\nПропущено: %2\nВремя: %3 с")
+                              .arg(report.imported)
+                              .arg(report.failed)
+                              .arg(report.elapsedMs / 1000.0, 0, 'f', 1);
+
+        if (report.errors.isEmpty()) {
+            QMessageBox::information(this, "Импорт завершен", message);
+            return;
+        }
+
+        QMessageBox box(QMessageBox::Warning, "Импорт завершен", message, QMessageBox::Ok, this);
+        box.setDetailedText(report.errors.join("\n"));
+        box.exec();
+    });
+}
+
+void MainWindow::setupStorageProfileMenu()
+{
+    QMenu *profileMenu = ui->menu->addMenu("Профиль хранилища");
+    QActionGroup *profileGroup = new QActionGroup(this);
+
+    // bulk-load включается только на время импорта и в меню не предлагается
+    const QList<QPair<Database::StorageProfile, QString>> profiles = {
+        {Database::DesktopSafeProfile, "Обычный (desktop-safe)"},
+        {Database::ReadMostlyProfile, "Только просмотр (read-mostly)"}
+    };
+
+    Database::StorageProfile current = Database::configuredStorageProfile();
+    for (const auto &profile : profiles) {
+        QAction *action = profileMenu->addAction(profile.second);
+        action->setCheckable(true);
+        action->setChecked(profile.first == current);
+        profileGroup->addAction(action);
+
+        Database::StorageProfile value = profile.first;
+        connect(action, &QAction::triggered, this, [this, value]() {
+            // Новые соединения берут профиль из настроек, открытые переключаются:
+            // основное - сразу, рабочее и соединения чтения - через asyncDb
+            Database::setConfiguredStorageProfile(value);
+            bool applied = db->applyStorageProfile(value);
+            AsyncDatabase::watch(asyncDb->applyStorageProfile(value), this, [this, applied](bool success) {
+                if (!applied || !success) {
+                    QMessageBox::warning(this, "Ошибка", "Не удалось применить профиль хранилища");
+                }
+            });
+        });
+    }
+}
+
+void MainWindow::setupMaintenanceMenu()
+{
+    QAction *checkStatsAction = ui->menu->addAction("Проверить счетчики статистики");
+    connect(checkStatsAction, &QAction::triggered, this, [this]() {
+        statusBar()->showMessage("Проверка счетчиков статистики...");
+        AsyncDatabase::watch(asyncDb->checkInventoryStats(), this, [this](bool success) {
+            if (!success) {
+                statusBar()->clearMessage();
+                QMessageBox::warning(this, "Ошибка", "Не удалось пересчитать счетчики статистики");
+                return;
+            }
+            statusBar()->showMessage("Счетчики статистики проверены", 5000);
+            dashboardWidget->refreshStats();
+        });
+    });
+}
+
 void MainWindow::about()
 {
     QMessageBox::about(this, "О программе",
@@ -4,10 +4,13 @@
 #include <QMainWindow>
 #include <QCompleter>
 #include <QStandardItemModel>
-#include <QTreeWidgetItem>
+#include <QPersistentModelIndex>
 #include <QMenu>
+#include <QElapsedTimer>
+#include <QSet>
 #include "dashboardwidget.h"
 #include "advancedfilterdialog.h"
+#include "database.h"
 
 
 
@@ -21,6 +24,10 @@ class MainWindow;
 QT_END_NAMESPACE
 
 class Database;
+class AsyncDatabase;
+class InventoryTableModel;
+class InventorySearch;
+class MaterialTreeModel;
 
 class MainWindow : public QMainWindow
 {
@@ -40,7 +47,7 @@ private slots:
     void onMaterialTypeChanged(const QString &text);
     void onManufacturerChanged(const QString &text);
     void onGenerateReport();
-    void onTreeItemClicked(QTreeWidgetItem *item, int column);
+    void onTreeItemClicked(const QModelIndex &index);
     void onTableSelectionChanged();
     void updateInterfaceVisibility();
     void onPrintLabels();
@@ -66,10 +73,13 @@ private slots:
     void refreshStats();
 
     void onAdvancedFilter();
+    void onImportInventory();
+    void onMassEditItems();
 
 private:
     Ui::MainWindow *ui;
-    Database *db;
+    Database *db;           // Создание структуры БД и справочники для форм (из кэша)
+    AsyncDatabase *asyncDb; // Все записи (рабочий поток) и чтение записей инвентаря (пул)
     QCompleter *materialCompleter;
     QCompleter *manufacturerCompleter;
     QCompleter *modelCompleter;
@@ -91,37 +101,64 @@ private:
     QMenu *treeContextMenu;
     QAction *deleteAction;
     QAction *refreshAction;
-    QTreeWidgetItem *contextMenuItem;
+    QPersistentModelIndex contextMenuIndex;
 
     // Для списания
     QMenu *inventoryContextMenu;
     QAction *writeOffAction;
     QAction *returnAction;
     QAction *showHistoryAction;
+    QAction *massEditAction;
     QComboBox *statusFilterCombo;
 
     int currentEditId; // ID редактируемой записи
 
+    // Основной список: модель догружает страницы сама, здесь - только условия выборки
+    InventoryTableModel *inventoryModel;
+    Database::InventoryFilter pageFilter;
+    InventorySearch *inventorySearch;
+
+    // Дерево материалов: один запрос, при повторной загрузке меняются только отличия
+    MaterialTreeModel *materialTreeModel;
+    // Модели, чьи счетчики еще не перечитаны после изменений записей
+    QSet<int> pendingTreeModelIds;
+
+    // Этапы запуска: замер времени до первой возможности работать
+    QElapsedTimer startupTimer;
+    QStringList pendingStartupStages;
+    void startBackgroundLoading();
+    void logStartupStage(const QString &stage);
+    void finishStartupStage(const QString &stage);
+
     void setupUI();
     void setupConnections();
     void loadMaterialsTree();
-    void loadInventoryTable(const QList<QVariantMap> &items = QList<QVariantMap>());
+    void updateMaterialTreeCounts(const QList<int> &modelIds);
+    // filter - условия, по которым получен готовый список items
+    void loadInventoryTable(const QList<QVariantMap> &items = QList<QVariantMap>(),
+                            const Database::InventoryFilter &filter = Database::InventoryFilter());
+    void loadFirstInventoryPage();
+    void showInventoryList(const QList<QVariantMap> &items);
+    void writeInventoryReport(const QString &fileName, const QList<QVariantMap> &items);
     void refreshCompleters();
     void clearForm();
     void setEditMode(bool editMode);
     void loadItemForEdit(int itemId);
+    void fillEditForm(int itemId, const QVariantMap &item);
     void setupSortMenu();
+    void setupStorageProfileMenu();
+    void setupMaintenanceMenu();
     QString formatDateForDisplay(const QString &dbDate);
 
     // Вспомогательные методы для списания
     void setupContextMenu();
-    void updateRowAppearance(int row, bool isWrittenOff);
-    void showWriteOffDialog(int itemId);
-    int findRowByItemId(int itemId);
+    // item - данные позиции, если выбрана одна
+    void showWriteOffDialog(const QList<int> &itemIds, const QVariantMap &item);
+    QList<int> selectedItemIds() const;
     void exportWriteOffHistory(const QString &fileName);
 
     // Новые вспомогательные методы
-    QString getItemTextWithoutEmoji(const QString &textWithEmoji);
     void deleteSelectedTreeItem();
+    void confirmTreeItemDeletion(const QPersistentModelIndex &index, int usageCount);
 };
 #endif // MAINWINDOW_H
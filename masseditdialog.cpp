@@ -0,0 +1,126 @@
+#include "masseditdialog.h"
+#include <QVBoxLayout>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QLabel>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QDateEdit>
+#include <QTextEdit>
+#include <QDialogButtonBox>
+#include <QPushButton>
+
+MassEditDialog::MassEditDialog(int itemCount, const QStringList &interfaces, QWidget *parent)
+    : QDialog(parent),
+      partNumberCheck(nullptr),
+      partNumberEdit(nullptr),
+      capacityCheck(nullptr),
+      capacityEdit(nullptr),
+      interfaceCheck(nullptr),
+      interfaceCombo(nullptr),
+      arrivalDateCheck(nullptr),
+      arrivalDateEdit(nullptr),
+      invoiceCheck(nullptr),
+      invoiceEdit(nullptr),
+      notesCheck(nullptr),
+      notesEdit(nullptr)
+{
+    setupUI(itemCount, interfaces);
+}
+
+void MassEditDialog::setupUI(int itemCount, const QStringList &interfaces)
+{
+    setWindowTitle("Массовое редактирование");
+    setFixedSize(500, 420);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    QLabel *infoLabel = new QLabel(QString("Выбрано записей: %1\n"
+                                           "Будут изменены только отмеченные поля.").arg(itemCount), this);
+    mainLayout->addWidget(infoLabel);
+
+    QGroupBox *fieldsGroup = new QGroupBox("Новые значения", this);
+    QGridLayout *grid = new QGridLayout(fieldsGroup);
+
+    partNumberEdit = new QLineEdit(this);
+    partNumberCheck = addField(grid, 0, "Part Number:", partNumberEdit);
+
+    capacityEdit = new QLineEdit(this);
+    capacityEdit->setPlaceholderText("Например: 1000 ГБ, 2 ТБ, 512 ГБ");
+    capacityCheck = addField(grid, 1, "Объем:", capacityEdit);
+
+    interfaceCombo = new QComboBox(this);
+    interfaceCombo->setEditable(true);
+    interfaceCombo->addItems(interfaces);
+    interfaceCheck = addField(grid, 2, "Интерфейс:", interfaceCombo);
+
+    arrivalDateEdit = new QDateEdit(QDate::currentDate(), this);
+    arrivalDateEdit->setDisplayFormat("dd.MM.yyyy");
+    arrivalDateEdit->setCalendarPopup(true);
+    arrivalDateCheck = addField(grid, 3, "Дата прихода:", arrivalDateEdit);
+
+    invoiceEdit = new QLineEdit(this);
+    invoiceEdit->setPlaceholderText("Номер документа прихода");
+    invoiceCheck = addField(grid, 4, "Накладная:", invoiceEdit);
+
+    notesEdit = new QTextEdit(this);
+    notesEdit->setMaximumHeight(60);
+    notesCheck = addField(grid, 5, "Примечание:", notesEdit);
+
+    mainLayout->addWidget(fieldsGroup);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    QPushButton *okButton = buttonBox->button(QDialogButtonBox::Ok);
+    okButton->setText("Применить");
+    okButton->setEnabled(false);
+    buttonBox->button(QDialogButtonBox::Cancel)->setText("Отмена");
+    mainLayout->addWidget(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    // Применить можно, только если отмечено хотя бы одно поле
+    const QList<QCheckBox*> checks = {partNumberCheck, capacityCheck, interfaceCheck,
+                                      arrivalDateCheck, invoiceCheck, notesCheck};
+    for (QCheckBox *check : checks) {
+        connect(check, &QCheckBox::toggled, this, [this, okButton]() {
+            okButton->setEnabled(fields() != Database::InventoryFields());
+        });
+    }
+}
+
+QCheckBox *MassEditDialog::addField(QGridLayout *layout, int row, const QString &title, QWidget *editor)
+{
+    QCheckBox *check = new QCheckBox(title, this);
+    editor->setEnabled(false);
+    connect(check, &QCheckBox::toggled, editor, &QWidget::setEnabled);
+
+    layout->addWidget(check, row, 0, Qt::AlignTop);
+    layout->addWidget(editor, row, 1);
+    return check;
+}
+
+Database::InventoryFields MassEditDialog::fields() const
+{
+    Database::InventoryFields result;
+    if (partNumberCheck->isChecked()) result |= Database::PartNumberField;
+    if (capacityCheck->isChecked()) result |= Database::CapacityField;
+    if (interfaceCheck->isChecked()) result |= Database::InterfaceTypeField;
+    if (arrivalDateCheck->isChecked()) result |= Database::ArrivalDateField;
+    if (invoiceCheck->isChecked()) result |= Database::InvoiceNumberField;
+    if (notesCheck->isChecked()) result |= Database::NotesField;
+    return result;
+}
+
+Database::InventoryRow MassEditDialog::values() const
+{
+    Database::InventoryRow row;
+    row.partNumber = partNumberEdit->text().trimmed();
+    row.capacity = capacityEdit->text().trimmed();
+    row.interfaceType = interfaceCombo->currentText().trimmed();
+    row.arrivalDate = arrivalDateEdit->date();
+    row.invoiceNumber = invoiceEdit->text().trimmed();
+    row.notes = notesEdit->toPlainText().trimmed();
+    return row;
+}
@@ -0,0 +1,44 @@
+#ifndef MASSEDITDIALOG_H
+#define MASSEDITDIALOG_H
+
+#include <QDialog>
+#include <QDate>
+#include "database.h"
+
+class QCheckBox;
+class QComboBox;
+class QLineEdit;
+class QDateEdit;
+class QTextEdit;
+class QGridLayout;
+
+// Массовое редактирование: меняются только отмеченные поля всех выбранных записей
+class MassEditDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    MassEditDialog(int itemCount, const QStringList &interfaces, QWidget *parent = nullptr);
+
+    Database::InventoryFields fields() const;
+    Database::InventoryRow values() const;
+
+private:
+    QCheckBox *partNumberCheck;
+    QLineEdit *partNumberEdit;
+    QCheckBox *capacityCheck;
+    QLineEdit *capacityEdit;
+    QCheckBox *interfaceCheck;
+    QComboBox *interfaceCombo;
+    QCheckBox *arrivalDateCheck;
+    QDateEdit *arrivalDateEdit;
+    QCheckBox *invoiceCheck;
+    QLineEdit *invoiceEdit;
+    QCheckBox *notesCheck;
+    QTextEdit *notesEdit;
+
+    void setupUI(int itemCount, const QStringList &interfaces);
+    QCheckBox *addField(QGridLayout *layout, int row, const QString &title, QWidget *editor);
+};
+
+#endif // MASSEDITDIALOG_H
@@ -0,0 +1,333 @@
+#include "materialtreemodel.h"
+
+MaterialTreeModel::MaterialTreeModel(QObject *parent)
+    : QAbstractItemModel(parent)
+    , invisibleRoot(new Node(RootLevel, QString()))
+{
+    Node *allMaterials = new Node(RootLevel, "Все материалы");
+    allMaterials->parent = invisibleRoot;
+    invisibleRoot->children.append(allMaterials);
+    invisibleRoot->fetched = true;
+}
+
+MaterialTreeModel::~MaterialTreeModel()
+{
+    delete invisibleRoot;
+}
+
+MaterialTreeModel::Node *MaterialTreeModel::buildTree(const QList<Database::MaterialTreeRow> &rows)
+{
+    // Строки отсортированы по типу и производителю - узлы создаются при смене значения
+    Node *allMaterials = new Node(RootLevel, QString());
+    Node *materialNode = nullptr;
+    Node *manufacturerNode = nullptr;
+
+    for (const Database::MaterialTreeRow &row : rows) {
+        if (!materialNode || row.materialType != materialNode->name) {
+            materialNode = new Node(MaterialTypeLevel, row.materialType);
+            materialNode->parent = allMaterials;
+            allMaterials->children.append(materialNode);
+            manufacturerNode = nullptr;
+        }
+
+        if (row.manufacturer.isEmpty() || row.model.isEmpty()) {
+            continue;
+        }
+
+        if (!manufacturerNode || row.manufacturer != manufacturerNode->name) {
+            manufacturerNode = new Node(ManufacturerLevel, row.manufacturer);
+            manufacturerNode->parent = materialNode;
+            materialNode->children.append(manufacturerNode);
+        }
+
+        Node *modelNode = new Node(ModelLevel, row.model);
+        modelNode->itemCount = row.itemCount;
+        modelNode->parent = manufacturerNode;
+        manufacturerNode->children.append(modelNode);
+
+        manufacturerNode->itemCount += row.itemCount;
+        materialNode->itemCount += row.itemCount;
+        allMaterials->itemCount += row.itemCount;
+    }
+
+    return allMaterials;
+}
+
+void MaterialTreeModel::setRows(const QList<Database::MaterialTreeRow> &rows)
+{
+    Node *wanted = buildTree(rows);
+    merge(invisibleRoot->children.first(), wanted);
+    delete wanted;
+}
+
+void MaterialTreeModel::setModelItemCounts(const QList<Database::MaterialTreeRow> &rows)
+{
+    for (const Database::MaterialTreeRow &row : rows) {
+        Node *material = findOrInsertChild(invisibleRoot->children.first(), MaterialTypeLevel, row.materialType);
+        Node *manufacturer = findOrInsertChild(material, ManufacturerLevel, row.manufacturer);
+        Node *model = findOrInsertChild(manufacturer, ModelLevel, row.model);
+        addItemCount(model, row.itemCount - model->itemCount);
+    }
+}
+
+MaterialTreeModel::Node *MaterialTreeModel::findOrInsertChild(Node *parent, Level level, const QString &name)
+{
+    bool found = false;
+    int position = childPosition(parent, name, &found);
+    if (found) {
+        return parent->children.at(position);
+    }
+
+    Node *child = new Node(level, name);
+    insertChild(parent, position, child);
+    return child;
+}
+
+void MaterialTreeModel::merge(Node *current, Node *wanted)
+{
+    setItemCount(current, wanted->itemCount);
+
+    // Узлы, которых больше нет
+    for (int i = current->children.size() - 1; i >= 0; --i) {
+        bool found = false;
+        childPosition(wanted, current->children.at(i)->name, &found);
+        if (!found) {
+            removeChild(current, i);
+        }
+    }
+
+    // Новые узлы забираются из wanted целиком, существующие сливаются рекурсивно
+    for (int i = 0; i < wanted->children.size(); ++i) {
+        Node *wantedChild = wanted->children.at(i);
+        bool found = false;
+        int position = childPosition(current, wantedChild->name, &found);
+
+        if (found) {
+            merge(current->children.at(position), wantedChild);
+        } else {
+            wanted->children[i] = nullptr;
+            insertChild(current, position, wantedChild);
+        }
+    }
+}
+
+int MaterialTreeModel::childPosition(const Node *parent, const QString &name, bool *found)
+{
+    // Дети упорядочены по имени - двоичный поиск
+    int low = 0;
+    int high = parent->children.size();
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (parent->children.at(middle)->name < name) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    *found = low < parent->children.size() && parent->children.at(low)->name == name;
+    return low;
+}
+
+void MaterialTreeModel::insertChild(Node *parent, int position, Node *child)
+{
+    child->parent = parent;
+
+    // Узел без детей показывается раскрываемым сразу, иначе представление не узнает о новом ребенке
+    if (!parent->fetched && parent->children.isEmpty()) {
+        parent->fetched = true;
+    }
+
+    if (parent->fetched) {
+        beginInsertRows(indexForNode(parent), position, position);
+        parent->children.insert(position, child);
+        endInsertRows();
+    } else {
+        parent->children.insert(position, child);
+    }
+}
+
+void MaterialTreeModel::removeChild(Node *parent, int position)
+{
+    if (parent->fetched) {
+        beginRemoveRows(indexForNode(parent), position, position);
+        delete parent->children.takeAt(position);
+        endRemoveRows();
+    } else {
+        delete parent->children.takeAt(position);
+    }
+}
+
+void MaterialTreeModel::setItemCount(Node *node, int itemCount)
+{
+    if (node->itemCount == itemCount) {
+        return;
+    }
+
+    node->itemCount = itemCount;
+    QModelIndex index = indexForNode(node);
+    emit dataChanged(index, index);
+}
+
+void MaterialTreeModel::addItemCount(Node *node, int delta)
+{
+    if (delta == 0) {
+        return;
+    }
+
+    for (Node *ancestor = node; ancestor && ancestor != invisibleRoot; ancestor = ancestor->parent) {
+        setItemCount(ancestor, ancestor->itemCount + delta);
+    }
+}
+
+void MaterialTreeModel::removeNode(const QModelIndex &index)
+{
+    Node *node = nodeFromIndex(index);
+    if (!node || node->level == RootLevel) {
+        return;
+    }
+
+    Node *parent = node->parent;
+    int itemCount = node->itemCount;
+    removeChild(parent, parent->children.indexOf(node));
+
+    // Производитель в дереве существует только ради своих моделей
+    if (parent->level == ManufacturerLevel && parent->children.isEmpty()) {
+        Node *material = parent->parent;
+        removeChild(material, material->children.indexOf(parent));
+        parent = material;
+    }
+
+    addItemCount(parent, -itemCount);
+}
+
+QModelIndex MaterialTreeModel::rootIndex() const
+{
+    return index(0, 0);
+}
+
+MaterialTreeModel::Level MaterialTreeModel::level(const QModelIndex &index) const
+{
+    Node *node = nodeFromIndex(index);
+    return node ? node->level : RootLevel;
+}
+
+QString MaterialTreeModel::nameAtLevel(const QModelIndex &index, Level wanted) const
+{
+    for (Node *node = nodeFromIndex(index); node; node = node->parent) {
+        if (node->level == wanted) {
+            return node->name;
+        }
+    }
+    return QString();
+}
+
+QString MaterialTreeModel::materialType(const QModelIndex &index) const
+{
+    return nameAtLevel(index, MaterialTypeLevel);
+}
+
+QString MaterialTreeModel::manufacturer(const QModelIndex &index) const
+{
+    return nameAtLevel(index, ManufacturerLevel);
+}
+
+QString MaterialTreeModel::model(const QModelIndex &index) const
+{
+    return nameAtLevel(index, ModelLevel);
+}
+
+MaterialTreeModel::Node *MaterialTreeModel::nodeFromIndex(const QModelIndex &index) const
+{
+    return index.isValid() ? static_cast<Node *>(index.internalPointer()) : invisibleRoot;
+}
+
+QModelIndex MaterialTreeModel::indexForNode(Node *node) const
+{
+    if (!node || node == invisibleRoot) {
+        return QModelIndex();
+    }
+    return createIndex(node->parent->children.indexOf(node), 0, node);
+}
+
+QModelIndex MaterialTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    Node *parentNode = nodeFromIndex(parent);
+    if (column != 0 || row < 0 || row >= rowCount(parent)) {
+        return QModelIndex();
+    }
+    return createIndex(row, 0, parentNode->children.at(row));
+}
+
+QModelIndex MaterialTreeModel::parent(const QModelIndex &child) const
+{
+    Node *node = nodeFromIndex(child);
+    if (!child.isValid() || !node->parent) {
+        return QModelIndex();
+    }
+    return indexForNode(node->parent);
+}
+
+int MaterialTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return 0;
+    }
+
+    Node *node = nodeFromIndex(parent);
+    return node->fetched ? node->children.size() : 0;
+}
+
+int MaterialTreeModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return 1;
+}
+
+bool MaterialTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    // Стрелка раскрытия видна до загрузки детей в представление
+    return !nodeFromIndex(parent)->children.isEmpty();
+}
+
+bool MaterialTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    Node *node = nodeFromIndex(parent);
+    return !node->fetched && !node->children.isEmpty();
+}
+
+void MaterialTreeModel::fetchMore(const QModelIndex &parent)
+{
+    Node *node = nodeFromIndex(parent);
+    if (node->fetched || node->children.isEmpty()) {
+        return;
+    }
+
+    beginInsertRows(parent, 0, node->children.size() - 1);
+    node->fetched = true;
+    endInsertRows();
+}
+
+QVariant MaterialTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    const Node *node = nodeFromIndex(index);
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        static const char *const icons[] = {"📦 ", "📁 ", "🏭 ", "📄 "};
+        return QString::fromUtf8(icons[node->level]) + node->name + QString(" (%1)").arg(node->itemCount);
+    }
+    case LevelRole:
+        return node->level;
+    case NameRole:
+        return node->name;
+    case ItemCountRole:
+        return node->itemCount;
+    default:
+        return QVariant();
+    }
+}
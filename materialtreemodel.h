@@ -0,0 +1,93 @@
+#ifndef MATERIALTREEMODEL_H
+#define MATERIALTREEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QVector>
+#include "database.h"
+
+// Дерево "Все материалы" -> тип -> производитель -> модель с числом записей в каждом узле.
+// Строится из одного запроса; дочерние узлы показываются представлению только при
+// раскрытии (canFetchMore/fetchMore). Повторная загрузка не пересоздает дерево:
+// меняются только счетчики, добавленные и исчезнувшие узлы
+class MaterialTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum Level {
+        RootLevel,
+        MaterialTypeLevel,
+        ManufacturerLevel,
+        ModelLevel
+    };
+
+    enum Role {
+        LevelRole = Qt::UserRole + 1,
+        NameRole,
+        ItemCountRole
+    };
+
+    explicit MaterialTreeModel(QObject *parent = nullptr);
+    ~MaterialTreeModel();
+
+    // Строки getMaterialTreeRows, отсортированные по типу, производителю и модели
+    void setRows(const QList<Database::MaterialTreeRow> &rows);
+
+    // Новые счетчики отдельных моделей (getModelItemCounts): узлы выше пересчитываются
+    // по разнице, недостающие узлы пути добавляются
+    void setModelItemCounts(const QList<Database::MaterialTreeRow> &rows);
+
+    // Удаление узла без перечитывания (после удаления из справочника).
+    // Производитель без моделей удаляется вместе с последней моделью
+    void removeNode(const QModelIndex &index);
+
+    QModelIndex rootIndex() const;
+    Level level(const QModelIndex &index) const;
+
+    // Названия по пути к узлу; пустые, если узел выше нужного уровня
+    QString materialType(const QModelIndex &index) const;
+    QString manufacturer(const QModelIndex &index) const;
+    QString model(const QModelIndex &index) const;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    struct Node {
+        Level level;
+        QString name;
+        int itemCount = 0;
+        Node *parent = nullptr;
+        QVector<Node *> children;   // По имени, как в запросе
+        bool fetched = false;       // Дети уже показаны представлению
+
+        Node(Level level, const QString &name) : level(level), name(name) {}
+        ~Node() { qDeleteAll(children); }
+    };
+
+    // Невидимый корень, единственный ребенок - "Все материалы"
+    Node *invisibleRoot;
+
+    Node *nodeFromIndex(const QModelIndex &index) const;
+    QModelIndex indexForNode(Node *node) const;
+    QString nameAtLevel(const QModelIndex &index, Level wanted) const;
+
+    static int childPosition(const Node *parent, const QString &name, bool *found);
+    static Node *buildTree(const QList<Database::MaterialTreeRow> &rows);
+
+    void merge(Node *current, Node *wanted);
+    void insertChild(Node *parent, int position, Node *child);
+    void removeChild(Node *parent, int position);
+    void setItemCount(Node *node, int itemCount);
+    // Счетчик узла и всех его предков меняется на delta
+    void addItemCount(Node *node, int delta);
+    Node *findOrInsertChild(Node *parent, Level level, const QString &name);
+};
+
+#endif // MATERIALTREEMODEL_H
@@ -0,0 +1,26 @@
+#include "statusitemdelegate.h"
+
+StatusItemDelegate::StatusItemDelegate(int statusRole, int markerColumn, QObject *parent)
+    : QStyledItemDelegate(parent)
+    , statusRole(statusRole)
+    , markerColumn(markerColumn)
+    , writtenOffColor(255, 100, 100)
+{
+}
+
+void StatusItemDelegate::initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const
+{
+    QStyledItemDelegate::initStyleOption(option, index);
+
+    if (index.data(statusRole).toString() != "written_off") {
+        return;
+    }
+
+    // Красный перечеркнутый текст для списанных
+    option->font.setStrikeOut(true);
+    option->palette.setColor(QPalette::Text, writtenOffColor);
+
+    if (index.column() == markerColumn) {
+        option->text = QString::fromUtf8("❌ ") + option->text;
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef STATUSITEMDELEGATE_H
+#define STATUSITEMDELEGATE_H
+
+#include <QStyledItemDelegate>
+#include <QColor>
+
+// Оформление строк по статусу записи. Модель отдает чистые значения и статус
+// в отдельной роли; шрифт, цвет и пометка добавляются только при отрисовке
+// видимых ячеек, поэтому загрузка строк ничего на оформление не тратит
+class StatusItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    // statusRole - роль со статусом ("available"/"written_off"),
+    // markerColumn - колонка, в которой списанная запись помечается значком
+    StatusItemDelegate(int statusRole, int markerColumn, QObject *parent = nullptr);
+
+protected:
+    void initStyleOption(QStyleOptionViewItem *option, const QModelIndex &index) const override;
+
+private:
+    int statusRole;
+    int markerColumn;
+    QColor writtenOffColor;
+};
+
+#endif // STATUSITEMDELEGATE_H
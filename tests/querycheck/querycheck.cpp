@@ -0,0 +1,94 @@
+// Проверка планов запросов Database на временной базе с тестовыми данными.
+// Запускается через make check; код возврата 0 - недопустимых сканирований нет
+#include "database.h"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QDebug>
+
+namespace {
+const int sampleItemCount = 5000;
+const int sampleModelCount = 20;
+const int sampleWriteOffCount = 200;
+
+// Данных должно быть достаточно, чтобы планировщик не предпочел сканирование маленькой таблицы
+bool fillSampleData(Database &database)
+{
+    const QStringList types = database.getMaterialTypes();
+    const QStringList manufacturers = database.getManufacturers();
+    if (types.isEmpty() || manufacturers.isEmpty()) {
+        qDebug() << "Query plan check: reference tables are empty";
+        return false;
+    }
+
+    for (int i = 0; i < sampleModelCount; ++i) {
+        database.addModel(types.at(i % types.size()), manufacturers.at(i % manufacturers.size()),
+                          QString("Model %1").arg(i));
+    }
+
+    if (!database.beginBulkInsert()) {
+        return false;
+    }
+
+    QDate firstDate = QDate::currentDate().addYears(-3);
+    for (int i = 0; i < sampleItemCount; ++i) {
+        int modelIndex = i % sampleModelCount;
+
+        Database::InventoryRow row;
+        row.materialType = types.at(modelIndex % types.size());
+        row.manufacturer = manufacturers.at(modelIndex % manufacturers.size());
+        row.model = QString("Model %1").arg(modelIndex);
+        row.partNumber = QString("PN-%1").arg(i % 500);
+        row.serialNumber = QString("SN-%1").arg(i, 6, 10, QChar('0'));
+        row.capacity = "1 ТБ";
+        row.arrivalDate = firstDate.addDays(i % 1000);
+
+        QString error;
+        if (!database.bulkInsertItem(row, error)) {
+            qDebug() << "Query plan check: sample row rejected:" << error;
+        }
+    }
+
+    if (!database.commitBulkInsert()) {
+        return false;
+    }
+
+    QList<int> writtenOff;
+    for (int id = 1; id <= sampleWriteOffCount; ++id) {
+        writtenOff << id * (sampleItemCount / sampleWriteOffCount);
+    }
+    return database.markItemsAsWrittenOff(writtenOff, "Проверка", QDate::currentDate(), QString());
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        out << "Cannot create temporary directory\n";
+        return 1;
+    }
+
+    bool success = false;
+    QStringList report;
+    {
+        Database database("zip_query_plan_check");
+        database.setDatabasePath(tempDir.filePath("zip_inventory.db"));
+
+        if (!database.initDatabase() || !fillSampleData(database)) {
+            out << "Cannot prepare sample database\n";
+            return 1;
+        }
+
+        success = database.checkQueryPlans(report);
+    }
+
+    for (const QString &line : report) {
+        out << line << "\n";
+    }
+    out << (success ? "Query plans OK\n" : "Query plan check FAILED\n");
+    return success ? 0 : 1;
+}
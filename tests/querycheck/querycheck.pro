@@ -0,0 +1,12 @@
+# Планы всех запросов Database; make check завершается ошибкой при недопустимом сканировании
+QT = core sql
+
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle
+
+TARGET = querycheck
+
+include(../../database.pri)
+
+SOURCES += \
+    querycheck.cpp
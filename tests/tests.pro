@@ -0,0 +1,5 @@
+# Проверки слоя данных, запуск: qmake tests/tests.pro && make && make check
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    querycheck
@@ -0,0 +1,145 @@
+#include "writeoffhistorydialog.h"
+#include "writeoffhistorymodel.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QLabel>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QDateEdit>
+#include <QPushButton>
+#include <QTableView>
+#include <QHeaderView>
+#include <QDialogButtonBox>
+
+WriteOffHistoryDialog::WriteOffHistoryDialog(AsyncDatabase *asyncDb, const QStringList &materialTypes,
+                                             QWidget *parent)
+    : QDialog(parent),
+      model(new WriteOffHistoryModel(asyncDb, this)),
+      issuedToEdit(nullptr),
+      materialTypeCombo(nullptr),
+      serialEdit(nullptr),
+      periodCheck(nullptr),
+      dateFromEdit(nullptr),
+      dateToEdit(nullptr),
+      countLabel(nullptr),
+      historyView(nullptr)
+{
+    setupUI(materialTypes);
+
+    connect(model, &WriteOffHistoryModel::totalCountChanged, this, &WriteOffHistoryDialog::onTotalCountChanged);
+
+    applyFilter();
+}
+
+void WriteOffHistoryDialog::setupUI(const QStringList &materialTypes)
+{
+    setWindowTitle("История списаний");
+    resize(900, 600);
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+
+    // Фильтры
+    QGroupBox *filterGroup = new QGroupBox("Фильтр", this);
+    QGridLayout *filterLayout = new QGridLayout(filterGroup);
+
+    issuedToEdit = new QLineEdit(this);
+    issuedToEdit->setPlaceholderText("Начало имени получателя");
+    filterLayout->addWidget(new QLabel("Кому выдано:", this), 0, 0);
+    filterLayout->addWidget(issuedToEdit, 0, 1);
+
+    materialTypeCombo = new QComboBox(this);
+    materialTypeCombo->addItem("Все типы", QString());
+    for (const QString &type : materialTypes) {
+        materialTypeCombo->addItem(type, type);
+    }
+    filterLayout->addWidget(new QLabel("Тип:", this), 0, 2);
+    filterLayout->addWidget(materialTypeCombo, 0, 3);
+
+    serialEdit = new QLineEdit(this);
+    serialEdit->setPlaceholderText("Часть серийного номера");
+    filterLayout->addWidget(new QLabel("Серийный номер:", this), 1, 0);
+    filterLayout->addWidget(serialEdit, 1, 1);
+
+    periodCheck = new QCheckBox("Дата выдачи с", this);
+    dateFromEdit = new QDateEdit(QDate::currentDate().addMonths(-1), this);
+    dateToEdit = new QDateEdit(QDate::currentDate(), this);
+    for (QDateEdit *dateEdit : {dateFromEdit, dateToEdit}) {
+        dateEdit->setDisplayFormat("dd.MM.yyyy");
+        dateEdit->setCalendarPopup(true);
+        dateEdit->setEnabled(false);
+        connect(periodCheck, &QCheckBox::toggled, dateEdit, &QWidget::setEnabled);
+    }
+
+    QHBoxLayout *periodLayout = new QHBoxLayout();
+    periodLayout->addWidget(periodCheck);
+    periodLayout->addWidget(dateFromEdit);
+    periodLayout->addWidget(new QLabel("по", this));
+    periodLayout->addWidget(dateToEdit);
+    periodLayout->addStretch();
+    filterLayout->addLayout(periodLayout, 1, 2, 1, 2);
+
+    QPushButton *applyButton = new QPushButton("Применить", this);
+    QPushButton *resetButton = new QPushButton("Сбросить", this);
+    QHBoxLayout *buttonsLayout = new QHBoxLayout();
+    buttonsLayout->addStretch();
+    buttonsLayout->addWidget(resetButton);
+    buttonsLayout->addWidget(applyButton);
+    filterLayout->addLayout(buttonsLayout, 2, 0, 1, 4);
+
+    mainLayout->addWidget(filterGroup);
+
+    // Таблица истории: порядок задает запрос (новые выдачи первыми), сортировка по колонкам отключена
+    historyView = new QTableView(this);
+    historyView->setModel(model);
+    historyView->setAlternatingRowColors(true);
+    historyView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    historyView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    historyView->verticalHeader()->setVisible(false);
+    historyView->horizontalHeader()->setStretchLastSection(true);
+    mainLayout->addWidget(historyView);
+
+    countLabel = new QLabel(this);
+    mainLayout->addWidget(countLabel);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    mainLayout->addWidget(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(applyButton, &QPushButton::clicked, this, &WriteOffHistoryDialog::applyFilter);
+    connect(issuedToEdit, &QLineEdit::returnPressed, this, &WriteOffHistoryDialog::applyFilter);
+    connect(serialEdit, &QLineEdit::returnPressed, this, &WriteOffHistoryDialog::applyFilter);
+    connect(resetButton, &QPushButton::clicked, this, [this]() {
+        issuedToEdit->clear();
+        serialEdit->clear();
+        materialTypeCombo->setCurrentIndex(0);
+        periodCheck->setChecked(false);
+        applyFilter();
+    });
+}
+
+void WriteOffHistoryDialog::applyFilter()
+{
+    Database::WriteOffFilter filter;
+    filter.issuedTo = issuedToEdit->text().trimmed();
+    filter.materialType = materialTypeCombo->currentData().toString();
+    filter.serialNumber = serialEdit->text().trimmed();
+
+    if (periodCheck->isChecked()) {
+        filter.dateFrom = dateFromEdit->date();
+        filter.dateTo = dateToEdit->date();
+    }
+
+    model->setFilter(filter);
+}
+
+void WriteOffHistoryDialog::onTotalCountChanged(int count)
+{
+    if (count < 0) {
+        countLabel->setText("Подсчет записей...");
+    } else {
+        countLabel->setText(QString("Всего записей: %1").arg(count));
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef WRITEOFFHISTORYDIALOG_H
+#define WRITEOFFHISTORYDIALOG_H
+
+#include <QDialog>
+
+class AsyncDatabase;
+class WriteOffHistoryModel;
+class QLineEdit;
+class QComboBox;
+class QCheckBox;
+class QDateEdit;
+class QLabel;
+class QTableView;
+
+// Просмотр истории списаний с фильтрами; строки подгружаются страницами при прокрутке
+class WriteOffHistoryDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    WriteOffHistoryDialog(AsyncDatabase *asyncDb, const QStringList &materialTypes, QWidget *parent = nullptr);
+
+private slots:
+    void applyFilter();
+    void onTotalCountChanged(int count);
+
+private:
+    WriteOffHistoryModel *model;
+    QLineEdit *issuedToEdit;
+    QComboBox *materialTypeCombo;
+    QLineEdit *serialEdit;
+    QCheckBox *periodCheck;
+    QDateEdit *dateFromEdit;
+    QDateEdit *dateToEdit;
+    QLabel *countLabel;
+    QTableView *historyView;
+
+    void setupUI(const QStringList &materialTypes);
+};
+
+#endif // WRITEOFFHISTORYDIALOG_H
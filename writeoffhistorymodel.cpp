@@ -0,0 +1,146 @@
+#include "writeoffhistorymodel.h"
+#include "asyncdatabase.h"
+
+WriteOffHistoryModel::WriteOffHistoryModel(AsyncDatabase *asyncDb, QObject *parent)
+    : QAbstractTableModel(parent)
+    , asyncDb(asyncDb)
+    , pageRequestPending(false)
+    , total(-1)
+    , filterGeneration(0)
+{
+    // Ключи запросов уникальны для модели: новый запрос отменяет только её же предыдущий
+    QString suffix = QString::number(reinterpret_cast<quintptr>(this), 16);
+    pageRequestKey = "writeOffHistoryPage:" + suffix;
+    countRequestKey = "writeOffHistoryCount:" + suffix;
+}
+
+WriteOffHistoryModel::~WriteOffHistoryModel()
+{
+    asyncDb->cancel(pageRequestKey);
+    asyncDb->cancel(countRequestKey);
+}
+
+void WriteOffHistoryModel::setFilter(const Database::WriteOffFilter &newFilter)
+{
+    beginResetModel();
+    filter = newFilter;
+    records.clear();
+    nextCursor.clear();
+    total = -1;
+    ++filterGeneration;
+    endResetModel();
+
+    emit totalCountChanged(total);
+
+    int generation = filterGeneration;
+    AsyncDatabase::watch(asyncDb->getWriteOffHistoryCount(filter, countRequestKey), this,
+                         [this, generation](int count) {
+        if (generation != filterGeneration) {
+            return;
+        }
+        total = count;
+        emit totalCountChanged(total);
+    });
+
+    requestPage();
+}
+
+int WriteOffHistoryModel::totalCount() const
+{
+    return total;
+}
+
+void WriteOffHistoryModel::requestPage()
+{
+    pageRequestPending = true;
+
+    int generation = filterGeneration;
+    AsyncDatabase::watch(asyncDb->getWriteOffHistoryPage(nextCursor, pageSize, filter, pageRequestKey), this,
+                         [this, generation](const Database::WriteOffPage &page) {
+        if (generation != filterGeneration) {
+            return;
+        }
+
+        pageRequestPending = false;
+        nextCursor = page.nextCursor;
+
+        if (page.records.isEmpty()) {
+            return;
+        }
+
+        beginInsertRows(QModelIndex(), records.size(), records.size() + page.records.size() - 1);
+        records.append(page.records);
+        endInsertRows();
+    });
+}
+
+int WriteOffHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : records.size();
+}
+
+int WriteOffHistoryModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant WriteOffHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= records.size()) {
+        return QVariant();
+    }
+
+    const Database::WriteOffRecord &record = records.at(index.row());
+
+    if (role == Qt::ToolTipRole && index.column() == CommentsColumn) {
+        return record.comments;
+    }
+
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case MaterialTypeColumn:
+        return record.materialType;
+    case ManufacturerColumn:
+        return record.manufacturer;
+    case ModelColumn:
+        return record.model;
+    case PartNumberColumn:
+        return record.partNumber;
+    case SerialNumberColumn:
+        return record.serialNumber;
+    case IssuedToColumn:
+        return record.issuedTo;
+    case IssueDateColumn:
+        return record.issueDate.toString("dd.MM.yyyy");
+    case CommentsColumn:
+        return record.comments;
+    default:
+        return QVariant();
+    }
+}
+
+QVariant WriteOffHistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    static const QStringList headers = {"Тип", "Производитель", "Модель", "Part Number",
+                                        "Серийный номер", "Кому выдано", "Дата выдачи", "Комментарий"};
+    return headers.value(section);
+}
+
+bool WriteOffHistoryModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !pageRequestPending && !nextCursor.isEmpty();
+}
+
+void WriteOffHistoryModel::fetchMore(const QModelIndex &parent)
+{
+    if (canFetchMore(parent)) {
+        requestPage();
+    }
+}
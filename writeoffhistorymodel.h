@@ -0,0 +1,65 @@
+#ifndef WRITEOFFHISTORYMODEL_H
+#define WRITEOFFHISTORYMODEL_H
+
+#include <QAbstractTableModel>
+#include "database.h"
+
+class AsyncDatabase;
+
+// История списаний страницами по мере прокрутки: в памяти только загруженные строки,
+// общее число записей приходит отдельным запросом
+class WriteOffHistoryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        MaterialTypeColumn,
+        ManufacturerColumn,
+        ModelColumn,
+        PartNumberColumn,
+        SerialNumberColumn,
+        IssuedToColumn,
+        IssueDateColumn,
+        CommentsColumn,
+        ColumnCount
+    };
+
+    explicit WriteOffHistoryModel(AsyncDatabase *asyncDb, QObject *parent = nullptr);
+    ~WriteOffHistoryModel();
+
+    // Сбрасывает загруженные строки и запрашивает первую страницу и число записей
+    void setFilter(const Database::WriteOffFilter &filter);
+
+    // -1, пока число записей не получено
+    int totalCount() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+signals:
+    void totalCountChanged(int count);
+
+private:
+    static const int pageSize = 200;
+
+    AsyncDatabase *asyncDb;
+    Database::WriteOffFilter filter;
+    QList<Database::WriteOffRecord> records;
+    QString nextCursor;
+    bool pageRequestPending;
+    int total;
+    // Ответы на запросы по предыдущему фильтру отбрасываются
+    int filterGeneration;
+    QString pageRequestKey;
+    QString countRequestKey;
+
+    void requestPage();
+};
+
+#endif // WRITEOFFHISTORYMODEL_H